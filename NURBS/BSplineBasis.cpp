@@ -388,6 +388,107 @@ void BSplineBasis<Real>::Compute (Real t, unsigned int order, int& minIndex, int
     maxIndex = i;
 }
 //----------------------------------------------------------------------------
+template <typename Real>
+void BSplineBasis<Real>::Compute (Real t, unsigned int order, Workspace& ws) const
+{
+    assertion(order <= 3, "Only derivatives to third order supported\n");
+    assertion(mDegree <= MaxLocalDegree, "Degree too high for local evaluation\n");
+
+    // Column c of the local tables holds basis function k = c + i - d.
+    int i = GetKey(t), d = mDegree, o = i - d;
+    Real (*bd0)[MaxLocalDegree+1] = ws.BD[0];
+    Real (*bd1)[MaxLocalDegree+1] = ws.BD[1];
+    Real (*bd2)[MaxLocalDegree+1] = ws.BD[2];
+    Real (*bd3)[MaxLocalDegree+1] = ws.BD[3];
+
+    bd0[0][d] = (Real)1;
+
+    if (order >= 1)
+    {
+        bd1[0][d] = (Real)0;
+        if (order >= 2)
+        {
+            bd2[0][d] = (Real)0;
+            if (order >= 3)
+            {
+                bd3[0][d] = (Real)0;
+            }
+        }
+    }
+
+    Real n0 = t - mKnot[i], n1 = mKnot[i+1] - t;
+    Real invD0, invD1;
+    int j;
+    for (j = 1; j <= d; j++)
+    {
+        invD0 = ((Real)1)/(mKnot[i+j] - mKnot[i]);
+        invD1 = ((Real)1)/(mKnot[i+1] - mKnot[i-j+1]);
+
+        bd0[j][d] = n0*bd0[j-1][d]*invD0;
+        bd0[j][d-j] = n1*bd0[j-1][d-j+1]*invD1;
+
+        if (order >= 1)
+        {
+            bd1[j][d] = (n0*bd1[j-1][d] + bd0[j-1][d])*invD0;
+            bd1[j][d-j] = (n1*bd1[j-1][d-j+1] - bd0[j-1][d-j+1])*invD1;
+
+            if (order >= 2)
+            {
+                bd2[j][d] = (n0*bd2[j-1][d] + ((Real)2)*bd1[j-1][d])*invD0;
+                bd2[j][d-j] = (n1*bd2[j-1][d-j+1] -
+                    ((Real)2)*bd1[j-1][d-j+1])*invD1;
+
+                if (order >= 3)
+                {
+                    bd3[j][d] = (n0*bd3[j-1][d] +
+                        ((Real)3)*bd2[j-1][d])*invD0;
+                    bd3[j][d-j] = (n1*bd3[j-1][d-j+1] -
+                        ((Real)3)*bd2[j-1][d-j+1])*invD1;
+                }
+            }
+        }
+    }
+
+    for (j = 2; j <= d; ++j)
+    {
+        for (int k = i-j+1; k < i; ++k)
+        {
+            int c = k - o;
+            n0 = t - mKnot[k];
+            n1 = mKnot[k+j+1] - t;
+            invD0 = ((Real)1)/(mKnot[k+j] - mKnot[k]);
+            invD1 = ((Real)1)/(mKnot[k+j+1] - mKnot[k+1]);
+
+            bd0[j][c] = n0*bd0[j-1][c]*invD0 + n1*bd0[j-1][c+1]*invD1;
+
+            if (order >= 1)
+            {
+                bd1[j][c] = (n0*bd1[j-1][c]+bd0[j-1][c])*invD0 +
+                    (n1*bd1[j-1][c+1]-bd0[j-1][c+1])*invD1;
+
+                if (order >= 2)
+                {
+                    bd2[j][c] = (n0*bd2[j-1][c] +
+                        ((Real)2)*bd1[j-1][c])*invD0 +
+                        (n1*bd2[j-1][c+1] - ((Real)2)*bd1[j-1][c+1])*invD1;
+
+                    if (order >= 3)
+                    {
+                        bd3[j][c] = (n0*bd3[j-1][c] +
+                            ((Real)3)*bd2[j-1][c])*invD0 +
+                            (n1*bd3[j-1][c+1] - ((Real)3)*
+                            bd2[j-1][c+1])*invD1;
+                    }
+                }
+            }
+        }
+    }
+
+    ws.minIndex = o;
+    ws.maxIndex = i;
+    ws.degree = d;
+}
+//----------------------------------------------------------------------------
 
 //----------------------------------------------------------------------------
 // Explicit instantiation.
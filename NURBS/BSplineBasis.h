@@ -63,6 +63,24 @@ public:
     // Evaluate basis functions and their derivatives.
     void Compute (Real t, unsigned int order, int& minIndex, int& maxIndex);
 
+    // Caller-owned storage for one evaluation.  Only the d+1 basis functions
+    // that are nonzero at t are kept, indexed relative to minIndex, so the
+    // storage fits on the stack and the basis itself is never written.
+    enum { MaxLocalDegree = 7 };
+    struct Workspace
+    {
+        Real BD[4][MaxLocalDegree+1][MaxLocalDegree+1];  // bd[order][j][i-minIndex]
+        int minIndex, maxIndex, degree;
+
+        Real GetD0 (int i) const { return BD[0][degree][i-minIndex]; }
+        Real GetD1 (int i) const { return BD[1][degree][i-minIndex]; }
+        Real GetD2 (int i) const { return BD[2][degree][i-minIndex]; }
+        Real GetD3 (int i) const { return BD[3][degree][i-minIndex]; }
+    };
+
+    // Same as above but thread-safe: results go to 'ws' instead of mBD0..3.
+    void Compute (Real t, unsigned int order, Workspace& ws) const;
+
 public:
     int Initialize (int numCtrlPoints, int degree, bool open);
 
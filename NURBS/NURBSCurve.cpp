@@ -182,31 +182,14 @@ Real NURBSCurve<Real>::GetKnot (int i) const
 //----------------------------------------------------------------------------
 template <typename Real>
 void NURBSCurve<Real>::Get (Real t, Vector3* pos,
-    Vector3* der1, Vector3* der2, Vector3* der3)
+    Vector3* der1, Vector3* der2, Vector3* der3) const
 {
-    int i, imin, imax;
-    if (der3)
-    {
-        mBasis.Compute(t, 0, imin, imax);
-        mBasis.Compute(t, 1, imin, imax);
-        mBasis.Compute(t, 2, imin, imax);
-        mBasis.Compute(t, 3, imin, imax);
-    }
-    else if (der2)
-    {
-        mBasis.Compute(t, 0, imin, imax);
-        mBasis.Compute(t, 1, imin, imax);
-        mBasis.Compute(t, 2, imin, imax);
-    }
-    else if (der1)
-    {
-        mBasis.Compute(t, 0, imin, imax);
-        mBasis.Compute(t, 1, imin, imax);
-    }
-    else  // pos
-    {
-        mBasis.Compute(t, 0, imin, imax);
-    }
+    unsigned int order = der3 ? 3 : (der2 ? 2 : (der1 ? 1 : 0));
+
+    typename BSplineBasis<Real>::Workspace basis;
+    mBasis.Compute(t, order, basis);
+
+    int i, imin = basis.minIndex, imax = basis.maxIndex;
 
     Real tmp;
 
@@ -215,7 +198,7 @@ void NURBSCurve<Real>::Get (Real t, Vector3* pos,
     Real w = (Real)0;
     for (i = imin; i <= imax; ++i)
     {
-        tmp = mBasis.GetD0(i)*mCtrlWeight[i];
+        tmp = basis.GetD0(i)*mCtrlWeight[i];
         X += tmp*mCtrlPoint[i];
         w += tmp;
     }
@@ -236,7 +219,7 @@ void NURBSCurve<Real>::Get (Real t, Vector3* pos,
     Real wDer1 = (Real)0;
     for (i = imin; i <= imax; ++i)
     {
-        tmp = mBasis.GetD1(i)*mCtrlWeight[i];
+        tmp = basis.GetD1(i)*mCtrlWeight[i];
         XDer1 += tmp*mCtrlPoint[i];
         wDer1 += tmp;
     }
@@ -256,7 +239,7 @@ void NURBSCurve<Real>::Get (Real t, Vector3* pos,
     Real wDer2 = (Real)0;
     for (i = imin; i <= imax; ++i)
     {
-        tmp = mBasis.GetD2(i)*mCtrlWeight[i];
+        tmp = basis.GetD2(i)*mCtrlWeight[i];
         XDer2 += tmp*mCtrlPoint[i];
         wDer2 += tmp;
     }
@@ -276,7 +259,7 @@ void NURBSCurve<Real>::Get (Real t, Vector3* pos,
     Real wDer3 = (Real)0;
     for (i = imin; i <= imax; ++i)
     {
-        tmp = mBasis.GetD3(i)*mCtrlWeight[i];
+        tmp = basis.GetD3(i)*mCtrlWeight[i];
         XDer3 += tmp*mCtrlPoint[i];
         wDer3 += tmp;
     }
@@ -302,6 +285,29 @@ Vector3 NURBSCurve<Real>::GetPosition (Real t)
 }
 //----------------------------------------------------------------------------
 template <typename Real>
+Vector3 NURBSCurve<Real>::GetPosition (Real t) const
+{
+    Vector3 pos;
+    Get(t, &pos, 0, 0, 0);
+    return pos;
+}
+//----------------------------------------------------------------------------
+template <typename Real>
+void NURBSCurve<Real>::GetFrame (Real t, Vector3& position,
+    Vector3& tangent, Vector3& normal, Vector3& binormal) const
+{
+    Vector3 velocity, acceleration;
+    Get(t, &position, &velocity, &acceleration, 0);
+    Real VDotV = dot(velocity,velocity);
+    Real VDotA = dot(velocity,acceleration);
+    normal = VDotV*acceleration - VDotA*velocity;
+    normal.normalize();
+    tangent = velocity;
+    tangent.normalize();
+    binormal = cross(tangent,normal);
+}
+//----------------------------------------------------------------------------
+template <typename Real>
 Vector3 NURBSCurve<Real>::GetFirstDerivative (Real t)
 {
     Vector3 der1;
@@ -109,9 +109,15 @@ public:
     // If you need position and derivatives at the same time, it is more
     // efficient to call these functions.  Pass the addresses of those
     // quantities whose values you want.  You may pass 0 in any argument
-    // whose value you do not want.
+    // whose value you do not want.  Evaluation keeps its basis scratch on
+    // the stack, so one curve can be evaluated from several threads.
     void Get (Real t, Vector3* pos, Vector3* der1,
-        Vector3* der2, Vector3* der3);
+        Vector3* der2, Vector3* der3) const;
+    Vector3 GetPosition (Real t) const;
+
+    // Same frame as Curve::GetFrame from a single basis evaluation.
+    void GetFrame (Real t, Vector3& position, Vector3& tangent,
+        Vector3& normal, Vector3& binormal) const;
 
     // Access the basis function to compute it without control points.  This
     // is useful for least squares fitting of curves.
@@ -385,41 +385,14 @@ Real NURBSRectangle<Real>::GetKnot (int dim, int i) const
 template <typename Real>
 void NURBSRectangle<Real>::Get (Real u, Real v, Vector3* pos,
     Vector3* derU, Vector3* derV, Vector3* derUU,
-    Vector3* derUV, Vector3* derVV)
+    Vector3* derUV, Vector3* derVV) const
 {
-    int iu, iumin, iumax;
-    if (derUU)
-    {
-        mBasis[0].Compute(u, 0, iumin, iumax);
-        mBasis[0].Compute(u, 1, iumin, iumax);
-        mBasis[0].Compute(u, 2, iumin, iumax);
-    }
-    else if (derUV || derU)
-    {
-        mBasis[0].Compute(u, 0, iumin, iumax);
-        mBasis[0].Compute(u, 1, iumin, iumax);
-    }
-    else
-    {
-        mBasis[0].Compute(u, 0, iumin, iumax);
-    }
+    typename BSplineBasis<Real>::Workspace basisU, basisV;
+    mBasis[0].Compute(u, derUU ? 2 : ((derUV || derU) ? 1 : 0), basisU);
+    mBasis[1].Compute(v, derVV ? 2 : ((derUV || derV) ? 1 : 0), basisV);
 
-    int iv, ivmin, ivmax;
-    if (derVV)
-    {
-        mBasis[1].Compute(v, 0, ivmin, ivmax);
-        mBasis[1].Compute(v, 1, ivmin, ivmax);
-        mBasis[1].Compute(v, 2, ivmin, ivmax);
-    }
-    else if (derUV || derV)
-    {
-        mBasis[1].Compute(v, 0, ivmin, ivmax);
-        mBasis[1].Compute(v, 1, ivmin, ivmax);
-    }
-    else
-    {
-        mBasis[1].Compute(v, 0, ivmin, ivmax);
-    }
+    int iu, iumin = basisU.minIndex, iumax = basisU.maxIndex;
+    int iv, ivmin = basisV.minIndex, ivmax = basisV.maxIndex;
 
     Real tmp;
 
@@ -429,7 +402,7 @@ void NURBSRectangle<Real>::Get (Real u, Real v, Vector3* pos,
     {
         for (iv = ivmin; iv <= ivmax; ++iv)
         {
-            tmp = mBasis[0].GetD0(iu)*mBasis[1].GetD0(iv)*mCtrlWeight[iu][iv];
+            tmp = basisU.GetD0(iu)*basisV.GetD0(iv)*mCtrlWeight[iu][iv];
             X += tmp*mCtrlPoint[iu][iv];
             w += tmp;
         }
@@ -458,7 +431,7 @@ void NURBSRectangle<Real>::Get (Real u, Real v, Vector3* pos,
         {
             for (iv = ivmin; iv <= ivmax; ++iv)
             {
-                tmp = mBasis[0].GetD1(iu)*mBasis[1].GetD0(iv)*
+                tmp = basisU.GetD1(iu)*basisV.GetD0(iv)*
                     mCtrlWeight[iu][iv];
                 XDerU += tmp*mCtrlPoint[iu][iv];
                 wDerU += tmp;
@@ -478,7 +451,7 @@ void NURBSRectangle<Real>::Get (Real u, Real v, Vector3* pos,
         {
             for (iv = ivmin; iv <= ivmax; ++iv)
             {
-                tmp = mBasis[0].GetD0(iu)*mBasis[1].GetD1(iv)*
+                tmp = basisU.GetD0(iu)*basisV.GetD1(iv)*
                     mCtrlWeight[iu][iv];
                 XDerV += tmp*mCtrlPoint[iu][iv];
                 wDerV += tmp;
@@ -504,7 +477,7 @@ void NURBSRectangle<Real>::Get (Real u, Real v, Vector3* pos,
         {
             for (iv = ivmin; iv <= ivmax; ++iv)
             {
-                tmp = mBasis[0].GetD2(iu)*mBasis[1].GetD0(iv)*
+                tmp = basisU.GetD2(iu)*basisV.GetD0(iv)*
                     mCtrlWeight[iu][iv];
                 XDerUU += tmp*mCtrlPoint[iu][iv];
                 wDerUU += tmp;
@@ -521,7 +494,7 @@ void NURBSRectangle<Real>::Get (Real u, Real v, Vector3* pos,
         {
             for (iv = ivmin; iv <= ivmax; ++iv)
             {
-                tmp = mBasis[0].GetD1(iu)*mBasis[1].GetD1(iv)*
+                tmp = basisU.GetD1(iu)*basisV.GetD1(iv)*
                     mCtrlWeight[iu][iv];
                 XDerUV += tmp*mCtrlPoint[iu][iv];
                 wDerUV += tmp;
@@ -538,7 +511,7 @@ void NURBSRectangle<Real>::Get (Real u, Real v, Vector3* pos,
         {
             for (iv = ivmin; iv <= ivmax; ++iv)
             {
-                tmp = mBasis[0].GetD0(iu)*mBasis[1].GetD2(iv)*
+                tmp = basisU.GetD0(iu)*basisV.GetD2(iv)*
                     mCtrlWeight[iu][iv];
                 XDerVV += tmp*mCtrlPoint[iu][iv];
                 wDerVV += tmp;
@@ -557,6 +530,25 @@ Vector3 NURBSRectangle<Real>::P (Real u, Real v)
 }
 //----------------------------------------------------------------------------
 template <typename Real>
+Vector3 NURBSRectangle<Real>::P (Real u, Real v) const
+{
+    Vector3 pos;
+    Get(u, v, &pos, 0, 0, 0, 0, 0);
+    return pos;
+}
+//----------------------------------------------------------------------------
+template <typename Real>
+void NURBSRectangle<Real>::GetFrame (Real u, Real v, Vector3& position,
+    Vector3& tangent0, Vector3& tangent1, Vector3& normal) const
+{
+    Get(u, v, &position, &tangent0, &tangent1, 0, 0, 0);
+    tangent0.normalize();
+    tangent1.normalize();
+    normal = cross(tangent0, tangent1).normalized();
+    tangent1 = cross(normal,tangent0);
+}
+//----------------------------------------------------------------------------
+template <typename Real>
 Vector3 NURBSRectangle<Real>::PU (Real u, Real v)
 {
     Vector3 derU;
@@ -106,10 +106,16 @@ public:
     // If you need position and derivatives at the same time, it is more
     // efficient to call these functions.  Pass the addresses of those
     // quantities whose values you want.  You may pass 0 in any argument
-    // whose value you do not want.
+    // whose value you do not want.  Evaluation keeps its basis scratch on
+    // the stack, so one surface can be evaluated from several threads.
     void Get (Real u, Real v, Vector3* pos, Vector3* derU = 0,
         Vector3* derV = 0, Vector3* derUU = 0, Vector3* derUV = 0,
-        Vector3* derVV = 0);
+        Vector3* derVV = 0) const;
+    Vector3 P (Real u, Real v) const;
+
+    // Same frame as ParametricSurface::GetFrame from a single evaluation.
+    void GetFrame (Real u, Real v, Vector3& position, Vector3& tangent0,
+        Vector3& tangent1, Vector3& normal) const;
 
     // Cached visualization
     std::vector<SurfaceQuad> quads;
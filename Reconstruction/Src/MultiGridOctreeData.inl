@@ -33,6 +33,7 @@ DAMAGE.
 #include "MemoryUsage.h"
 #include "PointStream.h"
 #include "MAT.h"
+#include "omp.h"
 
 #define ITERATION_POWER 1.0/3
 #define MEMORY_ALLOCATOR_BLOCK_SIZE 1<<12
@@ -2988,8 +2989,7 @@ void Octree< Degree , OutputDensity >::GetMCIsoTriangles( Real isoValue , int su
 	// Ensure that the subtrees are self-contained
 	int sDepth = refineBoundary( subdivideDepth );
 
-	RootData rootData , coarseRootData;
-	std::vector< Vertex >* interiorVertices;
+	RootData coarseRootData;
 	int maxDepth = tree.maxDepth();
 
 	std::vector< Real > metSolution( _sNodes.nodeCount[maxDepth] , 0 );
@@ -3001,17 +3001,29 @@ void Octree< Degree , OutputDensity >::GetMCIsoTriangles( Real isoValue , int su
 #pragma omp parallel for num_threads( threads )
 	for( int i=0 ; i<_sNodes.nodeCount[maxDepth+1] ; i++ ) _sNodes.treeNodes[i]->nodeData.mcIndex = 0;
 
-	rootData.boundaryValues = new hash_map< long long , std::pair< Real , Point3D< Real > > >();
-	int offSet = 0;
+	hash_map< long long , std::pair< Real , Point3D< Real > > >* boundaryValues = new hash_map< long long , std::pair< Real , Point3D< Real > > >();
+
+	// The subtrees below sDepth only share the roots on their boundary faces. When there are enough of them, each
+	// thread extracts whole subtrees into a private mesh (with its own corner/edge tables) and the private meshes are
+	// stitched into the output in subtree order, so the result does not depend on the thread count.
+	std::vector< int > subtrees;
+	for( int i=_sNodes.nodeCount[sDepth] ; i<_sNodes.nodeCount[sDepth+1] ; i++ ) if( _sNodes.treeNodes[i]->children ) subtrees.push_back( i );
+	int sThreads = std::max< int >( 1 , std::min< int >( threads , int( subtrees.size() ) ) );
+	int lThreads = sThreads>1 ? 1 : threads;
 
 	int maxCCount = _sNodes.getMaxCornerCount( sDepth , maxDepth , threads );
 	int maxECount = _sNodes.getMaxEdgeCount  ( &tree , sDepth , threads );
-	rootData.cornerValues     = NewPointer< Real            >( maxCCount );
-	rootData.cornerNormals    = NewPointer< Point3D< Real > >( maxCCount );
-	rootData.interiorRoots    = NewPointer< int             >( maxECount );
-	rootData.cornerValuesSet  = NewPointer< char            >( maxCCount );
-	rootData.cornerNormalsSet = NewPointer< char            >( maxCCount );
-	rootData.edgesSet         = NewPointer< char            >( maxECount );
+	std::vector< RootData > rootDatas( sThreads );
+	for( int t=0 ; t<sThreads ; t++ )
+	{
+		rootDatas[t].boundaryValues   = boundaryValues;
+		rootDatas[t].cornerValues     = NewPointer< Real            >( maxCCount );
+		rootDatas[t].cornerNormals    = NewPointer< Point3D< Real > >( maxCCount );
+		rootDatas[t].interiorRoots    = NewPointer< int             >( maxECount );
+		rootDatas[t].cornerValuesSet  = NewPointer< char            >( maxCCount );
+		rootDatas[t].cornerNormalsSet = NewPointer< char            >( maxCCount );
+		rootDatas[t].edgesSet         = NewPointer< char            >( maxECount );
+	}
 	_sNodes.setCornerTable( coarseRootData , NULL , sDepth , threads );
 	coarseRootData.cornerValues     = NewPointer< Real            >( coarseRootData.cCount );
 	coarseRootData.cornerNormals    = NewPointer< Point3D< Real > >( coarseRootData.cCount );
@@ -3021,8 +3033,8 @@ void Octree< Degree , OutputDensity >::GetMCIsoTriangles( Real isoValue , int su
 	memset( coarseRootData.cornerNormalsSet , 0 , sizeof( char ) * coarseRootData.cCount );
 	MemoryUsage();
 
-	std::vector< typename TreeOctNode::ConstNeighborKey3 > nKeys( threads );
-	for( int t=0 ; t<threads ; t++ ) nKeys[t].set( maxDepth );
+	std::vector< typename TreeOctNode::ConstNeighborKey3 > nKeys( sThreads*lThreads );
+	for( int t=0 ; t<sThreads*lThreads ; t++ ) nKeys[t].set( maxDepth );
 	typename TreeOctNode::ConstNeighborKey3 nKey;
 	nKey.set( maxDepth );
 	std::vector< CornerValueStencil > vStencils( maxDepth+1 );
@@ -3037,30 +3049,37 @@ void Octree< Degree , OutputDensity >::GetMCIsoTriangles( Real isoValue , int su
 
 
 	// First process all leaf nodes at depths strictly finer than sDepth, one subtree at a time.
-	for( int i=_sNodes.nodeCount[sDepth] ; i<_sNodes.nodeCount[sDepth+1] ; i++ )
+#pragma omp parallel for num_threads( sThreads ) schedule( dynamic ) ordered
+	for( int s=0 ; s<int( subtrees.size() ) ; s++ )
 	{
-		if( !_sNodes.treeNodes[i]->children ) continue;
-
-		_sNodes.setCornerTable( rootData , _sNodes.treeNodes[i] , threads );
-		_sNodes.setEdgeTable  ( rootData , _sNodes.treeNodes[i] , threads );
+		int st = omp_get_thread_num();
+		RootData& rootData = rootDatas[st];
+		typename TreeOctNode::ConstNeighborKey3* _nKeys = &nKeys[st*lThreads];
+		TreeOctNode* subtree = _sNodes.treeNodes[ subtrees[s] ];
+
+		// Roots are indexed locally: interior roots from zero, boundary roots in the subtree's own in-core list
+		CoredVectorMeshData< Vertex > subMesh;
+		rootData.boundaryRoots.clear();
+		_sNodes.setCornerTable( rootData , subtree , lThreads );
+		_sNodes.setEdgeTable  ( rootData , subtree , lThreads );
 		memset( rootData.cornerValuesSet  , 0 , sizeof( char ) * rootData.cCount );
 		memset( rootData.cornerNormalsSet , 0 , sizeof( char ) * rootData.cCount );
 		memset( rootData.edgesSet         , 0 , sizeof( char ) * rootData.eCount );
-		interiorVertices = new std::vector< Vertex >();
+		std::vector< Vertex > interiorVertices;
 		for( int d=maxDepth ; d>sDepth ; d-- )
 		{
 			int leafNodeCount = 0;
 			std::vector< TreeOctNode* > leafNodes;
-			for( TreeOctNode* node=_sNodes.treeNodes[i]->nextLeaf() ; node ; node=_sNodes.treeNodes[i]->nextLeaf( node ) ) if( node->depth()==d && node->nodeData.nodeIndex!=-1 ) leafNodeCount++;
+			for( TreeOctNode* node=subtree->nextLeaf() ; node ; node=subtree->nextLeaf( node ) ) if( node->depth()==d && node->nodeData.nodeIndex!=-1 ) leafNodeCount++;
 			leafNodes.reserve( leafNodeCount );
-			for( TreeOctNode* node=_sNodes.treeNodes[i]->nextLeaf() ; node ; node=_sNodes.treeNodes[i]->nextLeaf( node ) ) if( node->depth()==d && node->nodeData.nodeIndex!=-1 ) leafNodes.push_back( node );
+			for( TreeOctNode* node=subtree->nextLeaf() ; node ; node=subtree->nextLeaf( node ) ) if( node->depth()==d && node->nodeData.nodeIndex!=-1 ) leafNodes.push_back( node );
 
 			// First set the corner values and associated marching-cube indices
-#pragma omp parallel for num_threads( threads )
-			for( int t=0 ; t<threads ; t++ ) for( int i=(leafNodeCount*t)/threads ; i<(leafNodeCount*(t+1))/threads ; i++ )
+#pragma omp parallel for num_threads( lThreads )
+			for( int t=0 ; t<lThreads ; t++ ) for( int i=(leafNodeCount*t)/lThreads ; i<(leafNodeCount*(t+1))/lThreads ; i++ )
 			{
 				TreeOctNode* leaf = leafNodes[i];
-				SetIsoCorners( isoValue , leaf , rootData , rootData.cornerValuesSet , rootData.cornerValues , nKeys[t] , &metSolution[0] , evaluator , vStencils[d].stencil , vStencils[d].stencils );
+				SetIsoCorners( isoValue , leaf , rootData , rootData.cornerValuesSet , rootData.cornerValues , _nKeys[t] , &metSolution[0] , evaluator , vStencils[d].stencil , vStencils[d].stencils );
 
 				// If this node shares a vertex with a coarser node, set the vertex value
 				int d , off[3];
@@ -3081,34 +3100,62 @@ void Octree< Degree , OutputDensity >::GetMCIsoTriangles( Real isoValue , int su
 
 				// Compute the iso-vertices
 				//
-				if( _boundaryType!=0 || _IsInset( leaf ) ) SetMCRootPositions( leaf , sDepth , isoValue , nKeys[t] , rootData , interiorVertices , mesh , &metSolution[0] , evaluator , nStencils[d].stencil , nStencils[d].stencils , nonLinearFit );
+				if( _boundaryType!=0 || _IsInset( leaf ) ) SetMCRootPositions( leaf , sDepth , isoValue , _nKeys[t] , rootData , &interiorVertices , &subMesh , &metSolution[0] , evaluator , nStencils[d].stencil , nStencils[d].stencils , nonLinearFit );
 			}
 			// Note that this should be broken off for multi-threading as
 			// the SetMCRootPositions writes to interiorPoints (with locking)
 			// while GetMCIsoTriangles reads from interiorPoints (without locking)
 			std::vector< Vertex > barycenters;
 			std::vector< Vertex >* barycenterPtr = addBarycenter ? & barycenters : NULL;
-#pragma omp parallel for num_threads( threads )
-			for( int t=0 ; t<threads ; t++ ) for( int i=(leafNodeCount*t)/threads ; i<(leafNodeCount*(t+1))/threads ; i++ )
+#pragma omp parallel for num_threads( lThreads )
+			for( int t=0 ; t<lThreads ; t++ ) for( int i=(leafNodeCount*t)/lThreads ; i<(leafNodeCount*(t+1))/lThreads ; i++ )
 			{
 				TreeOctNode* leaf = leafNodes[i];
-				if( _boundaryType!=0 || _IsInset( leaf ) ) GetMCIsoTriangles( leaf , mesh , rootData , interiorVertices , offSet , sDepth , polygonMesh , barycenterPtr );
+				if( _boundaryType!=0 || _IsInset( leaf ) ) GetMCIsoTriangles( leaf , &subMesh , rootData , &interiorVertices , 0 , sDepth , polygonMesh , barycenterPtr );
+			}
+			for( size_t i=0 ; i<barycenters.size() ; i++ ) interiorVertices.push_back( barycenters[i] );
+		}
+
+		// Stitch the subtree into the output, re-using boundary roots already added by a neighboring subtree
+#pragma omp ordered
+		{
+			std::vector< long long > keys( subMesh.inCorePoints.size() );
+			for( hash_map< long long , int >::iterator iter=rootData.boundaryRoots.begin() ; iter!=rootData.boundaryRoots.end() ; iter++ ) keys[ iter->second ] = iter->first;
+			std::vector< int > inCoreMap( subMesh.inCorePoints.size() );
+			for( int i=0 ; i<int( keys.size() ) ; i++ )
+			{
+				hash_map< long long , int >::iterator iter = coarseRootData.boundaryRoots.find( keys[i] );
+				if( iter!=coarseRootData.boundaryRoots.end() ) inCoreMap[i] = iter->second;
+				else
+				{
+					mesh->inCorePoints.push_back( subMesh.inCorePoints[i] );
+					inCoreMap[i] = coarseRootData.boundaryRoots[ keys[i] ] = int( mesh->inCorePoints.size() )-1;
+				}
+			}
+			int offSet = mesh->outOfCorePointCount();
+			for( size_t i=0 ; i<interiorVertices.size() ; i++ ) mesh->addOutOfCorePoint( interiorVertices[i] );
+			std::vector< CoredVertexIndex > polygon;
+			subMesh.resetIterator();
+			while( subMesh.nextPolygon( polygon ) )
+			{
+				for( int i=0 ; i<int( polygon.size() ) ; i++ )
+					if( polygon[i].inCore ) polygon[i].idx = inCoreMap[ polygon[i].idx ];
+					else                    polygon[i].idx += offSet;
+				mesh->addPolygon( polygon );
 			}
-			for( size_t i=0 ; i<barycenters.size() ; i++ ) interiorVertices->push_back( barycenters[i] );
 		}
-		offSet = mesh->outOfCorePointCount();
-		delete interiorVertices;
 	}
 
 	MemoryUsage();
-	DeletePointer( rootData.cornerValues ) ; DeletePointer( rootData.cornerNormals );
-	DeletePointer( rootData.cornerValuesSet ) ; DeletePointer( rootData.cornerNormalsSet );
-	DeletePointer( rootData.interiorRoots );
-	DeletePointer( rootData.edgesSet );
+	for( int t=0 ; t<sThreads ; t++ )
+	{
+		DeletePointer( rootDatas[t].cornerValues ) ; DeletePointer( rootDatas[t].cornerNormals );
+		DeletePointer( rootDatas[t].cornerValuesSet ) ; DeletePointer( rootDatas[t].cornerNormalsSet );
+		DeletePointer( rootDatas[t].interiorRoots );
+		DeletePointer( rootDatas[t].edgesSet );
+	}
 	coarseRootData.interiorRoots = NullPointer< int >();
-	coarseRootData.boundaryValues = rootData.boundaryValues;
-	for( hash_map< long long , int >::iterator iter=rootData.boundaryRoots.begin() ; iter!=rootData.boundaryRoots.end() ; iter++ ) 
-		coarseRootData.boundaryRoots[iter->first] = iter->second;
+	coarseRootData.boundaryValues = boundaryValues;
 
 	for( int d=sDepth ; d>=0 ; d-- )
 	{
@@ -3136,7 +3183,7 @@ void Octree< Degree , OutputDensity >::GetMCIsoTriangles( Real isoValue , int su
 
 	DeletePointer( coarseRootData.cornerValues ) ;  DeletePointer( coarseRootData.cornerNormals );
 	DeletePointer( coarseRootData.cornerValuesSet ) ; DeletePointer( coarseRootData.cornerNormalsSet );
-	delete rootData.boundaryValues;
+	delete boundaryValues;
 }
 template< int Degree , bool OutputDensity >
 Real Octree< Degree , OutputDensity >::getCenterValue( const typename TreeOctNode::ConstNeighborKey3& neighborKey , const TreeOctNode* node , const Real* metSolution , const typename BSplineData< Degree , Real >::template CenterEvaluator< 1 >& evaluator , const Stencil< double , 3 >& stencil , const Stencil< double , 3 >& pStencil , bool isInterior ) const
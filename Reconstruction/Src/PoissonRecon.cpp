@@ -364,6 +364,8 @@ int ExecuteMemory( int argc , char* argv[], std::vector< std::vector< float > >
 	//}
 
 	if( !MaxSolveDepth.set ) MaxSolveDepth.value = Depth.value;
+	// Leave a few levels above the iso-surface subtrees so they can be extracted in parallel
+	if( !IsoDivide.set ) IsoDivide.value = Depth.value-2;
 	if( SolverDivide.value<MinDepth.value )
 	{
 		fprintf( stderr , "[WARNING] %s must be at least as large as %s: %d>=%d\n" , SolverDivide.name , MinDepth.name , SolverDivide.value , MinDepth.value );
@@ -417,7 +419,7 @@ int ExecuteMemory( int argc , char* argv[], std::vector< std::vector< float > >
 	DumpOutput( "Memory Usage: %.3f MB\n" , float( MemoryInfo::Usage() )/(1<<20) );
 	maxMemoryUsage = std::max< double >( maxMemoryUsage , tree.maxMemoryUsage );
 
-	CoredFileMeshData< Vertex > mesh;
+	CoredVectorMeshData< Vertex > mesh;
 
 	if( Verbose.set ) tree.maxMemoryUsage=0;
 	t=Time();
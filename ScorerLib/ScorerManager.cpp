@@ -347,7 +347,7 @@ void ScorerManager::setIsUseLink(bool bUse)
 Structure::Graph * ScorerManager::getCurrentGraph(int& idx)
 {
 	int ct = this->scheduler_->slider->currentTime();
-	idx = this->scheduler_->allGraphs.size() * (double(ct) / this->scheduler_->totalExecutionTime());
+	idx = this->scheduler_->frameIndexAt( double(ct) / this->scheduler_->totalExecutionTime() );
 	
 	Structure::Graph * g = Structure::Graph::actualGraph(this->scheduler_->allGraphs[idx]);
 	return g;
@@ -327,153 +327,394 @@ Structure::Graph * DynamicGraph::toStructureGraph()
 	return graph;
 }
 
-QVector<DynamicGraph> DynamicGraph::candidateNodes(DynamicGraph & targetGraph)
+QVector<DynamicGraph> DynamicGraph::candidateNodes(DynamicGraph & targetGraph, int maxCandidates)
 {
 	QVector<DynamicGraph> candidate;
-	GraphState futureState = targetGraph.State();
 
-	// Compute graph difference
-	GraphState diff = difference( futureState );
+	CandidateSearch search(*this, targetGraph, false, maxCandidates);
+	while(candidate.size() < maxCandidates && search.hasNext())
+		candidate.push_back( search.next() );
 
-	// Should return no candidates when they are exactly the same
-	if( diff.isZero() ) return candidate;
+	return candidate;
+}
+
+QVector<DynamicGraph> DynamicGraph::candidateEdges(DynamicGraph & targetGraph, int maxCandidates)
+{
+	QVector<DynamicGraph> candidate;
 
-	QVector<int> activeNodes;
-	bool isAdding = true;
-	int discrepancy = 0;
+	CandidateSearch search(*this, targetGraph, true, maxCandidates);
+	while(candidate.size() < maxCandidates && search.hasNext())
+		candidate.push_back( search.next() );
 
-	// Missing nodes: nodes have precedent
-	if(diff.numSheets != 0 || diff.numCurves != 0)
+	return candidate;
+}
+
+uint DynamicGraph::canonicalHash( const QHash<QString,uint> & labels )
+{
+	QList<uint> all = refinedLabels( labels ).values();
+	qSort(all);
+
+	uint h = nodes.size();
+	foreach(uint l, all) h = (h * 1000003u) ^ l;
+	return h;
+}
+
+QMap<int,uint> DynamicGraph::refinedLabels( const QHash<QString,uint> & labels )
+{
+	// Weisfeiler-Lehman refinement: a node's label absorbs the sorted labels of its neighbors
+	QMap<int,uint> label;
+	foreach(int ni, nodes.keys())
+		label[ni] = labels.value( nodes[ni].str("original"), 0 );
+
+	for(int round = 0; round < 3; round++)
 	{
-		// Sheets and curves: sheet have precedent
-		if(diff.numSheets != 0)
-		{
-			activeNodes = getSheets();
-			if(diff.numSheets > 0) isAdding = false;
-			discrepancy = abs(diff.numSheets);
-		}
-		else if(diff.numCurves != 0)
+		QMap<int,uint> refined;
+
+		foreach(int ni, nodes.keys())
 		{
-			activeNodes = getCurves();
-			if(diff.numCurves > 0) isAdding = false;
-			discrepancy = abs(diff.numCurves);
+			QVector<uint> adj;
+			foreach(SimpleEdge e, adjacency.value(ni)) adj.push_back( label[e.otherNode(ni)] );
+			qSort(adj);
+
+			uint h = label[ni] * 31u + adj.size();
+			foreach(uint l, adj) h = (h * 1000003u) ^ l;
+			refined[ni] = h;
 		}
+
+		label = refined;
 	}
 
-	if(activeNodes.size() < 1) return candidate;
+	return label;
+}
+
+bool DynamicGraph::isIsomorphic( DynamicGraph & other, const QHash<QString,uint> & labels )
+{
+	if(nodes.size() != other.nodes.size() || edges.size() != other.edges.size()) return false;
+	if(nodes.isEmpty()) return true;
+
+	QMap<int,uint> label = refinedLabels( labels ), otherLabel = other.refinedLabels( labels );
+
+	QList<uint> all = label.values(), otherAll = otherLabel.values();
+	qSort(all); qSort(otherAll);
+	if(all != otherAll) return false;
 
-	// Try all sets of new edges of size
-	std::vector<int> nodesSet = activeNodes.toStdVector();
-	std::vector<int>::iterator begin = nodesSet.begin(), end = nodesSet.end();
-	do {
-		std::vector<int> currentSet (begin, begin + discrepancy);
+	// Backtracking over nodes with equal refined labels, edges to mapped nodes must agree
+	QVector<int> order = nodes.keys().toVector();
+	QMap<int,int> mapping;
+	QSet<int> used;
+	QVector<int> tried( order.size(), -1 );
+	QVector< QList<int> > choices( order.size() );
 
-		// Add operation as a candidate graph
-		DynamicGraph g = clone();
+	int k = 0;
+	choices[0] = otherLabel.keys( label[order[0]] );
 
-		foreach(int ci, currentSet)
+	while(k >= 0)
+	{
+		int ni = order[k];
+
+		// Undo this level's previous choice
+		if(mapping.contains(ni)){
+			used.remove( mapping[ni] );
+			mapping.remove( ni );
+		}
+
+		bool isMapped = false;
+		while(++tried[k] < choices[k].size())
 		{
-			if(isAdding)	
-				g.cloneNode(ci);
-			else
-				g.removeNode(ci);
+			int oi = choices[k][tried[k]];
+			if(used.contains(oi)) continue;
+
+			bool isConsistent = true;
+			foreach(int mi, mapping.keys()){
+				bool hasA = adjacency.value(ni).contains( SimpleEdge(ni, mi) );
+				bool hasB = other.adjacency.value(oi).contains( SimpleEdge(oi, mapping[mi]) );
+				if(hasA != hasB){ isConsistent = false; break; }
+			}
+			if(!isConsistent) continue;
+
+			mapping[ni] = oi;
+			used.insert( oi );
+			isMapped = true;
+			break;
 		}
 
-		candidate.push_back(g);
+		if(!isMapped){
+			tried[k] = -1;
+			k--;
+			continue;
+		}
 
-	} while (next_combination(begin, begin + discrepancy, end));
+		if(++k == order.size()) return true;
 
-	return candidate;
+		tried[k] = -1;
+		choices[k] = otherLabel.keys( label[order[k]] );
+	}
+
+	return false;
 }
 
-QVector<DynamicGraph> DynamicGraph::candidateEdges(DynamicGraph & targetGraph)
+CandidateSearch::CandidateSearch( DynamicGraph & source, DynamicGraph & target, bool isEdges, int maxQueued, int maxExamined, int batchSize )
 {
-	QVector<DynamicGraph> candidate;
-	GraphState futureState = targetGraph.State();
+	this->source = &source;
+	this->target = &target;
+	this->isEdges = isEdges;
+	this->isAdding = true;
+	this->discrepancy = 0;
+	this->maxQueued = maxQueued;
+	this->maxExamined = maxExamined;
+	this->batchSize = batchSize;
+	this->isExhausted = true;
+	this->isAccepted = false;
+	this->numExamined = this->numPruned = this->numDuplicates = 0;
 
-	// Compute graph difference
-	GraphState diff = difference( futureState );
+	// Node types, looked up once
+	QVector<int> sheets, curves;
+	foreach(int ni, source.nodes.keys())
+	{
+		isSheet[ni] = (source.nodeType(ni) == Structure::SHEET);
+		labels[ source.nodes[ni].str("original") ] = isSheet[ni] ? 2 : 1;
 
-	// Should return no candidates when they are exactly the same
-	if( diff.isZero() ) return candidate;
+		if(isSheet[ni]) sheets.push_back(ni); else curves.push_back(ni);
+		sourceValence[ni] = source.adjacency.value(ni).size();
+	}
 
-	QVector<int> groupA, groupB;
-	QSet<SimpleEdge> exploredEdges;
-	bool isAdding = true;
+	sourceState = source.State();
+	targetState = target.State();
 
-	int discrepancy = 0;
+	foreach(int ni, target.nodes.keys())
+		targetValences.push_back( target.adjacency.value(ni).size() );
+	std::sort(targetValences.rbegin(), targetValences.rend());
 
-	// Add existing edges as explored
-	foreach(SimpleEdge e, edges)
-		exploredEdges.insert(e);
+	sourceDistance = distance( sourceState );
+	sourceValenceDistance = valenceDistance( sourceValence.values().toVector().toStdVector() );
 
-	if(diff.numMixedEdges != 0)
+	// Should return no candidates when they are exactly the same
+	GraphState diff = source.difference( targetState );
+	if( diff.isZero() ) return;
+
+	int d = 0;
+
+	if( !isEdges )
 	{
-		// Curve-Sheet edges
-		if(diff.numMixedEdges > 0) isAdding = false;
-		groupA = getSheets();
-		groupB = getCurves();
-		discrepancy = abs(diff.numMixedEdges);
+		// Missing nodes: sheets have precedent
+		if(diff.numSheets != 0)		{ d = diff.numSheets; itemNodes = sheets; }
+		else if(diff.numCurves != 0){ d = diff.numCurves; itemNodes = curves; }
 	}
-	else if(diff.numSheetEdges != 0)
+	else
 	{
-		// Sheet-Sheet edges
-		if(diff.numSheetEdges > 0) isAdding = false;
-		groupA = getSheets();
-		groupB = groupA;
-		discrepancy = abs(diff.numSheetEdges);
+		QVector<int> groupA, groupB;
+
+		if(diff.numMixedEdges != 0)		{ d = diff.numMixedEdges; groupA = sheets; groupB = curves; }
+		else if(diff.numSheetEdges != 0){ d = diff.numSheetEdges; groupA = sheets; groupB = sheets; }
+		else if(diff.numCurveEdges != 0){ d = diff.numCurveEdges; groupA = curves; groupB = curves; }
+
+		QSet<SimpleEdge> existing, explored;
+		foreach(SimpleEdge e, source.edges) existing.insert(e);
+
+		foreach(int a, groupA)
+		{
+			foreach(int b, groupB)
+			{
+				SimpleEdge e(a, b);
+
+				// Uniqueness check:
+				if(a == b || explored.contains(e)) continue;
+				explored.insert(e);
+
+				// Adding needs new edges, removing needs existing ones
+				if(existing.contains(e) == (d < 0)) continue;
+
+				itemEdges.push_back(e);
+			}
+		}
+	}
+
+	int numItems = isEdges ? itemEdges.size() : itemNodes.size();
+	if(d == 0 || numItems < 1) return;
+
+	isAdding = (d < 0);
+	discrepancy = qMin(abs(d), numItems);
+
+	for(int i = 0; i < numItems; i++) combination.push_back(i);
+	isExhausted = false;
+}
+
+bool CandidateSearch::hasNext()
+{
+	while(queue.isEmpty() && !isExhausted) fill();
+
+	// When every edit was pruned, fall back to the best of them
+	if(queue.isEmpty() && !isAccepted && !pruned.isEmpty()){
+		queue = pruned;
+		pruned.clear();
+		isAccepted = true;
 	}
-	else if(diff.numCurveEdges != 0)
+
+	return !queue.isEmpty();
+}
+
+DynamicGraph CandidateSearch::next( double * score )
+{
+	if(!isExhausted) fill();
+	if(!hasNext()) return DynamicGraph();
+
+	QMultiMap<double, DynamicGraph>::iterator best = queue.begin();
+	if(score) *score = best.key();
+
+	DynamicGraph g = best.value();
+	queue.erase(best);
+	return g;
+}
+
+void CandidateSearch::fill()
+{
+	for(int i = 0; i < batchSize && !isExhausted; i++)
 	{
-		// Curve-Curve edges
-		if(diff.numCurveEdges > 0) isAdding = false;
-		groupA = getCurves();
-		groupB = groupA;
-		discrepancy = abs(diff.numCurveEdges);
+		if(numExamined >= maxExamined){
+			isExhausted = true;
+			break;
+		}
+
+		std::vector<int>::iterator begin = combination.begin(), end = combination.end();
+		examine( std::vector<int>(begin, begin + discrepancy) );
+
+		isExhausted = !next_combination(begin, begin + discrepancy, end);
 	}
+}
+
+void CandidateSearch::examine( const std::vector<int> & currentSet )
+{
+	numExamined++;
+
+	// State and valences after the edit, without building the graph
+	GraphState s = sourceState;
+	QMap<int,int> val = sourceValence;
+	int sign = isAdding ? 1 : -1;
 
-	// Find all possible new edges
-	QMap<int, SimpleEdge> uniqueEdges;
-	foreach(int a, groupA)
+	if( !isEdges )
 	{
-		foreach(int b, groupB)
+		QSet<int> removed;
+
+		foreach(int k, currentSet)
 		{
-			SimpleEdge e(a, b);
+			int ni = itemNodes[k];
+			if(isSheet[ni]) s.numSheets += sign; else s.numCurves += sign;
 
-			// Uniqueness check:
-			if(a == b || exploredEdges.contains(e)) continue;
-			exploredEdges.insert(e);
+			if(isAdding) val[-1 - k] = 0;
+			else removed.insert(ni);
+		}
 
-			uniqueEdges[uniqueEdges.size()] = e;
+		if( !isAdding )
+		{
+			foreach(SimpleEdge e, source->edges)
+			{
+				if(!removed.contains(e.n[0]) && !removed.contains(e.n[1])) continue;
+				countEdge(s, e, -1);
+				val[e.n[0]]--;
+				val[e.n[1]]--;
+			}
+
+			foreach(int ni, removed) val.remove(ni);
+		}
+	}
+	else
+	{
+		foreach(int k, currentSet)
+		{
+			SimpleEdge e = itemEdges[k];
+			countEdge(s, e, sign);
+			val[e.n[0]] += sign;
+			val[e.n[1]] += sign;
 		}
 	}
 
-	// Try all sets of new edges of size
-	std::vector<int> uniqueEdgesIdx;
-	foreach(int key, uniqueEdges.keys()) uniqueEdgesIdx.push_back(key);
+	bool isPruned = distance(s) >= sourceDistance 
+		|| valenceDistance( val.values().toVector().toStdVector() ) > sourceValenceDistance;
 
-	std::vector<int>::iterator begin = uniqueEdgesIdx.begin(), end = uniqueEdgesIdx.end();
-	do {
-		std::vector<int> currentSet (begin, begin + discrepancy);
+	if( isPruned ){
+		numPruned++;
+		if(isAccepted) return;
+	}
 
-		// Add operation as a candidate graph
-		DynamicGraph g = clone();
+	// Apply operation on a copy
+	DynamicGraph g = source->clone();
 
-		foreach(int key, currentSet)
-		{
-			SimpleEdge e = uniqueEdges[key];
+	foreach(int k, currentSet)
+	{
+		if( isEdges ){
+			SimpleEdge e = itemEdges[k];
+			if(isAdding) g.addEdge(e.n[0], e.n[1]);
+			else g.removeEdge(e.n[0], e.n[1]);
+		}
+		else{
+			if(isAdding) g.cloneNode(itemNodes[k]);
+			else g.removeNode(itemNodes[k]);
+		}
+	}
 
-			if(isAdding)
-				g.addEdge(e.n[0], e.n[1]);
-			else
-				g.removeEdge(e.n[0], e.n[1]);
+	// Skip graphs isomorphic to one already seen
+	uint h = g.canonicalHash( labels );
+	QVector<DynamicGraph> & bucket = seen[h];
+	for(int i = 0; i < bucket.size(); i++){
+		if( g.isIsomorphic(bucket[i], labels) ){
+			numDuplicates++;
+			return;
 		}
+	}
+	bucket.push_back( g );
 
-		candidate.push_back(g);
+	double score = 0;
+	g.correspondence(*target, score);
 
-	} while (next_combination(begin, begin + discrepancy, end));
+	if( isPruned ){
+		enqueue(pruned, score, g);
+		return;
+	}
 
-	return candidate;
+	if( !isAccepted ){
+		isAccepted = true;
+		pruned.clear();
+	}
+
+	enqueue(queue, score, g);
+}
+
+int CandidateSearch::distance( const GraphState & s )
+{
+	return abs(s.numSheets - targetState.numSheets) + abs(s.numCurves - targetState.numCurves)
+		+ abs(s.numCurveEdges - targetState.numCurveEdges) + abs(s.numSheetEdges - targetState.numSheetEdges)
+		+ abs(s.numMixedEdges - targetState.numMixedEdges);
+}
+
+void CandidateSearch::countEdge( GraphState & s, const SimpleEdge & e, int sign )
+{
+	int numSheets = int(isSheet[e.n[0]]) + int(isSheet[e.n[1]]);
+
+	if(numSheets == 0) s.numCurveEdges += sign;
+	if(numSheets == 1) s.numMixedEdges += sign;
+	if(numSheets == 2) s.numSheetEdges += sign;
+}
+
+int CandidateSearch::valenceDistance( std::vector<int> vals )
+{
+	// Compare sorted valence signatures, padding the shorter with zeros
+	std::sort(vals.rbegin(), vals.rend());
+
+	int d = 0, n = qMax(vals.size(), targetValences.size());
+	for(int i = 0; i < n; i++){
+		int a = i < (int)vals.size() ? vals[i] : 0;
+		int b = i < (int)targetValences.size() ? targetValences[i] : 0;
+		d += abs(a - b);
+	}
+	return d;
+}
+
+void CandidateSearch::enqueue( QMultiMap<double, DynamicGraph> & q, double score, const DynamicGraph & g )
+{
+	q.insert(score, g);
+
+	// Keep only the best
+	if(q.size() > maxQueued) q.erase( --q.end() );
 }
 
 int DynamicGraph::valence( int nodeIndex )
@@ -554,8 +795,19 @@ QVector< QPairInt > DynamicGraph::correspondence( DynamicGraph & other, double &
 		Structure::Node * n1 = this->mGraph->getNode( n1_id );
         Vector3 center1(0,0,0); n1->get(Vector4d(0.5,0.5,0.5,0.5), center1, nf);
 
+		// Nodes of the nearest valence when none match exactly
+		int matchValence = valence;
+		if( vset[valence].isEmpty() )
+		{
+			int best = -1;
+			foreach(int v, vset.keys())
+				if( !vset[v].isEmpty() && (best < 0 || abs(v - valence) < abs(best - valence)) ) best = v;
+			if(best < 0) break;
+			matchValence = best;
+		}
+
 		// Test against possible corresponding nodes
-		foreach( int curID, vset[ valence ] )
+		foreach( int curID, vset[ matchValence ] )
 		{
 			QString n2_id = other.nodes[curID].str("original");
 			Structure::Node * n2 = other.mGraph->getNode( n2_id );
@@ -571,7 +823,7 @@ QVector< QPairInt > DynamicGraph::correspondence( DynamicGraph & other, double &
 		score += minScore;
 
 		int otherID = scoreBoard[ minScore ];
-		vset[ valence ].removeAll( otherID );
+		vset[ matchValence ].removeAll( otherID );
 
 		// Pair current node with minimum one
 		corr.push_back( qMakePair(nodeID, otherID) );
@@ -65,9 +65,14 @@ namespace DynamicGraphs
 		// Generate structure graph
 		Structure::Graph * toStructureGraph();
 
-		// Graph edit
-		QVector<DynamicGraph> candidateNodes(DynamicGraph & targetGraph);
-		QVector<DynamicGraph> candidateEdges(DynamicGraph & targetGraph);
+		// Graph edit, best candidates toward the target (see CandidateSearch)
+		QVector<DynamicGraph> candidateNodes(DynamicGraph & targetGraph, int maxCandidates = 32);
+		QVector<DynamicGraph> candidateEdges(DynamicGraph & targetGraph, int maxCandidates = 32);
+
+		// Isomorphism invariant hash, starting from per-node labels keyed by original ID
+		uint canonicalHash( const QHash<QString,uint> & labels );
+		QMap<int,uint> refinedLabels( const QHash<QString,uint> & labels );
+		bool isIsomorphic( DynamicGraph & other, const QHash<QString,uint> & labels );
 
 	public:
 
@@ -90,4 +95,53 @@ namespace DynamicGraphs
 		Array1D_Vector4d firstSpecialCoord( int node_index );
 	};
 
+	// Candidate node or edge edits toward a target graph, generated lazily. Each call to
+	// next() examines one more batch and returns the best correspondence found so far, so
+	// a later candidate can still score better than an earlier one. Edits that do not bring
+	// the graph state or the valence signature closer to the target are pruned, and
+	// isomorphic candidates are only returned once.
+	class CandidateSearch
+	{
+	public:
+		CandidateSearch( DynamicGraph & source, DynamicGraph & target, bool isEdges,
+			int maxQueued = 32, int maxExamined = 5000, int batchSize = 64 );
+
+		bool hasNext();
+		DynamicGraph next( double * score = NULL );
+
+		// Statistics
+		int numExamined, numPruned, numDuplicates;
+
+	private:
+		DynamicGraph * source, * target;
+		bool isEdges, isAdding;
+		int discrepancy, maxQueued, maxExamined, batchSize;
+
+		// Edit items and the current combination over them
+		QVector<int> itemNodes;
+		QVector<SimpleEdge> itemEdges;
+		std::vector<int> combination;
+		bool isExhausted, isAccepted;
+
+		// Pruning
+		QMap<int,bool> isSheet;
+		QHash<QString,uint> labels;
+		GraphState sourceState, targetState;
+		QMap<int,int> sourceValence;
+		std::vector<int> targetValences;
+		int sourceDistance, sourceValenceDistance;
+
+		// Graphs returned so far, bucketed by canonical hash and compared exactly within a bucket
+		QHash< uint, QVector<DynamicGraph> > seen;
+		QMultiMap<double, DynamicGraph> queue;
+		QMultiMap<double, DynamicGraph> pruned;
+
+		void examine( const std::vector<int> & currentSet );
+		void fill();
+		int distance( const GraphState & s );
+		void countEdge( GraphState & s, const SimpleEdge & e, int sign );
+		int valenceDistance( std::vector<int> vals );
+		void enqueue( QMultiMap<double, DynamicGraph> & q, double score, const DynamicGraph & g );
+	};
+
 }
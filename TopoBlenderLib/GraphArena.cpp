@@ -0,0 +1,152 @@
+#include <cstdlib>
+#include <new>
+#include <QThreadStorage>
+#include <QMutex>
+
+#include "GraphArena.h"
+
+using namespace Structure;
+
+// Every object carries its owning arena (or NULL for the heap) in front of it
+#define ARENA_HEADER 16
+#define ARENA_ALIGN 16
+
+// Full blocks go back to a shared pool instead of the heap, so a steady stream of clones, e.g. one per
+// timestep, reuses warm memory rather than growing and trimming the heap
+#define ARENA_SPARE_BLOCKS 256
+
+static QMutex spareMutex;
+static QVector<char*> spareBlocks;
+
+static char * takeBlock( size_t size )
+{
+	if( size == ARENA_BLOCK_SIZE )
+	{
+		QMutexLocker locker( &spareMutex );
+		if( !spareBlocks.isEmpty() ){
+			char * block = spareBlocks.back();
+			spareBlocks.pop_back();
+			return block;
+		}
+	}
+
+	char * block = (char*) malloc( size );
+	if( !block ) throw std::bad_alloc();
+	return block;
+}
+
+static void giveBlock( char * block, size_t size )
+{
+	if( size == ARENA_BLOCK_SIZE )
+	{
+		QMutexLocker locker( &spareMutex );
+		if( spareBlocks.size() < ARENA_SPARE_BLOCKS ){
+			spareBlocks.push_back( block );
+			return;
+		}
+	}
+
+	free( block );
+}
+
+Arena::Arena() : cursor(NULL), remaining(0), refs(1)
+{
+}
+
+Arena::~Arena()
+{
+	for(int i = 0; i < blocks.size(); i++) giveBlock( blocks[i], blockSizes[i] );
+}
+
+void * Arena::allocate( size_t size )
+{
+	size = (size + ARENA_ALIGN - 1) & ~size_t(ARENA_ALIGN - 1);
+
+	if( size > remaining )
+	{
+		// Oversized objects get a block of their own, the current block stays open
+		if( size > ARENA_BLOCK_SIZE / 4 )
+		{
+			char * block = takeBlock( size );
+			blocks.push_back( block );
+			blockSizes.push_back( size );
+			retain();
+			return block;
+		}
+
+		cursor = takeBlock( ARENA_BLOCK_SIZE );
+		blocks.push_back( cursor );
+		blockSizes.push_back( ARENA_BLOCK_SIZE );
+		remaining = ARENA_BLOCK_SIZE;
+	}
+
+	void * p = cursor;
+	cursor += size;
+	remaining -= size;
+	retain();
+	return p;
+}
+
+void Arena::retain()
+{
+	refs.ref();
+}
+
+void Arena::release()
+{
+	if( !refs.deref() ) delete this;
+}
+
+// QThreadStorage takes ownership of pointers only, and deletes them when the thread ends
+struct ArenaSlot{
+	Arena * arena;
+	ArenaSlot() : arena(NULL) {}
+};
+static QThreadStorage<ArenaSlot*> currentArena;
+
+static inline ArenaSlot * arenaSlot()
+{
+	if( !currentArena.hasLocalData() ) currentArena.setLocalData( new ArenaSlot );
+	return currentArena.localData();
+}
+
+ArenaScope::ArenaScope( Arena * arena ) : arena(arena)
+{
+	ArenaSlot * slot = arenaSlot();
+	previous = slot->arena;
+	slot->arena = arena;
+	if( arena ) arena->retain();
+}
+
+ArenaScope::~ArenaScope()
+{
+	arenaSlot()->arena = previous;
+	if( arena ) arena->release();
+}
+
+Arena * ArenaScope::current()
+{
+	return currentArena.hasLocalData() ? currentArena.localData()->arena : NULL;
+}
+
+void * ArenaObject::operator new( size_t size )
+{
+	Arena * arena = ArenaScope::current();
+
+	char * p = arena ? (char*) arena->allocate( size + ARENA_HEADER ) : (char*) malloc( size + ARENA_HEADER );
+	if( !p ) throw std::bad_alloc();
+
+	*(Arena**)p = arena;
+	return p + ARENA_HEADER;
+}
+
+void ArenaObject::operator delete( void * p )
+{
+	if( !p ) return;
+
+	char * block = (char*)p - ARENA_HEADER;
+	Arena * arena = *(Arena**)block;
+
+	if( arena ) arena->release();
+	else free( block );
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <QVector>
+#include <QAtomicInt>
+
+// Region allocation for graph clones. While an ArenaScope is alive on a thread, every graph, node and link
+// created on that thread is bump-allocated from the scope's arena instead of the global heap. Deleting such
+// an object only drops a reference, and the arena releases all of its blocks at once when the last one goes.
+// Only the objects themselves live in the arena: property maps are shared copy-on-write with the source,
+// and NURBS control points, weights and knots are still deep copies on the regular heap.
+namespace Structure{
+
+	#define ARENA_BLOCK_SIZE (16 * 1024)
+
+	class Arena
+	{
+	public:
+		Arena();
+
+		void * allocate( size_t size );
+
+		void retain();
+		void release();		// deletes the arena after the last reference
+
+		int blockCount() const { return blocks.size(); }
+
+	private:
+		~Arena();
+
+		QVector<char*> blocks;
+		QVector<size_t> blockSizes;
+		char * cursor;
+		size_t remaining;
+		QAtomicInt refs;
+	};
+
+	class ArenaScope
+	{
+	public:
+		ArenaScope( Arena * arena );
+		~ArenaScope();
+
+		static Arena * current();
+
+	private:
+		Arena * arena;
+		Arena * previous;
+	};
+
+	// Base for objects that can be placed in the current arena
+	struct ArenaObject
+	{
+		static void * operator new( size_t size );
+		static void operator delete( void * p );
+
+		// Placement forms, the caller owns the memory
+		static void * operator new( size_t, void * p ) { return p; }
+		static void operator delete( void *, void * ) {}
+	};
+}
@@ -5,6 +5,7 @@
 #include <fstream>
 
 #include "GraphDistance.h"
+#include "Tracing.h"
 
 #define INVALID_VALUE -1
 
@@ -1032,6 +1033,8 @@ void GraphCorresponder::computeCorrespondences()
 {
 	if (isReady) return;
 
+	TRACE_ZONE("GraphCorresponder::computeCorrespondences");
+
 	corrScores.clear();
 
 	// Prepare
@@ -12,35 +12,101 @@ GraphDissimilarity::GraphDissimilarity( Structure::Graph *graphInstance )
 
 void GraphDissimilarity::addGraph( Structure::Graph *g )
 {
-	/// Normalized Laplacian matrix (symmetric):
-	MatrixXd L = MatrixXd::Zero(N,N);
-	
-	// Diagonal entires
+	/// Adjacency structure: distinct neighbours per node, self edges ignored
+	QVector< QSet<int> > adj( N );
+	QVector<bool> isPresent( N, false );
+
 	foreach(Structure::Node * node, g->nodes){
-		int i = nodeIndex[node->id];
-		L(i,i) = (g->valence(node) == 0) ? 0 : 1;
+		int i = nodeIndex.value(node->id, -1);
+		if(i >= 0) isPresent[i] = true;
 	}
 
-	// i != j entires
 	foreach(Structure::Link * edge, g->edges)
 	{
-		int i = nodeIndex[edge->n1->id];
-		int j = nodeIndex[edge->n2->id];
-		if(i == j) continue; // just in case the graph is weird
+		int i = nodeIndex.value(edge->n1->id, -1);
+		int j = nodeIndex.value(edge->n2->id, -1);
+		if(i < 0 || j < 0 || i == j) continue; // just in case the graph is weird
+
+		adj[i].insert(j);
+		adj[j].insert(i);
+	}
+
+	addStructure( g, isPresent, adj );
+}
+
+void GraphDissimilarity::addGraph( Structure::ActualGraphView & view )
+{
+	QVector< QSet<int> > adj( N );
+	QVector<bool> isPresent( N, false );
 
-		int di = g->valence(edge->n1);
-		int dj = g->valence(edge->n2);
+	foreach(int ni, view.activeNodes()){
+		int i = nodeIndex.value(view.graph->nodes[ni]->id, -1);
+		if(i >= 0) isPresent[i] = true;
+	}
+
+	foreach(int e, view.activeEdges())
+	{
+		int i = nodeIndex.value(view.graph->nodes[view.edgeN1[e]]->id, -1);
+		int j = nodeIndex.value(view.graph->nodes[view.edgeN2[e]]->id, -1);
+		if(i < 0 || j < 0 || i == j) continue;
 
-		L(i,j) = L(j,i) = -(1.0 / (std::sqrt( double(di * dj) )));
+		adj[i].insert(j);
+		adj[j].insert(i);
 	}
 
+	addStructure( view.graph, isPresent, adj );
+}
+
+void GraphDissimilarity::addStructure( Structure::Graph * g, const QVector<bool> & isPresent, const QVector< QSet<int> > & adj )
+{
 	// Store input
 	graphs.push_back( g );
 
+	// Key describing the structure, graphs with the same key share a decomposition
+	std::vector<int> key;
+	for(int i = 0; i < N; i++)
+	{
+		key.push_back( isPresent[i] ? -1 : -2 );
+
+		std::vector<int> neighbours;
+		foreach(int j, adj[i]) neighbours.push_back(j);
+		std::sort(neighbours.begin(), neighbours.end());
+		key.insert(key.end(), neighbours.begin(), neighbours.end());
+	}
+
+	QByteArray structureKey( (const char*) key.data(), int(key.size() * sizeof(int)) );
+
+	if( spectrumCache.contains(structureKey) )
+	{
+		graphSpectrum.push_back( spectrumCache[structureKey] );
+		return;
+	}
+
+	/// Normalized Laplacian matrix (symmetric):
+	MatrixXd L = MatrixXd::Zero(N,N);
+
+	for(int i = 0; i < N; i++)
+	{
+		// Diagonal entires
+		int di = adj[i].size();
+		L(i,i) = (!isPresent[i] || di == 0) ? 0 : 1;
+
+		// i != j entires
+		foreach(int j, adj[i])
+		{
+			int dj = adj[j].size();
+			L(i,j) = -(1.0 / (std::sqrt( double(di * dj) )));
+		}
+	}
+
 	// Compute eigenvalues and eigenvectors
 	SelfAdjointEigenSolver<MatrixXd> es( L );
 	eigenvalues.push_back( es.eigenvalues() );
 	eigenvectors.push_back( es.eigenvectors() );
+
+	int s = eigenvalues.size() - 1;
+	spectrumCache[structureKey] = s;
+	graphSpectrum.push_back( s );
 }
 
 void GraphDissimilarity::addGraphs( QVector<Structure::Graph*> fromGraphs )
@@ -51,23 +117,32 @@ void GraphDissimilarity::addGraphs( QVector<Structure::Graph*> fromGraphs )
 
 double GraphDissimilarity::compute( int g1, int g2 )
 {
-	double d = 0;
+	return computeSpectra( graphSpectrum[g1], graphSpectrum[g2] );
+}
+
+double GraphDissimilarity::computeSpectra( int s1, int s2 )
+{
+	// Same structure, same spectrum
+	if(s1 == s2) return 0;
 
-	VectorXd lamda = eigenvalues[g1];
-	VectorXd mu = eigenvalues[g2];
+	const VectorXd & lamda = eigenvalues[s1];
+	const VectorXd & mu = eigenvalues[s2];
 
-	MatrixXd u = eigenvectors[g1];
-	MatrixXd v = eigenvectors[g2];
+	// All eigenvector dot products at once
+	MatrixXd dotproducts = eigenvectors[s1].transpose() * eigenvectors[s2];
 
-	for(int i = 0; i < N; i++)
+	double d = 0;
+
+	for(int j = 0; j < N; j++)
 	{
-		for(int j = 0; j < N; j++)
+		for(int i = 0; i < N; i++)
 		{
 			double sum = (lamda[i] + mu[j]);
 			if(sum == 0) continue;
 
-			double quotientTerm = pow(lamda[i] - mu[j], 2) / sum;
-			double dotproductTerm = pow(u.col(i).dot(v.col(j)), 2);
+			double diff = lamda[i] - mu[j];
+			double quotientTerm = (diff * diff) / sum;
+			double dotproductTerm = dotproducts(i,j) * dotproducts(i,j);
 			d += quotientTerm * dotproductTerm;
 		}
 	}
@@ -91,9 +166,20 @@ QVector< QPair<double,double> > GraphDissimilarity::computeDissimilarPairs( int
 {
 	QVector< QPair<double,double> > scores;
 
+	// Only compare distinct spectra
+	QVector<int> spectra = graphSpectrum.mid( startidx ).toList().toSet().toList().toVector();
+	QVector< QPair<double,double> > spectraScores( eigenvalues.size() );
+
+	#pragma omp parallel for
+	for(int k = 0; k < spectra.size(); k++)
+	{
+		int s = spectra[k];
+		spectraScores[s] = qMakePair(computeSpectra(graphSpectrum[0], s), computeSpectra(graphSpectrum[1], s));
+	}
+
 	for(int i = startidx; i < graphs.size(); i++)
 	{
-		scores.push_back( qMakePair(compute(0, i), compute(1, i)) );
+		scores.push_back( spectraScores[ graphSpectrum[i] ] );
 	}
 
 	// Normalize both
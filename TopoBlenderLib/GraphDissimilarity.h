@@ -7,6 +7,7 @@ class GraphDissimilarity
 public:
 	GraphDissimilarity( Structure::Graph * graphInstance );
     void addGraph( Structure::Graph * g );
+	void addGraph( Structure::ActualGraphView & view );
 	void addGraphs( QVector<Structure::Graph*> fromGraphs );
 
     // Locals
@@ -15,16 +16,23 @@ public:
 
 	// Input:
     QVector<Structure::Graph*> graphs;
-    
-	// Eigen decomposition of the normalized Laplacian matrix of input graphs
+
+	// Eigen decomposition of the normalized Laplacian matrix, one per distinct adjacency structure
 	QVector< VectorXd > eigenvalues;
 	QVector< MatrixXd > eigenvectors;
 
+	// Input graph index => decomposition index
+	QVector<int> graphSpectrum;
+	QHash<QByteArray, int> spectrumCache;
+
 	// Compute dissimilarity between two graphs of input
 	double compute( int g1, int g2 );
+	double computeSpectra( int s1, int s2 );
 	QVector<double> computeDissimilar( int gidx, int startidx = 2 );
 	QVector< QPair<double,double> > computeDissimilarPairs( int startidx = 2 );
 
+	void addStructure( Structure::Graph * g, const QVector<bool> & isPresent, const QVector< QSet<int> > & adj );
+
     // DEBUG:
     void outputResults();
 	static Structure::Graph * fromAdjFile(QString filename);
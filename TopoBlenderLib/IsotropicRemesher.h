@@ -1,4 +1,6 @@
 #include <float.h>
+#include <vector>
+#include <algorithm>
 #include "SurfaceMeshHelper.h"
 
 #define M_PI       3.14159265358979323846
@@ -7,7 +9,6 @@ struct IsotropicRemesher{
 
 	Vector3VertexProperty points;
 	BoolEdgeProperty efeature;
-	NanoKdTree kdtree;
 
 	template <class T>
 	static inline T deg_to_rad(const T& _angle)
@@ -171,20 +172,168 @@ struct IsotropicRemesher{
 		return (_nearestPoint - _p).squaredNorm();
 	}
 
+	// Bounding volume hierarchy over the triangles of the input surface, for exact closest point queries
+	struct SurfaceBVH{
+		struct BVHNode{
+			Vector3 bmin, bmax;
+			int left, right;	// children, -1 for leaves
+			int first, count;	// triangle range of leaves
+		};
+
+		std::vector<Vector3> corners;	// three per triangle
+		std::vector<int> faces;
+		std::vector<BVHNode> nodes;
+
+		struct CentroidLess{
+			const std::vector<Vector3> * centroids; int axis;
+			bool operator()( int a, int b ) const { return (*centroids)[a][axis] < (*centroids)[b][axis]; }
+		};
+
+		void build( SurfaceMeshModel * m )
+		{
+			Vector3VertexProperty pts = m->vertex_property<Vector3>( VPOINT );
+
+			std::vector<Vector3> tris;
+			std::vector<int> triFaces;
+
+			// Fan triangulation, degenerate triangles are left out
+			foreach(Face f, m->faces())
+			{
+				std::vector<Vector3> poly;
+				SurfaceMeshModel::Vertex_around_face_circulator vit = m->vertices(f), vend = vit;
+				do{ poly.push_back( pts[vit] ); } while(++vit != vend);
+
+				for(int i = 1; i + 1 < (int)poly.size(); i++)
+				{
+					if( cross(poly[i] - poly[0], poly[i+1] - poly[0]).squaredNorm() < FLT_MIN ) continue;
+
+					tris.push_back(poly[0]); tris.push_back(poly[i]); tris.push_back(poly[i+1]);
+					triFaces.push_back( f.idx() );
+				}
+			}
+
+			int N = triFaces.size();
+			std::vector<Vector3> centroids( N );
+			std::vector<int> order( N );
+			for(int i = 0; i < N; i++){
+				centroids[i] = (tris[i*3] + tris[i*3+1] + tris[i*3+2]) / 3.0;
+				order[i] = i;
+			}
+
+			nodes.clear();
+			if( N ) buildNode(0, N, order, centroids, tris);
+
+			// Store triangles in leaf order
+			corners.resize( N * 3 );
+			faces.resize( N );
+			for(int i = 0; i < N; i++){
+				for(int k = 0; k < 3; k++) corners[i*3+k] = tris[order[i]*3+k];
+				faces[i] = triFaces[order[i]];
+			}
+		}
+
+		int buildNode( int first, int count, std::vector<int> & order, const std::vector<Vector3> & centroids, const std::vector<Vector3> & tris )
+		{
+			int idx = nodes.size();
+			nodes.push_back( BVHNode() );
+
+			Vector3 bmin(DBL_MAX, DBL_MAX, DBL_MAX), bmax(-DBL_MAX, -DBL_MAX, -DBL_MAX);
+			Vector3 cmin = bmin, cmax = bmax;
+			for(int i = first; i < first + count; i++)
+			{
+				for(int k = 0; k < 3; k++){
+					bmin = bmin.cwiseMin( tris[order[i]*3+k] );
+					bmax = bmax.cwiseMax( tris[order[i]*3+k] );
+				}
+				cmin = cmin.cwiseMin( centroids[order[i]] );
+				cmax = cmax.cwiseMax( centroids[order[i]] );
+			}
+
+			nodes[idx].bmin = bmin; nodes[idx].bmax = bmax;
+			nodes[idx].left = nodes[idx].right = -1;
+			nodes[idx].first = first; nodes[idx].count = count;
+
+			if( count <= 4 ) return idx;
+
+			// Median split on the longest axis of the centroids
+			int axis = 0;
+			Vector3 extent = cmax - cmin;
+			if( extent[1] > extent[axis] ) axis = 1;
+			if( extent[2] > extent[axis] ) axis = 2;
+
+			CentroidLess less; less.centroids = &centroids; less.axis = axis;
+			int half = count / 2;
+			std::nth_element( order.begin() + first, order.begin() + first + half, order.begin() + first + count, less );
+
+			int left = buildNode( first, half, order, centroids, tris );
+			int right = buildNode( first + half, count - half, order, centroids, tris );
+			nodes[idx].left = left;
+			nodes[idx].right = right;
+
+			return idx;
+		}
+
+		static inline double boxDistSqr( const BVHNode & n, const Vector3 & p )
+		{
+			double d = 0;
+			for(int k = 0; k < 3; k++){
+				double v = std::max( std::max(n.bmin[k] - p[k], 0.0), p[k] - n.bmax[k] );
+				d += v * v;
+			}
+			return d;
+		}
+
+		/// closest point on the surface, returns the face index or -1 for an empty tree
+		int closestPoint( const Vector3 & p, Vector3 & nearest, double & distSqr ) const
+		{
+			int best = -1;
+			distSqr = DBL_MAX;
+			nearest = p;
+			if( nodes.empty() ) return best;
+
+			int stack[128], top = 0;
+			stack[top++] = 0;
+
+			while( top )
+			{
+				const BVHNode & n = nodes[ stack[--top] ];
+				if( boxDistSqr(n, p) >= distSqr ) continue;
+
+				if( n.left < 0 )
+				{
+					for(int i = n.first; i < n.first + n.count; i++)
+					{
+						Vector3 ptn;
+						double d = distPointTriangleSquared( p, corners[i*3], corners[i*3+1], corners[i*3+2], ptn );
+						if( d >= 0 && d < distSqr ){
+							distSqr = d;
+							nearest = ptn;
+							best = faces[i];
+						}
+					}
+					continue;
+				}
+
+				// Visit the closer child first
+				int a = n.left, b = n.right;
+				if( boxDistSqr(nodes[a], p) > boxDistSqr(nodes[b], p) ) std::swap(a, b);
+				stack[top++] = b;
+				stack[top++] = a;
+			}
+
+			return best;
+		}
+	};
+
+	SurfaceBVH bvh;
+
 	void remesh(double targetEdgeLength, int numIterations )
 	{
 		const double low  = (4.0 / 5.0) * targetEdgeLength;
 		const double high = (4.0 / 3.0) * targetEdgeLength;
 
-		// Copy original mesh
-		SurfaceMeshModel* copy = new SurfaceMeshModel(mesh->path,"original");
-		copy->read( mesh->path.toStdString() );
-
-		// Build KD-tree
-		kdtree.cloud.pts.clear();
-		foreach(Vertex v, mesh->vertices())
-			kdtree.addPoint(points[v]);
-		kdtree.build();
+		// Original surface for projection
+		bvh.build( mesh );
 
 		for(int i = 0; i < numIterations; i++)
 		{
@@ -192,7 +341,7 @@ struct IsotropicRemesher{
 			collapseShortEdges(low, high);
 			equalizeValences();
 			tangentialRelaxation();
-			//projectToSurface(copy);
+			projectToSurface();
 		}
 	}
 
@@ -383,16 +532,17 @@ struct IsotropicRemesher{
 		Vector3VertexProperty q = mesh->vertex_property<Vector3>("v:q");
 		Vector3VertexProperty normal = mesh->vertex_property<Vector3>(VNORMAL);
 
-		SurfaceMeshModel::Vertex_iterator v_it;
-		SurfaceMeshModel::Vertex_iterator v_end = mesh->vertices_end();
+		int numVertices = mesh->n_vertices();
 
 		//first compute barycenters
-		for (v_it = mesh->vertices_begin(); v_it != v_end; ++v_it){
+		#pragma omp parallel for
+		for (int i = 0; i < numVertices; i++){
+			Vertex v(i);
 
             Vector3 tmp(0,0,0);
 			uint N = 0;
 
-			foreach( Halfedge hvit, mesh->onering_hedges(v_it) )
+			foreach( Halfedge hvit, mesh->onering_hedges(v) )
 			{
 				tmp += points[ mesh->to_vertex(hvit) ];
 				N++;
@@ -401,92 +551,61 @@ struct IsotropicRemesher{
 			if (N > 0)
 				tmp /= (double) N;
 
-			q[v_it] = tmp;
+			q[v] = tmp;
 		}
 
 		//move to new position
-		for (v_it = mesh->vertices_begin(); v_it != v_end; ++v_it)
+		#pragma omp parallel for
+		for (int i = 0; i < numVertices; i++)
 		{
-			if ( !isBoundary(v_it) && !isFeature(v_it) )
+			Vertex v(i);
+
+			if ( !isBoundary(v) && !isFeature(v) )
 			{
-				//Vector3 newPos = q[v_it] + (dot(normal[v_it], (points[v_it] - q[v_it]) ) * normal[v_it]);
-				points[v_it] = q[v_it];
+				//Vector3 newPos = q[v] + (dot(normal[v], (points[v] - q[v]) ) * normal[v]);
+				points[v] = q[v];
 			}
 		}
 
 		mesh->remove_vertex_property(q);
 	}
 
-	Vector3 findNearestPoint(SurfaceMeshModel * orginal_mesh, const Vector3& _point, SurfaceMeshModel::Face& _fh, double* _dbest)
+	Vector3 findNearestPoint(const Vector3& _point, SurfaceMeshModel::Face& _fh, double* _dbest)
 	{
-		Vector3VertexProperty orig_points = orginal_mesh->vertex_property<Vector3>( VPOINT );
-
-		Vector3  p_best = orig_points[ Vertex(0) ];
-		SurfaceMeshModel::Scalar d_best = (_point - p_best).squaredNorm();
-
-		SurfaceMeshModel::Face fh_best;
-
-		// exhaustive search
-		SurfaceMeshModel::Face_iterator cf_it  = orginal_mesh->faces_begin();
-		SurfaceMeshModel::Face_iterator cf_end = orginal_mesh->faces_end();
-
-		KDResults matches;
-		kdtree.k_closest(_point, 32, matches);
-
-		foreach(KDResultPair match, matches)
-		{
-			int vi = match.first;
-
-			foreach(Halfedge h, orginal_mesh->onering_hedges(Vertex(vi)))
-			{
-				SurfaceMeshModel::Vertex_around_face_circulator cfv_it = orginal_mesh->vertices( orginal_mesh->face(h) );
+		Vector3 p_best;
+		double d_best;
 
-				// Assume triangular
-				const Vector3& pt0 = orig_points[   cfv_it];
-				const Vector3& pt1 = orig_points[ ++cfv_it];
-				const Vector3& pt2 = orig_points[ ++cfv_it];
-
-				Vector3 ptn;
-
-				SurfaceMeshModel::Scalar d = distPointTriangleSquared( _point, pt0, pt1, pt2, ptn );
-
-				if( d < d_best)
-				{
-					d_best = d;
-					p_best = ptn;
-
-					fh_best = cf_it;
-				}
-			}
-		}
+		int face = bvh.closestPoint( _point, p_best, d_best );
 
 		// return face
-		_fh = fh_best;
+		_fh = SurfaceMeshModel::Face( face );
 
 		// return distance
 		if(_dbest)
-			*_dbest = sqrt(d_best);
+			*_dbest = (face < 0) ? 0 : sqrt(d_best);
 
 		return p_best;
 	}
 
-	void projectToSurface(SurfaceMeshModel * orginal_mesh )
+	void projectToSurface()
 	{
-		SurfaceMeshModel::Vertex_iterator v_it;
-		SurfaceMeshModel::Vertex_iterator v_end = mesh->vertices_end();
+		int numVertices = mesh->n_vertices();
 
-		for (v_it = mesh->vertices_begin(); v_it != v_end; ++v_it)
+		#pragma omp parallel for schedule(dynamic, 64)
+		for (int i = 0; i < numVertices; i++)
 		{
-			if (isBoundary(v_it)) continue;
-			if ( isFeature(v_it)) continue;
+			Vertex v(i);
+
+			if (isBoundary(v)) continue;
+			if ( isFeature(v)) continue;
 
-			Vector3 p = points[v_it];
+			Vector3 p = points[v];
 			SurfaceMeshModel::Face fhNear;
 			double distance;
 
-			Vector3 pNear = findNearestPoint(orginal_mesh, p, fhNear, &distance);
+			Vector3 pNear = findNearestPoint(p, fhNear, &distance);
 
-			points[v_it] = pNear;
+			points[v] = pNear;
 		}
 	}
 
@@ -0,0 +1,311 @@
+#include <QFile>
+#include <QByteArray>
+#include <cstring>
+
+#include "ObjReader.h"
+
+// OpenMP
+#include <omp.h>
+
+// Files smaller than this are parsed by one thread
+#define OBJ_CHUNK_SIZE (1 << 20)
+
+namespace{
+
+	struct ObjChunk{
+		std::vector<Vector3> points;
+		std::vector<int> faceSize;
+		std::vector<int> faceIndices;
+		std::vector<int> relative;		// negative indices, counted from the chunk's first vertex
+	};
+
+	const double powersOf10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+	inline bool isBlank( char c ){ return c == ' ' || c == '\t' || c == '\r'; }
+	inline bool isDigit( char c ){ return c >= '0' && c <= '9'; }
+
+	inline const char * skipBlank( const char * p, const char * end )
+	{
+		while(p < end && isBlank(*p)) p++;
+		return p;
+	}
+
+	// Exactly rounded whenever the digits and the power of ten fit a double, the rest goes through Qt's C locale
+	inline bool parseDouble( const char *& p, const char * end, double & value )
+	{
+		const char * start = p;
+
+		bool isNegative = false;
+		if(p < end && (*p == '-' || *p == '+')) isNegative = (*p++ == '-');
+
+		quint64 mantissa = 0;
+		int digits = 0, exponent = 0;
+		bool hasDigits = false;
+
+		for(; p < end && isDigit(*p); p++, hasDigits = true)
+		{
+			if(digits < 19){
+				mantissa = mantissa * 10 + (*p - '0');
+				if(mantissa) digits++;
+			}
+			else exponent++;
+		}
+
+		if(p < end && *p == '.')
+		{
+			for(p++; p < end && isDigit(*p); p++, hasDigits = true)
+			{
+				if(digits < 19){
+					mantissa = mantissa * 10 + (*p - '0');
+					if(mantissa) digits++;
+					exponent--;
+				}
+			}
+		}
+
+		if(!hasDigits){ p = start; return false; }
+
+		if(p < end && (*p == 'e' || *p == 'E'))
+		{
+			const char * e = p + 1;
+
+			bool isExpNegative = false;
+			if(e < end && (*e == '-' || *e == '+')) isExpNegative = (*e++ == '-');
+
+			if(e < end && isDigit(*e))
+			{
+				int expValue = 0;
+				for(; e < end && isDigit(*e); e++)
+					if(expValue < 10000) expValue = expValue * 10 + (*e - '0');
+
+				exponent += isExpNegative ? -expValue : expValue;
+				p = e;
+			}
+		}
+
+		if(digits <= 15 && exponent >= -22 && exponent <= 22)
+		{
+			value = double(mantissa);
+			value = (exponent < 0) ? value / powersOf10[-exponent] : value * powersOf10[exponent];
+			if(isNegative) value = -value;
+		}
+		else
+			value = QByteArray(start, int(p - start)).toDouble();
+
+		return true;
+	}
+
+	inline bool parseInt( const char *& p, const char * end, int & value )
+	{
+		bool isNegative = false;
+		if(p < end && (*p == '-' || *p == '+')) isNegative = (*p++ == '-');
+
+		if(p >= end || !isDigit(*p)) return false;
+
+		value = 0;
+		for(; p < end && isDigit(*p); p++) value = value * 10 + (*p - '0');
+		if(isNegative) value = -value;
+
+		return true;
+	}
+
+	void parseChunk( const char * p, const char * end, ObjChunk & chunk )
+	{
+		while(p < end)
+		{
+			const char * lineEnd = (const char *) memchr(p, '\n', end - p);
+			if(!lineEnd) lineEnd = end;
+
+			const char * q = skipBlank(p, lineEnd);
+
+			// Position
+			if(q + 1 < lineEnd && q[0] == 'v' && isBlank(q[1]))
+			{
+				q++;
+
+				Vector3 point(0,0,0);
+				for(int i = 0; i < 3; i++)
+				{
+					q = skipBlank(q, lineEnd);
+					if(!parseDouble(q, lineEnd, point[i])) break;
+				}
+
+				chunk.points.push_back( point );
+			}
+
+			// Face, corners are "v", "v/vt", "v//vn" or "v/vt/vn"
+			else if(q + 1 < lineEnd && q[0] == 'f' && isBlank(q[1]))
+			{
+				q++;
+
+				int first = (int)chunk.faceIndices.size(), firstRelative = (int)chunk.relative.size();
+				bool isValid = true;
+
+				while(true)
+				{
+					q = skipBlank(q, lineEnd);
+
+					int idx = 0;
+					if(!parseInt(q, lineEnd, idx)) break;
+					while(q < lineEnd && !isBlank(*q)) q++;
+
+					if(idx > 0)
+						chunk.faceIndices.push_back( idx - 1 );
+					else if(idx < 0)
+					{
+						chunk.relative.push_back( (int)chunk.faceIndices.size() );
+						chunk.faceIndices.push_back( (int)chunk.points.size() + idx );
+					}
+					else
+						isValid = false;
+				}
+
+				int count = (int)chunk.faceIndices.size() - first;
+
+				if(isValid && count >= 3)
+					chunk.faceSize.push_back( count );
+				else
+				{
+					chunk.faceIndices.resize( first );
+					chunk.relative.resize( firstRelative );
+				}
+			}
+
+			p = lineEnd + 1;
+		}
+	}
+}
+
+bool ObjReader::parse( QString filename, ObjData & data )
+{
+	data = ObjData();
+
+	QFile file(filename);
+	if(!file.open(QIODevice::ReadOnly)) return false;
+
+	qint64 size = file.size();
+
+	// Mapped when the platform allows it, read otherwise
+	QByteArray buffer;
+	const char * begin = (size > 0) ? (const char *) file.map(0, size) : NULL;
+	if(!begin)
+	{
+		buffer = file.readAll();
+		begin = buffer.constData();
+		size = buffer.size();
+	}
+	const char * end = begin + size;
+
+	// Chunks start right after a line end
+	int numChunks = qMax(1, qMin(omp_get_max_threads(), int(size / OBJ_CHUNK_SIZE)));
+
+	std::vector<const char *> bounds(numChunks + 1, end);
+	bounds[0] = begin;
+	for(int i = 1; i < numChunks; i++)
+	{
+		const char * p = qMax(bounds[i-1], begin + (size * i) / numChunks);
+		const char * lineEnd = (const char *) memchr(p, '\n', end - p);
+		bounds[i] = lineEnd ? lineEnd + 1 : end;
+	}
+
+	std::vector<ObjChunk> chunks(numChunks);
+
+	#pragma omp parallel for schedule(static, 1)
+	for(int i = 0; i < numChunks; i++)
+		parseChunk(bounds[i], bounds[i+1], chunks[i]);
+
+	file.close();
+
+	// Merge, resolving negative indices against each chunk's first vertex
+	int numPoints = 0;
+	for(int i = 0; i < numChunks; i++) numPoints += (int)chunks[i].points.size();
+
+	data.points.reserve(numPoints);
+	data.faceStart.push_back(0);
+
+	int vertexOffset = 0;
+	for(int i = 0; i < numChunks; i++)
+	{
+		ObjChunk & chunk = chunks[i];
+
+		for(int j = 0; j < (int)chunk.relative.size(); j++)
+			chunk.faceIndices[chunk.relative[j]] += vertexOffset;
+
+		data.points.insert(data.points.end(), chunk.points.begin(), chunk.points.end());
+		vertexOffset += (int)chunk.points.size();
+
+		// Faces pointing outside of the file are dropped
+		int corner = 0;
+		for(int f = 0; f < (int)chunk.faceSize.size(); f++)
+		{
+			int faceSize = chunk.faceSize[f];
+
+			bool isValid = true;
+			for(int k = 0; k < faceSize; k++){
+				int idx = chunk.faceIndices[corner + k];
+				if(idx < 0 || idx >= numPoints) isValid = false;
+			}
+
+			if(isValid)
+			{
+				data.faceIndices.insert(data.faceIndices.end(), chunk.faceIndices.begin() + corner, chunk.faceIndices.begin() + corner + faceSize);
+				data.faceStart.push_back( (int)data.faceIndices.size() );
+			}
+
+			corner += faceSize;
+		}
+
+		std::vector<Vector3>().swap(chunk.points);
+	}
+
+	return true;
+}
+
+bool ObjReader::read( SurfaceMesh::Model * mesh, QString filename )
+{
+	ObjData data;
+	if(!parse(filename, data)) return false;
+
+	int numPoints = (int)data.points.size(), numFaces = data.numFaces();
+	mesh->reserve(numPoints, numPoints + numFaces, numFaces);
+
+	for(int i = 0; i < numPoints; i++)
+		mesh->add_vertex( data.points[i] );
+
+	std::vector<Vertex> verts;
+	for(int f = 0; f < numFaces; f++)
+	{
+		verts.clear();
+		for(int k = data.faceStart[f]; k < data.faceStart[f+1]; k++)
+			verts.push_back( Vertex(data.faceIndices[k]) );
+		mesh->add_face(verts);
+	}
+
+	return true;
+}
+
+bool ObjReader::readSoup( SurfaceMesh::Model * mesh, QString filename )
+{
+	ObjData data;
+	if(!parse(filename, data)) return false;
+
+	int numFaces = data.numFaces(), numTriangles = (int)data.faceIndices.size() - 2 * numFaces;
+	mesh->reserve(numTriangles * 3, numTriangles * 3, numTriangles);
+
+	std::vector<Vertex> verts(3);
+	for(int f = 0; f < numFaces; f++)
+	{
+		int first = data.faceStart[f];
+
+		for(int k = first + 1; k + 1 < data.faceStart[f+1]; k++)
+		{
+			verts[0] = mesh->add_vertex( data.points[data.faceIndices[first]] );
+			verts[1] = mesh->add_vertex( data.points[data.faceIndices[k]] );
+			verts[2] = mesh->add_vertex( data.points[data.faceIndices[k+1]] );
+			mesh->add_face(verts);
+		}
+	}
+
+	return true;
+}
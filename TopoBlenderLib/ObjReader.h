@@ -0,0 +1,34 @@
+#pragma once
+
+#include <QString>
+#include <vector>
+
+#include "SurfaceMeshModel.h"
+
+using namespace SurfaceMesh;
+
+// Wavefront OBJ input. The file is memory mapped, cut into chunks at line ends and the chunks are
+// parsed in parallel with a locale independent number parser. Only positions and faces are read,
+// texture and normal indices of a face corner are skipped
+class ObjReader
+{
+public:
+	// Positions and polygons, indices are zero based
+	struct ObjData{
+		std::vector<Vector3> points;
+		std::vector<int> faceStart;		// offsets into faceIndices, one past the last face at the end
+		std::vector<int> faceIndices;
+
+		int numFaces() const { return faceStart.empty() ? 0 : (int)faceStart.size() - 1; }
+	};
+
+	static bool parse( QString filename, ObjData & data );
+
+	// Indexed mesh, faces share their vertices
+	static bool read( SurfaceMesh::Model * mesh, QString filename );
+
+	// Triangle soup for inputs that are not manifold, polygons are split as fans and every triangle gets its own vertices
+	static bool readSoup( SurfaceMesh::Model * mesh, QString filename );
+
+	static bool isObj( QString filename ){ return filename.endsWith(".obj", Qt::CaseInsensitive); }
+};
@@ -1,7 +1,9 @@
 #include <QStack>
+#include <algorithm>
 
 #include "Relink.h"
 #include "Scheduler.h"
+#include "Tracing.h"
 
 #include "MinBall.h"
 
@@ -10,83 +12,206 @@ Relink::Relink(Scheduler *scheduler)
     this->s = scheduler;
     this->activeGraph = scheduler->activeGraph;
     this->targetGraph = scheduler->targetGraph;
+	this->isTracking = false;
+	this->propagationIndex = 0;
+	this->isPlanTracked = false;
 }
 
-void Relink::execute()
+bool Relink::updateTasks()
+{
+	if( tasks == s->tasks ) return false;
+
+	tasks = s->tasks;
+	taskIndex.clear();
+	for(int i = 0; i < tasks.size(); i++){
+		QString nid = tasks[i]->node()->id;
+		if( !taskIndex.contains(nid) ) taskIndex[nid] = i;
+	}
+
+	constraints.resize( tasks.size() );
+	return true;
+}
+
+bool Relink::updateAdjacency( bool isForced )
 {
-	// initial
-	constraints.clear();
-	foreach (Task* t, s->tasks) 
+	// Links are only rewired in place, so comparing endpoints is enough
+	bool isSame = !isForced && (adjacencyLinks == activeGraph->edges);
+	for(int i = 0; isSame && i < adjacencyLinks.size(); i++)
+		isSame = adjacencyEnds[i*2] == adjacencyLinks[i]->n1 && adjacencyEnds[i*2+1] == adjacencyLinks[i]->n2;
+	if( isSame ) return false;
+
+	adjacencyLinks = activeGraph->edges;
+	adjacencyEnds.resize( adjacencyLinks.size() * 2 );
+
+	adjacency.clear();
+	adjacency.resize( tasks.size() );
+
+	for(int i = 0; i < adjacencyLinks.size(); i++)
 	{
-		t->property["relinked"] = false;
-		t->property["propagated"] = false;
+		Structure::Link * link = adjacencyLinks[i];
+		adjacencyEnds[i*2] = link->n1;
+		adjacencyEnds[i*2+1] = link->n2;
+
+		// Self referring edges should be ignored
+		if(link->n1->id == link->n2->id) continue;
+
+		int i1 = taskIndex.value(link->n1->id, -1), i2 = taskIndex.value(link->n2->id, -1);
+		if(i1 < 0 || i2 < 0) continue;
+
+		adjacency[i1].push_back( Neighbour(link, i2) );
+		adjacency[i2].push_back( Neighbour(link, i1) );
 	}
 
+	return true;
+}
+
+void Relink::buildPlan()
+{
+	int N = tasks.size();
+	propagated.fill(false, N);
+	inLevel.fill(false, N);
+	constraintTasks.resize( N );
+	for(int i = 0; i < N; i++){ constraints[i].clear(); constraintTasks[i].clear(); }
+
+	// Every task is fixed once on a new plan
+	settledPoints.clear();
+	settledPoints.resize( N );
+	lastInputs.clear();
+	lastInputs.resize( N );
+
 	// Tracking
 	propagationGraph.clear();
 	propagationIndex = 0;
+	isPlanTracked = isTracking;
 
 	// Find propagation levels via BFS
-	QVector< QVector<Task*> > propagationLevel;
-	propagationLevel.resize(1);
-
-	QVector<QString> activeNodeIDs = activeGraph->property["activeTasks"].value< QVector<QString> >();
-
-	// Initial propagation level
-	foreach (QString nID, activeNodeIDs){
-		Task* task = s->getTaskFromNodeID(nID);
-		if ( doesPropagate(task) ){
-			propagationLevel[0].push_back(task);
-			task->property["propagated"] = true;
-		}
-	}
+	propagationLevel.clear();
+	propagationLevel.push_back( planSources );
+	foreach(int ti, planSources) propagated.setBit(ti);
 
 	forever{
-		QVector<Task *> curLevel;
+		QVector<int> curLevel;
 
 		// Visit nodes in levels
-		foreach(Task* task, propagationLevel.back())
+		foreach(int ti, propagationLevel.back())
 		{
-			foreach(Structure::Link* link, activeGraph->getEdges(task->nodeID))
+			foreach(const Neighbour & nb, adjacency[ti])
 			{
-				// Self referring edges should be ignored
-				if(link->n1->id == link->n2->id) continue;
+				int oi = nb.second;
+				if( propagated.testBit(oi) ) continue;
 
-				Structure::Node * other = link->otherNode(task->nodeID);
-				Task * otherTask = s->getTaskFromNodeID(other->id);
-				if (otherTask->property["propagated"].toBool()) continue;
-
-				if(!curLevel.contains(otherTask)) curLevel.push_back( otherTask );
+				if( !inLevel.testBit(oi) ){
+					inLevel.setBit(oi);
+					curLevel.push_back(oi);
+				}
 
 				// Add constraint
-				constraints[ otherTask ].push_front( LinkConstraint(link, task, otherTask) );
+				constraints[oi].push_back( LinkConstraint(nb.first, tasks[ti], tasks[oi]) );
+				constraintTasks[oi].push_back( ti );
 
 				// Tracking
-				propagationGraph[task->nodeID].push_back(qMakePair(otherTask->nodeID, propagationIndex++));
+				if( isTracking )
+					propagationGraph[tasks[ti]->nodeID].push_back(qMakePair(tasks[oi]->nodeID, propagationIndex++));
 			}
 		}
 
 		// Mark elements in level as visited
-		foreach(Task* task, propagationLevel.back())
-				task->property["propagated"] = true;
+		foreach(int ti, propagationLevel.back()) propagated.setBit(ti);
+		foreach(int ti, curLevel) inLevel.clearBit(ti);
 
 		if(curLevel.isEmpty()) break;
 		propagationLevel.push_back( curLevel );
 	}
 
-	// Apply constraints
+	// Latest constraints come first
+	for(int i = 0; i < N; i++){
+		std::reverse(constraints[i].begin(), constraints[i].end());
+		std::reverse(constraintTasks[i].begin(), constraintTasks[i].end());
+	}
+}
+
+QVector<double> Relink::taskInputs( int ti )
+{
+	// Everything 'fixTask' reads besides node positions
+	Task * task = tasks[ti];
+	QString nid = task->node()->id;
+
+	QVector<double> inputs;
+	inputs << task->type << task->isDone << task->isReady;
+
+	foreach(LinkConstraint c, constraints[ti])
+	{
+		Structure::Link * link = c.link;
+		Vector3 delta = link->property["blendedDelta"].value<Vector3>();
+		Vector4d coord = link->getCoord(nid).front(), coordOther = link->getCoordOther(nid).front();
+
+		inputs << c.task->isDone << c.task->isReady << link->property["path"].value< QVector< GraphDistance::PathPointPair > >().size();
+		for(int i = 0; i < 3; i++) inputs << delta[i];
+		for(int i = 0; i < 4; i++) inputs << coord[i] << coordOther[i];
+	}
+
+	return inputs;
+}
+
+void Relink::execute()
+{
+	TRACE_ZONE("Relink::execute");
+
+	isTracking = s->property["trackRelink"].toBool();
+
+	bool isChanged = updateTasks();
+	isChanged = updateAdjacency( isChanged ) || isChanged;
+
+	// Initial propagation level
+	QVector<int> sources;
+	foreach (QString nID, activeGraph->property["activeTasks"].value< QVector<QString> >()){
+		int ti = taskIndex.value(nID, -1);
+		if ( ti >= 0 && doesPropagate(tasks[ti]) ) sources.push_back(ti);
+	}
+
+	// Propagation only depends on sources and links, reuse it otherwise
+	if( isChanged || sources != planSources || (isTracking && !isPlanTracked) )
+	{
+		planSources = sources;
+		buildPlan();
+	}
+
+	// Apply constraints, skipping tasks whose node and inputs are as the last pass left them
+	moved.fill(false, tasks.size());
+
 	for(int i = 0; i < propagationLevel.size(); i++)
 	{
-		foreach(Task* task, propagationLevel[i]) 
+		foreach(int ti, propagationLevel[i]) 
 		{
-			fixTask(task);
+			Task * task = tasks[ti];
+			Structure::Node * n = task->node();
+			bool isSplitting = n->property["taskTypeReal"].toInt() == Task::SPLIT && !task->isReady;
+
+			bool isDirty = isSplitting || (n->controlPoints() != settledPoints[ti]);
+			foreach(int oi, constraintTasks[ti]) isDirty = isDirty || moved.testBit(oi);
+
+			QVector<double> inputs = taskInputs(ti);
+			if( inputs != lastInputs[ti] ) isDirty = true;
+			lastInputs[ti] = inputs;
+
+			if( !isDirty ) continue;
+
+			fixTask(ti);
+
+			Array1D_Vector3 points = n->controlPoints();
+			if( points != settledPoints[ti] ) moved.setBit(ti);
+			settledPoints[ti] = points;
 
 			// Override relinking for splitting case
-			if(task->node()->property["taskTypeReal"].toInt() == Task::SPLIT && !task->isReady){
+			if( isSplitting ){
 				foreach(QString sibling, activeGraph->groupsOf(task->nodeID).back()){
-					Task * otherTask = s->getTaskFromNodeID( sibling );
+					int si = taskIndex.value(sibling, -1);
+					if(si < 0) continue;
+					Task * otherTask = tasks[si];
 					if(otherTask->node()->property["taskTypeReal"].toInt() == Task::SPLIT && !otherTask->isReady)
 					{
+						moved.setBit(si);
+
 						Structure::Node * fromNode = task->node();
 						Structure::Node * toNode = otherTask->node();
 
@@ -104,7 +229,7 @@ void Relink::execute()
 	}
 
 	// Tracking
-	if( true ){
+	if( isTracking ){
 		QStringList graph;
 		graph << "digraph G{";
 		foreach(QString n1, propagationGraph.keys()){
@@ -120,14 +245,12 @@ void Relink::execute()
 	}
 }
 
-void Relink::fixTask( Task* task )
+void Relink::fixTask( int taskIdx )
 {
-	task->property["relinked"] = true;
-
+	Task * task = tasks[taskIdx];
 	Structure::Node * n = task->node();
 
-	QVector<LinkConstraint> consts;
-	if ( constraints.contains(task) ) consts = constraints[task];
+	QVector<LinkConstraint> consts = constraints[taskIdx];
 	if(!consts.size()) return;
 
 	// Useful for debugging:
@@ -2,6 +2,7 @@
 #include "StructureGraph.h"
 #include "Task.h"
 #include <QQueue>
+#include <QBitArray>
 
 struct LinkConstraint{
     Structure::Link *link;
@@ -9,7 +10,7 @@ struct LinkConstraint{
     LinkConstraint(Structure::Link * l=NULL, Task* t=NULL, Task* otherT=NULL)
     { link = l; task = t; otherTask = otherT; }
 };
-typedef QMap< Task*, QVector<LinkConstraint> > TasksConstraints;
+typedef QVector< QVector<LinkConstraint> > TasksConstraints;
 
 class Scheduler;
 
@@ -20,20 +21,51 @@ struct Relink
     Scheduler * s;
     Structure::Graph *activeGraph, *targetGraph;
 	
+	// Constraints on each task, indexed as in 'tasks'
     TasksConstraints constraints;
 
-	// Tracking
+	// Tracking, only when the scheduler property "trackRelink" is set
+	bool isTracking;
 	typedef QPair<QString,int> PropagationEdge;
 	typedef QVector< PropagationEdge > PropagationEdges;
 	QMap< QString, PropagationEdges > propagationGraph;
 	int propagationIndex;
 
 	void execute();
-	void fixTask( Task* task );
+	void fixTask( int taskIdx );
 
 	// Helpers
 	void moveByConstraints( Structure::Node * n, QVector<LinkConstraint> consts );
 	Vector3 getToDelta( Structure::Link * link, QString otherID );
 	bool doesPropagate( Task* task );
 	bool isInActiveGroup( Task* task );
+
+private:
+	// Compact task graph, kept across timesteps
+	typedef QPair<Structure::Link*, int> Neighbour;
+	QVector<Task*> tasks;
+	QHash<QString, int> taskIndex;
+	QVector< QVector<Neighbour> > adjacency;
+	QVector<Structure::Link*> adjacencyLinks;
+	QVector<Structure::Node*> adjacencyEnds;
+
+	// Propagation levels, rebuilt only when the sources or the links change
+	QVector<int> planSources;
+	QVector< QVector<int> > propagationLevel;
+	QBitArray propagated, inLevel;
+	bool isPlanTracked;
+
+	// Index of the task behind each constraint, same order as 'constraints'
+	QVector< QVector<int> > constraintTasks;
+
+	// Change tracking, a task is only fixed when its own node, its constraints or one of
+	// the tasks it depends on moved since the last pass
+	QVector< Array1D_Vector3 > settledPoints;
+	QVector< QVector<double> > lastInputs;
+	QBitArray moved;
+
+	bool updateTasks();
+	bool updateAdjacency( bool isForced );
+	void buildPlan();
+	QVector<double> taskInputs( int ti );
 };
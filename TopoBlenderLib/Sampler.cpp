@@ -8,6 +8,9 @@ Sampler::Sampler(SurfaceMesh::Model * srcMesh, SamplingMethod samplingMethod)
 		mesh = srcMesh;
 
 	method = samplingMethod;
+
+	seed = rand();
+	counter = 0;
 	
 	mesh->update_face_normals();
 	fnormal = mesh->get_face_property<Vector3>(FNORMAL);
@@ -33,16 +36,33 @@ Sampler::Sampler(SurfaceMesh::Model * srcMesh, SamplingMethod samplingMethod)
         for (fit = mesh->faces_begin(); fit != fend; ++fit)
             fprobability[fit] = farea[fit] / totalMeshArea;
 
-        interval = std::vector<AreaFace>(mesh->n_faces() + 1);
-        interval[0] = AreaFace(0.0, Surface_mesh::Face(0));
-		int i = 0;
-
-		// Compute mesh area in a cumulative manner
-        foreach(Face f, mesh->faces())
-		{
-            interval[f.idx()+1] = AreaFace(interval[i].area + fprobability[f], f);
-			i++;
-		}
+        // Alias table (Vose), each column holds a face and the alias it falls back to
+        int N = mesh->n_faces();
+        aliasProbability = std::vector<double>(N, 1.0);
+        aliasFace = std::vector<int>(N, 0);
+
+        std::vector<double> scaled(N);
+        std::vector<int> small, large;
+        for(int i = 0; i < N; i++)
+        {
+            aliasFace[i] = i;
+            scaled[i] = (totalMeshArea > 0) ? fprobability[Face(i)] * N : 1.0;
+            if(scaled[i] < 1.0) small.push_back(i); else large.push_back(i);
+        }
+
+        while(!small.empty() && !large.empty())
+        {
+            int s = small.back(); small.pop_back();
+            int l = large.back(); large.pop_back();
+
+            aliasProbability[s] = scaled[s];
+            aliasFace[s] = l;
+
+            scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+            if(scaled[l] < 1.0) small.push_back(l); else large.push_back(l);
+        }
+
+        // Left overs are full columns up to round off
 	}
 	else if( method ==  FACE_CENTER )
 	{
@@ -51,22 +71,27 @@ Sampler::Sampler(SurfaceMesh::Model * srcMesh, SamplingMethod samplingMethod)
 }
 
 SamplePoint Sampler::getSample(double weight)
+{
+	return sampleAt(counter++, weight);
+}
+
+SamplePoint Sampler::sampleAt(quint64 index, double weight)
 {
 	SamplePoint sp;
-	double r;
 	double b[3];
 
+	// Four numbers per sample
+	quint64 c = index * 4;
+
 	if( method == RANDOM_BARYCENTRIC )
 	{
-		// r, random point in the area
-		r = uniform();
-
-		// Find corresponding face
-        std::vector<AreaFace>::iterator it = lower_bound(interval.begin(), interval.end(), AreaFace(qMin(r,interval.back().area)));
-        Surface_mesh::Face f = it->f;
+		// Find corresponding face, O(1) in the alias table
+		int N = aliasFace.size();
+		int column = qMin(int(CounterRandom::uniform(seed, c) * N), N - 1);
+		Surface_mesh::Face f( (CounterRandom::uniform(seed, c + 1) < aliasProbability[column]) ? column : aliasFace[column] );
 
 		// Add sample from that face
-		RandomBaricentric(b);
+		RandomBaricentric(b, CounterRandom::uniform(seed, c + 2), CounterRandom::uniform(seed, c + 3));
 
         sp = SamplePoint( getBaryFace(f, b[0], b[1]), fnormal[f], weight, f.idx(), b[0], b[1]);
 	}
@@ -74,7 +99,7 @@ SamplePoint Sampler::getSample(double weight)
 	{
 		int fcount = mesh->n_faces();
 
-		int randTriIndex = (int) (fcount * (((double)rand()) / (double)RAND_MAX)) ;
+		int randTriIndex = (int) (fcount * CounterRandom::uniform(seed, c));
 
 		if( randTriIndex >= fcount )
 			randTriIndex = fcount - 1;
@@ -92,9 +117,13 @@ std::vector<SamplePoint> Sampler::getSamples(int numberSamples, double weight)
 {
     std::vector<SamplePoint> samples(numberSamples);
 
+	quint64 first = counter;
+	counter += numberSamples;
+
+	#pragma omp parallel for
 	for(int i = 0; i < numberSamples; i++)
 	{
-		samples[i] = getSample(weight);
+		samples[i] = sampleAt(first + i, weight);
 	}
 
 	return samples;
@@ -102,9 +131,11 @@ std::vector<SamplePoint> Sampler::getSamples(int numberSamples, double weight)
 
 Vector3 Sampler::getBaryFace( Surface_mesh::Face f, double U, double V )
 {
-    QVector<Vector3> v;
+    // Triangles only, first three corners
+    Vector3 v[3];
+    int i = 0;
     Surface_mesh::Vertex_around_face_circulator vit = mesh->vertices(f),vend=vit;
-    do{ v.push_back(points[vit]); } while(++vit != vend);
+    do{ v[i++] = points[vit]; } while(++vit != vend && i < 3);
 
     if(U == 1.0) return v[1];
     if(V == 1.0) return v[2];
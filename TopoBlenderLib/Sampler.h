@@ -27,14 +27,18 @@ struct SamplePoint{
 	}
 };
 
-struct AreaFace{
-	double area;
-	Surface_mesh::Face f;
-
-    AreaFace(double a = 0.0, Surface_mesh::Face face = Surface_mesh::Face()) : area(a), f(face){}
-
-	bool operator< (const AreaFace & af) const { return area < af.area; }
-	void setValue (double val) { area = val; }
+// Counter based random numbers: a value depends only on (seed, counter), so samples
+// come out the same whichever thread draws them and in whatever order
+struct CounterRandom{
+	static inline quint64 mix( quint64 z ){
+		z = (z ^ (z >> 30)) * Q_UINT64_C(0xbf58476d1ce4e5b9);
+		z = (z ^ (z >> 27)) * Q_UINT64_C(0x94d049bb133111eb);
+		return z ^ (z >> 31);
+	}
+	static inline double uniform( quint64 seed, quint64 counter ){
+		quint64 z = mix( seed + Q_UINT64_C(0x9e3779b97f4a7c15) * (counter + 1) );
+		return (z >> 11) * (1.0 / 9007199254740992.0);
+	}
 };
 
 enum SamplingMethod { FACE_CENTER, RANDOM_BARYCENTRIC };
@@ -54,11 +58,19 @@ public:
 	SamplePoint getSample(double weight = 0.0);
     std::vector<SamplePoint> getSamples(int numberSamples, double weight = 0.0);
 
+	// Sample number 'index' of the stream, draws the same point on every thread
+	SamplePoint sampleAt(quint64 index, double weight = 0.0);
+
+	// Random stream, seeded from rand() on construction
+	quint64 seed;
+	quint64 counter;
+
     SurfaceMesh::Model * mesh;
 	double totalMeshArea;
 
-	// For Monte Carlo
-    std::vector<AreaFace> interval;
+	// For Monte Carlo, Walker alias table over face areas
+    std::vector<double> aliasProbability;
+    std::vector<int> aliasFace;
     ScalarFaceProperty farea;
     ScalarFaceProperty fprobability;
     Vector3FaceProperty fcenter;
@@ -74,9 +86,9 @@ double inline uniform(double a = 0.0, double b = 1.0){
     return ((double)rand()/RAND_MAX) * len + a;
 }
 
-static inline void RandomBaricentric(double * interp){
-	interp[1] = uniform();
-	interp[2] = uniform();
+static inline void RandomBaricentric(double * interp, double r1, double r2){
+	interp[1] = r1;
+	interp[2] = r2;
 
 	if(interp[1] + interp[2] > 1.0)
 	{
@@ -86,3 +98,9 @@ static inline void RandomBaricentric(double * interp){
 
 	interp[0] = 1.0 - (interp[1] + interp[2]);
 }
+
+static inline void RandomBaricentric(double * interp){
+	double r1 = uniform();
+	double r2 = uniform();
+	RandomBaricentric(interp, r1, r2);
+}
@@ -1,18 +1,19 @@
 #include <QApplication> // For mouse icon changing
 #include <QtConcurrentRun> // For easy multi-threading
 #include <QQueue>
+#include <QElapsedTimer>
 
 #include "TaskCurve.h"
 #include "TaskSheet.h"
 #include "Scheduler.h"
 #include "Relink.h"
+#include "Tracing.h"
 
 #include "Synthesizer.h"
 #include "GraphDissimilarity.h"
 
 #include "kmeans1d.h"
 #include "kmeans.h"
-#include "kmedoid.h"
 
 #include "SoftwareRenderer.h"
 
@@ -22,9 +23,13 @@
 #include "SchedulerWidget.h"
 
 Q_DECLARE_METATYPE( QSet<int> ) // for tags
+Q_DECLARE_METATYPE( Eigen::VectorXf ) // for thumbnails
 
 	Scheduler::Scheduler() : globalStart(0.0), globalEnd(1.0), timeStep( 1.0 / 100.0 ), overTime(0.0), isApplyChangesUI(false)
 {
+	isAdaptiveTimeStep = false;
+	adaptiveTolerance = 0.005;
+
 	rulerHeight = 25;
 
 	originalActiveGraph = originalTargetGraph = NULL;
@@ -69,6 +74,8 @@ Scheduler::Scheduler( const Scheduler& other )
 	globalStart = other.globalStart;
 	globalEnd = other.globalEnd;
 	overTime = other.overTime;
+	isAdaptiveTimeStep = other.isAdaptiveTimeStep;
+	adaptiveTolerance = other.adaptiveTolerance;
 
 	// Input
 	setInputGraphs( other.originalActiveGraph, other.originalTargetGraph );
@@ -492,6 +499,8 @@ void Scheduler::reset()
 
 void Scheduler::executeAll()
 {
+	TRACE_ZONE("Scheduler::executeAll");
+
 	int totalTime = totalExecutionTime();
 	QVector<Task*> allTasks = tasksSortedByStart();
 
@@ -580,10 +589,25 @@ void Scheduler::executeAll()
 		//allGraphs.push_back( new Structure::Graph( *activeGraph ) );
 	}
 
+	// Adaptive stepping: times where we keep the finest step
+	QVector<double> events;
+	if( isAdaptiveTimeStep )
+	{
+		foreach(Task * task, allTasks) events << double(task->start) / totalTime << double(task->endTime()) / totalTime;
+		foreach(int tag, property["timeTags"].value< QSet<int> >()) events << double(tag) / totalTime;
+		qSort(events);
+	}
+
+	double curStep = timeStep;
+	double maxStep = timeStep * 8;
+	double graphSize = activeGraph->bbox().diagonal().norm();
+	if(graphSize == 0) graphSize = 1.0;
+	Array1D_Vector3 prevPoints;
+
 	// Execute all tasks
-	for(double globalTime = globalStart; globalTime <= (globalEnd + timeStep); globalTime += timeStep)
+	for(double globalTime = globalStart; globalTime <= (globalEnd + timeStep); globalTime += curStep)
 	{
-		QElapsedTimer timer; timer.start();
+		TRACE_ZONE("Scheduler::step");
 
 		// DEBUG - per pass
 		activeGraph->clearDebug();
@@ -597,7 +621,7 @@ void Scheduler::executeAll()
 		activeGraph->setPropertyAll("isActive", false);
 
 		// Blend deltas
-		blendDeltas( globalTime, timeStep );
+		blendDeltas( globalTime, curStep );
 
 		/// Prepare and execute current tasks
 		for(int i = 0; i < (int)allTasks.size(); i++)
@@ -629,11 +653,46 @@ void Scheduler::executeAll()
 
 		// Output current active graph:
 		activeGraph->property["graphIndex"] = allGraphs.size();
-		allGraphs.push_back(  new Structure::Graph( *activeGraph )  );
+		allGraphs.push_back(  activeGraph->cloneInArena()  );
 
 		// DEBUG:
 		activeGraph->clearDebug();
 
+		// Next step grows while geometry barely moves, and shrinks when it moves a lot
+		if( isAdaptiveTimeStep )
+		{
+			Array1D_Vector3 curPoints;
+			foreach(Node * n, activeGraph->nodes){
+				Array1D_Vector3 cp = n->controlPoints();
+				curPoints.insert(curPoints.end(), cp.begin(), cp.end());
+			}
+
+			double motion = DBL_MAX;
+			if(prevPoints.size() == curPoints.size()){
+				motion = 0;
+				for(int i = 0; i < (int)curPoints.size(); i++)
+					motion = qMax(motion, (curPoints[i] - prevPoints[i]).norm() / graphSize);
+			}
+			prevPoints = curPoints;
+
+			if(motion < 0.5 * adaptiveTolerance) curStep = qMin(curStep * 2.0, maxStep);
+			else if(motion > adaptiveTolerance) curStep = qMax(curStep * 0.5, timeStep);
+
+			// Finest steps around task boundaries and tags, never step over them
+			foreach(double e, events)
+			{
+				if(std::abs(e - globalTime) < 2 * timeStep){
+					curStep = timeStep;
+					break;
+				}
+
+				if(e > globalTime){
+					curStep = qMin(curStep, qMax(timeStep, (e - 2 * timeStep) - globalTime));
+					break;
+				}
+			}
+		}
+
 		// UI - progress visual indicator:
 		int percent = globalTime * 100;
 		property["progress"] = percent;
@@ -659,6 +718,8 @@ void Scheduler::executeAll()
 
 void Scheduler::finalize()
 {
+	TRACE_ZONE("Scheduler::finalize");
+
 	double sumDistortion = 0;
 
 	double distThreshold = activeGraph->bbox().diagonal().norm() * 0.1;
@@ -677,6 +738,12 @@ void Scheduler::finalize()
 
 		// Reassign 't' values for generated graphs
 		double stretch = (totalExecutionTime() - overTime) / totalExecutionTime();
+
+		// Adaptive frames are looked up by their 't', make room for the overtime appended after them
+		if( isAdaptiveTimeStep ){
+			double T = totalExecutionTime() - overTime;
+			stretch = T / (T + Task::DEFAULT_LENGTH);
+		}
 		for(int i = 0; i < (int)allGraphs.size(); i++)
 			allGraphs[i]->property["t"] = qMin(1.0, stretch * (allGraphs[i]->property["t"].toDouble()));
 
@@ -689,6 +756,9 @@ void Scheduler::finalize()
 		for(int u = 0; u <= steps; u++){
 			double t = double(u) / steps;
 
+			// Frames carry their own time
+			if( isAdaptiveTimeStep ) activeGraph->property["t"] = stretch + (1.0 - stretch) * t;
+
 			// Morph nodes
 			foreach(Node * n, activeGraph->nodes){
 				Node * tn = targetGraph->getNode( n->property["correspond"].toString() );
@@ -701,7 +771,7 @@ void Scheduler::finalize()
 				n->setControlPoints( newGeometry );
 			}
 
-			allGraphs.push_back(  new Structure::Graph( *activeGraph )  );
+			allGraphs.push_back(  activeGraph->cloneInArena()  );
 		}
 
 		overTime = Task::DEFAULT_LENGTH;
@@ -733,13 +803,31 @@ int Scheduler::totalExecutionTime()
 	return endTime + overTime;
 }
 
+int Scheduler::frameIndexAt( double t )
+{
+	if(!allGraphs.size()) return -1;
+
+	// Evenly spaced frames
+	if( !isAdaptiveTimeStep )
+		return qRanged(0, int(t * allGraphs.size()), allGraphs.size() - 1);
+
+	// Frames are ordered by time, but not necessarily evenly spaced
+	int lo = 0, hi = allGraphs.size() - 1;
+	while(lo < hi)
+	{
+		int mid = (lo + hi) / 2;
+		if(allGraphs[mid]->property["t"].toDouble() < t) lo = mid + 1;
+		else hi = mid;
+	}
+
+	return lo;
+}
+
 void Scheduler::timeChanged( int newTime )
 {
 	if(!allGraphs.size()) return;
 
-	int idx = allGraphs.size() * (double(newTime) / totalExecutionTime());
-
-	idx = qRanged(0, idx, allGraphs.size() - 1);
+	int idx = frameIndexAt( double(newTime) / totalExecutionTime() );
 	allGraphs[idx]->property["graphIndex"] = idx;
 
 	emit( activeGraphChanged(allGraphs[idx]) );
@@ -916,6 +1004,8 @@ void Scheduler::addMorphTask( QString nodeID )
 
 void Scheduler::blendDeltas( double globalTime, double timeStep )
 {
+	TRACE_ZONE("Scheduler::blendDeltas");
+
 	if (globalTime >= 1.0) return;
 
 	Q_UNUSED( timeStep );
@@ -1295,7 +1385,7 @@ QVector<Structure::Graph*> Scheduler::interestingInBetweens(int N)
 	}
 
 	foreach(double t, times)
-		result.push_back( allGraphs[ t * (allGraphs.size() - 1) ] );
+		result.push_back( allGraphs[ isAdaptiveTimeStep ? frameIndexAt(t) : int(t * (allGraphs.size() - 1)) ] );
 
 	return result;
 }
@@ -1321,77 +1411,49 @@ QVector<Structure::Graph*> Scheduler::topoVaryingInBetweens(int N, bool isVisual
 	int thumbWidth = 40;
 	MatrixXd V = MatrixXd::Zero( allGraphs.size(), thumbWidth * thumbWidth);
 
-	QString fixedPart = "";
-	Vector3 fixedCenter(0,0,0);
+	QString thumbKey = QString("thumbnail_%1").arg(thumbWidth);
+	QVector<Structure::ActualGraphView*> views( allGraphs.size() );
 
+	// Frames share nothing, so each is handled on its own thread
+	#pragma omp parallel for
 	for(int i = 0; i < allGraphs.size(); i++)
 	{
-		Structure::Graph * g = Structure::Graph::actualGraph(allGraphs[i]);
+		views[i] = new Structure::ActualGraphView( allGraphs[i] );
 
-		// Topological dissimilarity
-		gd.addGraph( g );
+		// Geometric dissimilarity, rendered once per frame
+		if( allGraphs[i]->property.contains(thumbKey) ) continue;
 
-		// Geometric dissimilarity
-		{
-			QVector<Vector3> cpnts;
+		QVector<Vector3> cpnts;
+		foreach(int ni, views[i]->activeNodes()) foreach(Vector3 p, allGraphs[i]->nodes[ni]->controlPoints()) cpnts << p;
 
-			if( !fixedPart.isEmpty() )
-			{
-				Node * fixed = g->getNode(fixedPart);
-
-				// If we lost the fixed part, find another..
-				if( !fixed ){
-					foreach(Node * n, g->nodes){
-						if(n->property["fixedSize"].toBool()){
-							fixedPart = n->id;
-							fixedCenter = n->bbox().center();
-							break;
-						}
-					}
-				}
-				else
-				{
-					Vector3 delta = fixedCenter - fixed->bbox().center();
-					g->translate(delta, true);
-				}
-			}
-			else
-			{
-				foreach(Node * n, g->nodes){
-					if(n->property["fixedSize"].toBool()){
-						fixedPart = n->id;
-						fixedCenter = n->bbox().center();
-						break;
-					}
-				}
-			}
+		// Normalize and fit, this also aligns frames so no fixed part is needed
+		{
+			Vector3 mean(0,0,0);
+			foreach(Vector3 p, cpnts) mean += p;
+			mean /= cpnts.size();
+			double scale = -1.0;
+			foreach(Vector3 p, cpnts) scale = qMax(scale, (p-mean).norm());
+			for(int pi = 0; pi < cpnts.size(); pi++) cpnts[pi] = ((cpnts[pi] - mean) / scale);
+		}
 
-			foreach(Node * n, g->nodes) foreach(Vector3 p, n->controlPoints()) cpnts << p;
+		Eigen::MatrixXf thumbnail = SoftwareRenderer::renderDepth(cpnts, thumbWidth, thumbWidth, 2, Vector3(0,0,0));
 
-			// Normalize and fit
-			{
-				Vector3 mean(0,0,0);
-				foreach(Vector3 p, cpnts) mean += p;
-				mean /= cpnts.size();
-				double scale = -1.0;
-				foreach(Vector3 p, cpnts) scale = qMax(scale, (p-mean).norm());
-				for(int pi = 0; pi < cpnts.size(); pi++) cpnts[pi] = ((cpnts[pi] - mean) / scale);
-			}
+		//if( isVisualize ) SoftwareRenderer::matrixToImage(thumbnail.cast<double>()).save(QString("skeleton_%1.png").arg(i));
 
-			MatrixXd thumbnail = SoftwareRenderer::render(cpnts, thumbWidth, thumbWidth, 2, Vector3(0,0,0));
+		allGraphs[i]->property[thumbKey].setValue( Eigen::VectorXf( Eigen::Map<Eigen::VectorXf>(thumbnail.data(), thumbnail.size()) ) );
+	}
 
-			//if( isVisualize ) SoftwareRenderer::matrixToImage(thumbnail).save(QString("skeleton_%1.png").arg(i));
-			
-			// Fill to a vector
-			for(int d = 0; d < thumbWidth * thumbWidth; d++) 
-			{
-				V(i,d) = thumbnail(d);
-			}
-		}
+	for(int i = 0; i < allGraphs.size(); i++)
+	{
+		// Topological dissimilarity
+		gd.addGraph( *views[i] );
 
-		delete g;
+		// Fill to a vector
+		V.row(i) = allGraphs[i]->property[thumbKey].value<Eigen::VectorXf>().cast<double>().transpose();
 	}
 
+	qDeleteAll( views );
+
 	QVector< QPair<double,double> > dissimilarVals = gd.computeDissimilarPairs(2);
 
 	// Add topology measure
@@ -1405,7 +1467,8 @@ QVector<Structure::Graph*> Scheduler::topoVaryingInBetweens(int N, bool isVisual
 
 	QVector<int> classes(allGraphs.size());
 
-	kmeansFast::Clusters clusters = kmeansFast::kmeans(V, N);
+	// Fixed seed for reproducible in-between selection
+	kmeansFast::Clusters clusters = kmeansFast::kmeans(V, N, 25, 0);
 
 	for(int i = 0; i < allGraphs.size(); i++)
 		classes[i] = clusters.cluster[i];
@@ -37,6 +37,10 @@ public:
 	double globalEnd;
 	double overTime;
 
+	// Adaptive stepping, 'timeStep' is then the finest step taken
+	bool isAdaptiveTimeStep;
+	double adaptiveTolerance; // control point motion per step, relative to graph size
+
 	// Output
 	QVector<Structure::Graph*> allGraphs;
 
@@ -62,6 +66,7 @@ public:
 
 	void blendDeltas( double globalTime, double timeStep );
 	int totalExecutionTime();
+	int frameIndexAt( double t ); // uniform frames unless adaptive stepping is on
 
 	// Dependency
 	QVector<QString> activeTasks(double globalTime);
@@ -1,5 +1,7 @@
 #pragma once
 #include <iostream>     // std::cout
+#include <vector>
+#include <cfloat>
 #include <QImage>
 #include <QPainter>
 #include <QPoint>
@@ -268,6 +270,148 @@ namespace SoftwareRenderer{
 		return img;
 	}
 
+	struct Span{
+		int y, x0, x1;
+		float value;
+	};
+
+	void addSpan(std::vector<Span> & spans, int y, int x0, int x1, float value, int width, int height){
+		if(y < 0 || y > height - 1) return;
+		x0 = qMax(x0, 0);
+		x1 = qMin(x1, width - 1);
+		if(x0 > x1) return;
+		Span s = { y, x0, x1, value };
+		spans.push_back(s);
+	}
+
+	void circleSpans(std::vector<Span> & spans, int cx, int cy, int radius, float value, int width, int height){
+		int error = -radius;
+		int x = radius;
+		int y = 0;
+
+		while (x >= y){
+			int lastY = y;
+
+			error += y;
+			++y;
+			error += y;
+
+			addSpan(spans, cy + lastY, cx - x, cx + x, value, width, height);
+			if (x != 0 && lastY != 0) addSpan(spans, cy - lastY, cx - x, cx + x, value, width, height);
+
+			if (error >= 0){
+				if (x != lastY){
+					addSpan(spans, cy + x, cx - lastY, cx + lastY, value, width, height);
+					if (lastY != 0 && x != 0) addSpan(spans, cy - x, cx - lastY, cx + lastY, value, width, height);
+				}
+				error -= x;
+				--x;
+				error -= x;
+			}
+		}
+	}
+
+	// Same image as render() above, rasterized in float. Drawing depth sorted points leaves the
+	// deepest value on each pixel, so splats are max-accumulated as spans bucketed by row instead.
+	Eigen::MatrixXf renderDepth( const QVector< Eigen::Vector3d > & points, int width = 32, int height = 32, int pointSize = 1, Eigen::Vector3d translate = Eigen::Vector3d(0,0,0) )
+	{
+		typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMajorImage;
+		RowMajorImage img = RowMajorImage::Zero( height, width );
+		if( points.isEmpty() ) return img;
+
+		// Camera and projection
+		Matrix4 pmat = CreateProjectionMatrix( 90, double(width) / height );
+		Matrix4 wmat = CreateWorldMatrix( translate[0], translate[1], translate[2] );
+		Matrix4 vmat = CreateViewMatrix();
+		Matrix4 transformMatrix = wmat * vmat * pmat;
+
+		// Transform all points at once
+		int n = points.size();
+		Eigen::Matrix4Xf homogeneous(4, n);
+		for(int i = 0; i < n; i++) 
+			homogeneous.col(i) << points[i][0], points[i][1], points[i][2], 1.0f;
+
+		Eigen::Matrix4Xf transformed = transformMatrix.transpose().cast<float>() * homogeneous;
+
+		std::vector<int> xs, ys;
+		std::vector<float> depths;
+
+		float minDepth = FLT_MAX;
+		float maxDepth = -FLT_MAX;
+
+		for(int i = 0; i < n; i++)
+		{
+			float w = transformed(3,i);
+			float sx = (transformed(0,i) / w) * width + (width * 0.5f);
+			float sy = (-transformed(1,i) / w) * height + (height * 0.5f);
+
+			// off-screen points check
+			int x = sx;
+			int y = sy;
+			if(x < 0 || x > width - 1 || y < 0 || y > height - 1) 
+				continue;
+
+			float depth = -transformed(2,i) / w;
+
+			xs.push_back(x);
+			ys.push_back(y);
+			depths.push_back(depth);
+
+			minDepth = qMin( depth, minDepth );
+			maxDepth = qMax( depth, maxDepth );
+		}
+
+		float depthRange = (maxDepth > minDepth) ? (maxDepth - minDepth) : 1.0f;
+
+		// Splats as horizontal spans
+		std::vector<Span> spans;
+		spans.reserve( xs.size() * (pointSize == 2 ? 3 : 1) );
+
+		for(int i = 0; i < (int)xs.size(); i++)
+		{
+			int x = xs[i], y = ys[i];
+			float depthVal = (depths[i] - minDepth) / depthRange;
+
+			if(pointSize == 1)
+			{
+				addSpan(spans, y, x, x, depthVal, width, height);
+			}
+			else if(pointSize == 2)
+			{
+				// cross shape
+				addSpan(spans, y, x - 1, x + 1, depthVal, width, height);
+				addSpan(spans, qMax(y-1, 0), x, x, depthVal, width, height);
+				addSpan(spans, qMin(y+1, height-1), x, x, depthVal, width, height);
+			}
+			else
+				circleSpans(spans, x, y, pointSize, depthVal, width, height);
+		}
+
+		// Bucket spans by row
+		std::vector<int> rowStart(height + 1, 0);
+		for(int i = 0; i < (int)spans.size(); i++) rowStart[spans[i].y + 1]++;
+		for(int y = 0; y < height; y++) rowStart[y + 1] += rowStart[y];
+
+		std::vector<Span> sorted( spans.size() );
+		std::vector<int> rowFill( rowStart.begin(), rowStart.end() - 1 );
+		for(int i = 0; i < (int)spans.size(); i++) sorted[ rowFill[spans[i].y]++ ] = spans[i];
+
+		// Accumulate each row
+		for(int y = 0; y < height; y++)
+		{
+			Eigen::Map<Eigen::ArrayXf> row( img.data() + y * width, width );
+
+			for(int i = rowStart[y]; i < rowStart[y + 1]; i++)
+			{
+				const Span & s = sorted[i];
+				int len = s.x1 - s.x0 + 1;
+				row.segment(s.x0, len) = row.segment(s.x0, len).max( Eigen::ArrayXf::Constant(len, s.value) );
+			}
+		}
+
+		return img;
+	}
+
 	void render( QVector< Eigen::Vector3d > points, QImage & img, int width = 32, int height = 32, int pointSize = 1, Eigen::Vector3d translate = Eigen::Vector3d(0,0,0) )
 	{
 		img = QImage(width, height, QImage::Format_RGB32);
@@ -31,11 +31,17 @@ public:
 		foreach(Vector3d p, rndSamples) tree.addPoint(p);
 		tree.build();
 
-        foreach(Vector3d center, centers)
+		// Centers are independent, cluster them in parallel and keep the lattice order
+		int numCenters = centers.size();
+		std::vector<Vector3d> groupCenters(numCenters), groupNormals(numCenters);
+		std::vector<char> isUsed(numCenters, 0);
+
+		#pragma omp parallel for schedule(dynamic, 64)
+		for(int c = 0; c < numCenters; c++)
         {
 			// Collect neighbors
 			KDResults matches;
-			int n = tree.ball_search( center, r, matches );
+			int n = tree.ball_search( centers[c], r, matches );
 
             if(n < 1) continue;
 
@@ -49,10 +55,19 @@ public:
 			centerGroup /= matches.size();
 			normal /= matches.size();
 
-			samples.push_back(centerGroup);
-			normals.push_back(normal.normalized());
+			groupCenters[c] = centerGroup;
+			groupNormals[c] = normal.normalized();
+			isUsed[c] = 1;
+		}
+
+		for(int c = 0; c < numCenters; c++)
+		{
+			if(!isUsed[c]) continue;
+
+			samples.push_back(groupCenters[c]);
+			normals.push_back(groupNormals[c]);
 
-			gridPoints.push_back(center);
+			gridPoints.push_back(centers[c]);
 		}
 
 		return samples;
@@ -27,6 +27,7 @@ Node * Curve::clone()
 	Curve * cloneCurve = new Curve( this->curve, this->id );
 	cloneCurve->property = this->property;
 	cloneCurve->vis_property = this->vis_property;
+	cloneCurve->cachedFrames = this->cachedFrames;
 	return cloneCurve;
 }
 
@@ -87,6 +88,60 @@ SurfaceMesh::Vector3 Curve::position( const Vector4d& coordinates )
 	return p;
 }
 
+QSharedPointer<const CurveFrames> Curve::frames( int count )
+{
+	if( cachedFrames && (int)cachedFrames->coords.size() == count && cachedFrames->ctrlPoints == curve.mCtrlPoint )
+		return cachedFrames;
+
+	CurveFrames * f = new CurveFrames;
+	f->ctrlPoints = curve.mCtrlPoint;
+
+	std::vector<Scalar> times;
+	curve.SubdivideByLengthTime(count, times);
+
+	std::vector<Vector3d> samplePoints;
+	foreach(Scalar t, times){
+		f->coords.push_back( Vector4d(t,0,0,0) );
+		samplePoints.push_back( curve.GetPosition(t) );
+	}
+
+	f->rmf = RMF( samplePoints, false );
+	f->rmf.compute();
+
+	cachedFrames = QSharedPointer<const CurveFrames>(f);
+	return cachedFrames;
+}
+
+RMF::Frame Curve::frameAt( double t, int count )
+{
+	return frames(count)->frameAt(t);
+}
+
+RMF::Frame CurveFrames::frameAt( double t ) const
+{
+	int n = (int)rmf.U.size();
+	if( n == 0 ) return RMF::Frame();
+	if( n == 1 || n != (int)coords.size() ) return rmf.U.front();
+
+	// First sample at or after t
+	int lo = 1, hi = n - 1;
+	while( lo < hi ){
+		int mid = (lo + hi) / 2;
+		if( coords[mid][0] < t ) lo = mid + 1; else hi = mid;
+	}
+
+	double t0 = coords[hi-1][0], span = coords[hi][0] - t0;
+	double alpha = (span > 0) ? qRanged(0.0, (t - t0) / span, 1.0) : 0.0;
+
+	const RMF::Frame & a = rmf.U[hi-1], & b = rmf.U[hi];
+	Vector3d T = ((1 - alpha) * a.t + alpha * b.t).normalized();
+	Vector3d R = RMF::pointOnPlane((1 - alpha) * a.r + alpha * b.r, T).normalized();
+
+	RMF::Frame f = RMF::Frame::fromTR(T, R);
+	f.center = (1 - alpha) * a.center + alpha * b.center;
+	return f;
+}
+
 Vector4d Curve::approxCoordinates( const Vector3 & pos )
 {
 	Scalar t = curve.timeAt( pos );
@@ -383,14 +438,23 @@ CurveEncoding Curve::encodeCurve( Curve * curve, Vector3 start, Vector3 end, boo
 	return encodeCurve(curve->controlPoints(),start,end,isFlip);
 }
 
-Array1D_Vector3 Curve::decodeCurve(CurveEncoding cpCoords, Vector3 start, Vector3 end, double T)
+Array1D_Vector3 Curve::decodeCurve(const CurveEncoding & cpCoords, Vector3 start, Vector3 end, double T)
+{
+	Array1D_Vector3 controlPoints;
+	decodeCurve(flatEncoding(cpCoords), start, end, T, controlPoints);
+	return controlPoints;
+}
+
+// Decodes into an existing buffer, no allocation once it has the right size
+void Curve::decodeCurve(const Array1D_Vector4d & cpCoords, Vector3 start, Vector3 end, double T, Array1D_Vector3 & controlPoints)
 {
-	Array1D_Vector3 controlPoints (cpCoords.size(), Vector3(0,0,0));
+	controlPoints.resize(cpCoords.size());
 
 	NURBS::Line segment(start, end);
 
 	if(segment.length < DECODE_ZERO_THRESHOLD){
-		return Array1D_Vector3( cpCoords.size(), start );
+		std::fill(controlPoints.begin(), controlPoints.end(), start);
+		return;
 	}
 
 	// compute frame
@@ -413,8 +477,21 @@ Array1D_Vector3 Curve::decodeCurve(CurveEncoding cpCoords, Vector3 start, Vector
 
 		controlPoints[i] = segment.pointAt(t) + (dir * ((offset * T) * segment.length));
 	}
+}
 
-	return controlPoints;
+// Encoding as one flat array, indexed like the control points
+Array1D_Vector4d Curve::flatEncoding( const CurveEncoding & cpCoords )
+{
+	Array1D_Vector4d flat( cpCoords.size(), Vector4d(0,0,0,0) );
+
+	for(int i = 0; i < (int)flat.size(); i++)
+	{
+		const Array1D_Real & params = cpCoords[i];
+		for(int j = 0; j < (int)params.size() && j < 4; j++)
+			flat[i][j] = params[j];
+	}
+
+	return flat;
 }
 
 
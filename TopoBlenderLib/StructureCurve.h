@@ -2,11 +2,24 @@
 
 #include "StructureNode.h"
 #include "NURBSCurve.h"
+#include "RMF.h"
+#include <QSharedPointer>
 
 typedef QMap<int, Array1D_Real> CurveEncoding;
 
 namespace Structure{
 
+// Rotation-minimizing frames at arc-length samples of a curve
+struct CurveFrames
+{
+	Array1D_Vector3 ctrlPoints;	// control points the frames were built from
+	Array1D_Vector4d coords;
+	RMF rmf;
+
+	// Frame at any t, interpolated between the neighbouring samples
+	RMF::Frame frameAt( double t ) const;
+};
+
 struct Curve : public Node
 {
     // Constructors
@@ -52,10 +65,16 @@ struct Curve : public Node
 	Vector3 approxProjection( const Vector3 & point );
 	Vector3 center();
 
+	// Frames are cached and rebuilt only when the control points change
+	QSharedPointer<const CurveFrames> frames( int count );
+	RMF::Frame frameAt( double t, int count );
+
 	// Encoding
 	static CurveEncoding encodeCurve( Array1D_Vector3 points, Vector3 start, Vector3 end, bool isFlip = false );
 	static CurveEncoding encodeCurve( Curve * curve, Vector3 start, Vector3 end, bool isFlip = false );
-	static Array1D_Vector3 decodeCurve( CurveEncoding cpCoords, Vector3 start, Vector3 end, double T = 1.0 );
+	static Array1D_Vector3 decodeCurve( const CurveEncoding & cpCoords, Vector3 start, Vector3 end, double T = 1.0 );
+	static void decodeCurve( const Array1D_Vector4d & cpCoords, Vector3 start, Vector3 end, double T, Array1D_Vector3 & controlPoints );
+	static Array1D_Vector4d flatEncoding( const CurveEncoding & cpCoords );
 
 	// Geometric properties
 	Scalar area();
@@ -66,6 +85,9 @@ struct Curve : public Node
     // Visualization
     void draw(bool isShowCtrlPts = false);
 	void drawWithNames(int nID, int pointIDRange);
+
+private:
+	QSharedPointer<const CurveFrames> cachedFrames;
 };
 
 }
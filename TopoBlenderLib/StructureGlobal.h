@@ -510,17 +510,6 @@ std::vector<VectorType> BezierArc(const VectorType& pointA, const VectorType& po
 	return arc;
 }
 
-static inline std::vector<bool> subsampleMask(int samples, int entire){
-	std::vector<bool> mask = std::vector<bool>(entire, false);
-	int difference = entire - samples;
-	if(difference <= 0) return std::vector<bool>(entire, true);
-
-	// Subtract the difference and shuffle
-	for(int i = 0; i < samples; i++) mask[i] = true;
-	std::random_shuffle(mask.begin(), mask.end());
-	return mask;
-}
-
 // Executing system commands and returning output
 #ifdef Q_OS_WIN
 #ifndef popen
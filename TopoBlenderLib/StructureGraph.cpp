@@ -7,6 +7,9 @@
 #include <QDomElement>
 #include <QStack>
 #include <QMatrix4x4>
+#include <QMutex>
+
+#include <set>
 
 #include "StructureGraph.h"
 using namespace Structure;
@@ -20,8 +23,10 @@ using namespace Structure;
 #include "GenericGraph.h"
 
 #include "QuickMeshDraw.h"
+#include "ObjReader.h"
 
 #include "Task.h"
+#include "Tracing.h"
 
 Q_DECLARE_METATYPE( Eigen::AlignedBox3d )
 
@@ -30,11 +35,11 @@ Graph::Graph()
 	init();
 }
 
-Graph::Graph( QString fileName )
+Graph::Graph( QString fileName, bool isLazyMeshes )
 {
 	init();
 
-	loadFromFile( fileName );
+	loadFromFile( fileName, isLazyMeshes );
 	property["name"] = fileName;
 }
 
@@ -64,6 +69,8 @@ void Graph::init()
 
 Graph::Graph( const Graph & other )
 {
+	TRACE_COUNT("graph copies", 1);
+
 	foreach(Node * n, other.nodes)
 	{
 		this->addNode( n->clone() );
@@ -93,6 +100,18 @@ Graph::Graph( const Graph & other )
 	ueid = other.ueid;
 }
 
+Graph * Graph::cloneInArena() const
+{
+	Arena * arena = new Arena;
+	Graph * g = NULL;
+	{
+		ArenaScope scope( arena );
+		g = new Graph( *this );
+	}
+	arena->release();
+	return g;
+}
+
 Graph::~Graph()
 {
     qDeleteAll( nodes );
@@ -446,6 +465,9 @@ void Graph::draw( QGLViewer * drawArea )
 		spheres.draw(); spheres2.draw();
 	}
 
+	// Parts of a lazily loaded graph are read when first shown
+	if( property["showMeshes"].toBool() && !property.contains("reconMesh") ) loadMeshes();
+
     foreach(Node * n, nodes)
     {
 		// Debug points for node
@@ -890,6 +912,18 @@ void Graph::saveToFile( QString fileName, bool isOutParts /*= true*/ ) const
 				if( isOutParts )
 					saveOBJ( mesh.data(), graphDir.path() + "/" + relativeFileName );
 			}
+			// Part of a lazily loaded graph, still on disk
+			else if(mesh_filename.size() && isOutParts && n->property.contains("mesh_path"))
+			{
+				QString meshPath = n->property["mesh_path"].toString();
+				QString outPath = graphDir.path() + "/" + relativeFileName;
+
+				if( QFileInfo(meshPath) != QFileInfo(outPath) )
+				{
+					QFile::remove( outPath );
+					QFile::copy( meshPath, outPath );
+				}
+			}
 
 			out << QString("\t<mesh>%1</mesh>\n\n").arg( relativeFileName ); // relative
 		}
@@ -947,7 +981,7 @@ void Graph::saveToFile( QString fileName, bool isOutParts /*= true*/ ) const
 	file.close();
 }
 
-void Graph::loadFromFile( QString fileName )
+void Graph::loadFromFile( QString fileName, bool isLazyMeshes )
 {
 	// Clear data
 	nodes.clear();
@@ -966,8 +1000,6 @@ void Graph::loadFromFile( QString fileName )
 	QDomNodeList node_list = mDocument.firstChildElement("document").elementsByTagName("node");
 	int num_nodes = node_list.count();
 
-	bool hasMeshes = false;
-
 	for(int i = 0; i < num_nodes; i++)
 	{
 		QDomNode node = node_list.at(i);
@@ -1028,33 +1060,13 @@ void Graph::loadFromFile( QString fileName )
 		// Mesh file path
 		new_node->property["mesh_filename"].setValue( mesh_filename );
 		QString fullMeshPath = fileInfo.dir().path() + "/" + mesh_filename;
-		QFile mfile( fullMeshPath );
-
-		// Load node's mesh and make it ready
-		if (mfile.exists())
-		{
-			QSharedPointer<SurfaceMeshModel> nodeMesh(new SurfaceMeshModel(mesh_filename, id));
-
-			nodeMesh->read( qPrintable(fullMeshPath) );
-			nodeMesh->update_face_normals();
-			nodeMesh->update_vertex_normals();
-			nodeMesh->updateBoundingBox();
-			new_node->property["mesh"].setValue( nodeMesh );
 
-			hasMeshes = true;
-		}
+		// Node's mesh is read later, all parts at once
+		if (QFile::exists( fullMeshPath ))
+			new_node->property["mesh_path"].setValue( fullMeshPath );
 	}
 
-	// Original shape bounding box
-	if( hasMeshes ){
-		Eigen::AlignedBox3d shapeBox;
-		for(int i = 0; i < nodes.size(); i++){
-			QSharedPointer<SurfaceMeshModel> nodeMesh = nodes[i]->property["mesh"].value< QSharedPointer<SurfaceMeshModel> >();
-			shapeBox = shapeBox.merged( nodeMesh->bbox() );
-		}
-		property["shapeBox"].setValue( shapeBox );
-		property["hasMeshes"].setValue( hasMeshes );
-	}
+	if( !isLazyMeshes ) loadMeshes();
 
 	// For each edge
 	QDomNodeList edge_list = mDocument.firstChildElement("document").elementsByTagName("edge");
@@ -1118,6 +1130,97 @@ void Graph::loadFromFile( QString fileName )
 	file.close();
 }
 
+// Serializes loading, a lazy part can be asked for from several places
+static QMutex meshLoadMutex;
+
+// Reads the given parts in parallel. The models are created on the calling thread, which should own them
+static void readNodeMeshes( QVector<Node*> pending )
+{
+	QVector< QSharedPointer<SurfaceMeshModel> > meshes;
+	QVector<QString> paths;
+
+	foreach(Node * n, pending)
+	{
+		meshes.push_back( QSharedPointer<SurfaceMeshModel>(new SurfaceMeshModel(n->property["mesh_filename"].toString(), n->id)) );
+		paths.push_back( n->property["mesh_path"].toString() );
+	}
+
+	#pragma omp parallel for schedule(dynamic)
+	for(int i = 0; i < (int)pending.size(); i++)
+	{
+		SurfaceMeshModel * nodeMesh = meshes.at(i).data();
+
+		if( !ObjReader::isObj(paths.at(i)) || !ObjReader::read(nodeMesh, paths.at(i)) )
+			nodeMesh->read( paths.at(i).toStdString() );
+		nodeMesh->update_face_normals();
+		nodeMesh->update_vertex_normals();
+		nodeMesh->updateBoundingBox();
+	}
+
+	for(int i = 0; i < (int)pending.size(); i++)
+	{
+		pending[i]->property["mesh"].setValue( meshes[i] );
+		pending[i]->property.remove("mesh_path");
+	}
+}
+
+static void updateShapeBox( Graph * g )
+{
+	bool hasMeshes = false;
+
+	// Original shape bounding box
+	Eigen::AlignedBox3d shapeBox;
+	foreach(Node * n, g->nodes)
+	{
+		if(!n->property.contains("mesh")) continue;
+
+		QSharedPointer<SurfaceMeshModel> nodeMesh = n->property["mesh"].value< QSharedPointer<SurfaceMeshModel> >();
+		if(!nodeMesh) continue;
+
+		shapeBox = shapeBox.merged( nodeMesh->bbox() );
+		hasMeshes = true;
+	}
+
+	if( hasMeshes ){
+		g->property["shapeBox"].setValue( shapeBox );
+		g->property["hasMeshes"].setValue( hasMeshes );
+	}
+}
+
+void Graph::loadMeshes()
+{
+	loadMeshes( QVector<Graph*>() << this );
+}
+
+void Graph::loadMeshes( QVector<Graph*> graphs )
+{
+	QMutexLocker locker( &meshLoadMutex );
+
+	QVector<Node*> pending;
+	foreach(Graph * g, graphs)
+		foreach(Node * n, g->nodes)
+			if(n->property.contains("mesh_path")) pending.push_back( n );
+
+	if( pending.isEmpty() ) return;
+
+	readNodeMeshes( pending );
+
+	foreach(Graph * g, graphs) updateShapeBox( g );
+}
+
+QVector<Graph*> Graph::loadGraphs( QStringList fileNames, bool isLazyMeshes )
+{
+	QVector<Graph*> graphs;
+
+	// Structure first, then the part meshes of all graphs in one go
+	foreach(QString fileName, fileNames)
+		graphs.push_back( new Graph( fileName, true ) );
+
+	if( !isLazyMeshes ) loadMeshes( graphs );
+
+	return graphs;
+}
+
 void Graph::exportAsOBJ( QString filename )
 {
 	QFile file(filename);
@@ -1545,15 +1648,14 @@ bool Graph::isCutNode( QString nodeID )
 
 bool Graph::isInCutGroup( QString nodeID )
 {
-	Structure::Graph copy(*this);
+	ConnectivityView view(this);
 
 	foreach(QVector<QString> nids, groupsOf(nodeID)){
 		foreach(QString nid, nids) 
-			if(copy.getNode(nid))
-				copy.removeNode(nid);
+			view.exclude( view.index(nid) );
 	}
 
-	return !copy.isConnected();
+	return view.numComponents() > 1;
 }
 
 bool Graph::isBridgeEdge( Link * link )
@@ -1637,6 +1739,13 @@ SurfaceMesh::Model* Graph::getMesh( QString nodeID )
 {
 	Node * node = getNode(nodeID);
 
+	if(node && node->property.contains("mesh_path"))
+	{
+		QMutexLocker locker( &meshLoadMutex );
+		if(node->property.contains("mesh_path")) readNodeMeshes( QVector<Node*>() << node );
+		updateShapeBox( this );
+	}
+
 	if(node) return node->property["mesh"].value< QSharedPointer<SurfaceMeshModel> >().data();
 
 	return NULL;
@@ -1984,120 +2093,432 @@ void Graph::moveCenterTo( Vector3 newCenter, bool isKeepMeshes )
 
 Structure::Graph * Graph::actualGraph(Structure::Graph * fromGraph)
 {
-	Graph * actual = new Graph(*fromGraph);
+	// Mostly short-lived copies for scoring, kept together in one arena
+	Arena * arena = new Arena;
+	Structure::Graph * actual = NULL;
+	{
+		ArenaScope scope( arena );
+		actual = ActualGraphView( fromGraph ).materialize();
+	}
+	arena->release();
+	return actual;
+}
+
+ActualGraphView::ActualGraphView( Graph * fromGraph ) : graph(fromGraph)
+{
+	int numNodes = graph->nodes.size();
+	int numEdges = graph->edges.size();
+
+	isActiveNode = QVector<bool>(numNodes, true);
+	isActiveEdge = QVector<bool>(numEdges, true);
+	groups = graph->groups;
 
-	bool stillCleaning = true;
+	for(int i = 0; i < numNodes; i++)
+		nodeIndex[graph->nodes[i]->id] = i;
 
-	while( stillCleaning )
+	// Edges around each node, kept in graph order
+	nodeEdges.resize(numNodes);
+	for(int e = 0; e < numEdges; e++)
 	{
-		stillCleaning = false;
+		Link * l = graph->edges[e];
+		edgeN1.push_back( nodeIndex[l->n1->id] );
+		edgeN2.push_back( nodeIndex[l->n2->id] );
 
-		foreach(Node* n, actual->nodes)
-		{
-			QVector<Link*> edges = actual->getEdges(n->id);
+		nodeEdges[edgeN1[e]].push_back(e);
+		if(edgeN2[e] != edgeN1[e]) nodeEdges[edgeN2[e]].push_back(e);
+	}
 
-			// Skip disconnected
-			if(edges.size() == 0) continue;
+	// Worklist ordered by node index, a node is revisited only when it receives edges
+	std::set<int> worklist;
+	for(int i = 0; i < numNodes; i++) worklist.insert(i);
 
-			// Get type of task on this node
-			if(!n->property.contains("taskTypeReal")) continue;
-			int taskType = n->property["taskTypeReal"].toInt();
+	while( !worklist.empty() )
+	{
+		int i = *worklist.begin();
+		worklist.erase(worklist.begin());
 
-			// Real morph tasks are not topology altering
-			if(taskType == Task::MORPH) continue;
+		Node * n = graph->nodes[i];
 
-			// Cases:
-			//	Nodes that finished shrinking or 
-			//	have not yet grown or
-			//	Going to split
-			bool isShrinking = taskType == Task::SHRINK && n->property["taskIsDone"].toBool();
-			bool isGrowing = taskType == Task::GROW && !n->property["taskIsReady"].toBool();
-			bool isSpliting = taskType == Task::SPLIT && !n->property["taskIsReady"].toBool();
+		// Skip disconnected
+		if(nodeEdges[i].isEmpty()) continue;
 
-			if( isShrinking || isGrowing || isSpliting )
-			{
-				/// Transfer edges to someone else:
-				if( !isSpliting )
-				{
-					// Look at neighbours valence
-					QMap<int, Node*> valMap;
-					foreach(Link* e, edges){
-						Node * j = e->otherNode(n->id);
-						valMap[actual->valence(j)] = j;
-					}
+		// Get type of task on this node
+		if(!n->property.contains("taskTypeReal")) continue;
+		int taskType = keptNodes.contains(i) ? int(Task::MORPH) : n->property.value("taskTypeReal").toInt();
 
-					// Move my edges to my replacment
-					Node* replacment = valMap[valMap.keys().back()];
-					foreach(Link* e, edges)
-					{
-						QString otherID = e->otherNode(n->id)->id;
-						if(otherID == replacment->id) continue;
-						if(actual->shareEdge(otherID, replacment->id)) continue;
+		// Real morph tasks are not topology altering
+		if(taskType == Task::MORPH) continue;
 
-						Vec4d c(0,0,0,0);
+		// Cases:
+		//	Nodes that finished shrinking or 
+		//	have not yet grown or
+		//	Going to split
+		bool isShrinking = taskType == Task::SHRINK && n->property.value("taskIsDone").toBool();
+		bool isGrowing = taskType == Task::GROW && !n->property.value("taskIsReady").toBool();
+		bool isSpliting = taskType == Task::SPLIT && !n->property.value("taskIsReady").toBool();
 
-						// More accurate but too slow..
-						//Vec4d c = replacment->approxCoordinates( replacment->approxProjection(e->position(n->id)) );
+		if( !(isShrinking || isGrowing || isSpliting) ) continue;
 
-						if(replacment->type() == Structure::CURVE)
-						{
-							double t = ((Structure::Curve*)replacment)->curve.fastTimeAt(e->position(n->id));
-							c = Vec4d(t,0,0,0);
-						}
-						else
-						{
-							c = ((Structure::Sheet*)replacment)->surface.fastTimeAt(e->position(n->id));
-						}
+		/// Transfer edges to someone else:
+		if( !isSpliting )
+		{
+			QVector<int> edges = nodeEdges[i];
+
+			// Look at neighbours valence
+			QMap<int, int> valMap;
+			foreach(int e, edges){
+				int j = otherNode(e, i);
+				valMap[valence(j)] = j;
+			}
 
-						Array1D_Vector4d coord(1, c);
+			// Move my edges to my replacment
+			int replacment = valMap.last();
+			Node * r = graph->nodes[replacment];
 
-						e->replace(n->id, replacment, coord);
-					}
-				}
+			foreach(int e, edges)
+			{
+				int other = otherNode(e, i);
+				if(other == replacment) continue;
+				if(shareEdge(other, replacment)) continue;
 
-				foreach(Link* e, actual->getEdges(n->id))
+				Array1D_Vector4d myCoord = (edgeN1[e] == i) ? coord1(e) : coord2(e);
+				Vector3 pos(0,0,0);
+				std::vector<Vector3> nf = noFrame();
+				n->get( myCoord[myCoord.size() / 2], pos, nf );
+
+				Vec4d c(0,0,0,0);
+
+				if(r->type() == Structure::CURVE)
 				{
-					actual->removeEdge(e->n1, e->n2);
+					double t = ((Structure::Curve*)r)->curve.fastTimeAt(pos);
+					c = Vec4d(t,0,0,0);
 				}
-
-				if( isSpliting )
+				else
 				{
-					QString siblingKeep;
-					QVector<QString> siblings = actual->groupsOf(n->id).back();
+					c = ((Structure::Sheet*)r)->surface.fastTimeAt(pos);
+				}
 
-					// Change one sibling in order to keep it
-					foreach(QString nid, siblings)
-					{
-						if(nid == n->id) continue;
-						
-						// Override the chosen one
-						actual->getNode(nid)->property["taskTypeReal"] = Task::MORPH;
-						actual->removeGroup(siblings);
-						break;
-					}
+				Array1D_Vector4d coord(1, c);
+
+				detachEdge(e, i);
+
+				if(edgeN1[e] == i){
+					edgeN1[e] = replacment;
+					edgeCoord1[e] = coord;
+				} else {
+					edgeN2[e] = replacment;
+					edgeCoord2[e] = coord;
 				}
 
-				stillCleaning = true;
+				attachEdge(e, replacment);
+			}
+
+			// Replacement might now need cleaning
+			worklist.insert(replacment);
+		}
+
+		foreach(int e, nodeEdges[i])
+			removeEdge(e);
+
+		if( isSpliting )
+		{
+			int groupIDX = -1;
+			for(int gi = 0; gi < groups.size(); gi++) if(groups[gi].contains(n->id)) groupIDX = gi;
+			if(groupIDX < 0) continue;
 
+			// Change one sibling in order to keep it
+			foreach(QString nid, groups[groupIDX])
+			{
+				if(nid == n->id) continue;
+				if(!nodeIndex.contains(nid)) continue;
+
+				// Override the chosen one
+				keptNodes.insert( nodeIndex[nid] );
+				groups.remove(groupIDX);
 				break;
 			}
 		}
 	}
 
 	// Remove edges kept after a merge
-	QVector<Link*> toRemove;
-	foreach(Link * link, actual->edges){
-		if(link->property["mergedEdge"].toBool())
-			toRemove.push_back(link);
-	}
-	foreach(Link * link, toRemove){
-		actual->removeEdge( link->property["uid"].toInt() );
+	for(int e = 0; e < numEdges; e++){
+		if(isActiveEdge[e] && graph->edges[e]->property.value("mergedEdge").toBool())
+			removeEdge(e);
 	}
 
 	// Remove any disconnected nodes
-	QVector<QString> nodesToRemove;
-	foreach(Node * n, actual->nodes) if(actual->getEdges(n->id).size() == 0) nodesToRemove.push_back(n->id);
-	foreach(QString nid, nodesToRemove) actual->removeNode(nid);
+	for(int i = 0; i < numNodes; i++)
+		isActiveNode[i] = !nodeEdges[i].isEmpty();
+}
+
+QVector<int> ActualGraphView::activeNodes()
+{
+	QVector<int> result;
+	for(int i = 0; i < isActiveNode.size(); i++) if(isActiveNode[i]) result.push_back(i);
+	return result;
+}
+
+QVector<int> ActualGraphView::activeEdges()
+{
+	QVector<int> result;
+	for(int e = 0; e < isActiveEdge.size(); e++) if(isActiveEdge[e]) result.push_back(e);
+	return result;
+}
+
+Array1D_Vector4d ActualGraphView::coord1( int edgeIdx )
+{
+	if(edgeCoord1.contains(edgeIdx)) return edgeCoord1[edgeIdx];
+	return graph->edges[edgeIdx]->coord[0];
+}
+
+Array1D_Vector4d ActualGraphView::coord2( int edgeIdx )
+{
+	if(edgeCoord2.contains(edgeIdx)) return edgeCoord2[edgeIdx];
+	return graph->edges[edgeIdx]->coord[1];
+}
+
+Graph * ActualGraphView::materialize()
+{
+	Graph * actual = new Graph;
+
+	QVector<Node*> copies(graph->nodes.size(), NULL);
+
+	foreach(int i, activeNodes())
+	{
+		Node * n = actual->addNode( graph->nodes[i]->clone() );
+
+		// Keep index from the original graph
+		n->property["index"] = i;
+
+		if(keptNodes.contains(i)) n->property["taskTypeReal"] = Task::MORPH;
+
+		copies[i] = n;
+	}
+
+	foreach(int e, activeEdges())
+	{
+		Link * l = graph->edges[e];
+		Node * n1 = copies[edgeN1[e]];
+		Node * n2 = copies[edgeN2[e]];
+
+		bool isTransfered = edgeCoord1.contains(e) || edgeCoord2.contains(e);
+		QString linkName = isTransfered ? actual->linkName(n1, n2) : l->id;
+
+		Structure::Link * newEdge = actual->addEdge(n1, n2, coord1(e), coord2(e), linkName);
+		newEdge->property = l->property;
+	}
+
+	actual->groups = groups;
+	actual->property = graph->property;
+	actual->misc = graph->misc;
+	actual->ueid = graph->ueid;
 
 	return actual;
 }
+
+int ActualGraphView::otherNode( int edgeIdx, int nodeIdx )
+{
+	return (edgeN1[edgeIdx] == nodeIdx) ? edgeN2[edgeIdx] : edgeN1[edgeIdx];
+}
+
+int ActualGraphView::valence( int nodeIdx )
+{
+	// Collect set of neighbours
+	QSet<int> neighbours;
+	foreach(int e, nodeEdges[nodeIdx])
+		neighbours.insert( otherNode(e, nodeIdx) );
+
+	// remove any self edges
+	neighbours.remove(nodeIdx);
+
+	return neighbours.size();
+}
+
+bool ActualGraphView::shareEdge( int nodeIdx1, int nodeIdx2 )
+{
+	foreach(int e, nodeEdges[nodeIdx1])
+		if(otherNode(e, nodeIdx1) == nodeIdx2) return true;
+	return false;
+}
+
+void ActualGraphView::detachEdge( int edgeIdx, int nodeIdx )
+{
+	nodeEdges[nodeIdx].remove( nodeEdges[nodeIdx].indexOf(edgeIdx) );
+}
+
+void ActualGraphView::attachEdge( int edgeIdx, int nodeIdx )
+{
+	QVector<int> & myEdges = nodeEdges[nodeIdx];
+	myEdges.insert( std::lower_bound(myEdges.begin(), myEdges.end(), edgeIdx), edgeIdx );
+}
+
+void ActualGraphView::removeEdge( int edgeIdx )
+{
+	isActiveEdge[edgeIdx] = false;
+	detachEdge(edgeIdx, edgeN1[edgeIdx]);
+	if(edgeN2[edgeIdx] != edgeN1[edgeIdx]) detachEdge(edgeIdx, edgeN2[edgeIdx]);
+}
+
+ConnectivityView::ConnectivityView( Graph * fromGraph ) : isAnalyzed(false), numConnected(0)
+{
+	int numNodes = fromGraph->nodes.size();
+
+	for(int i = 0; i < numNodes; i++)
+		nodeIndex[fromGraph->nodes[i]->id] = i;
+
+	adj.resize(numNodes);
+	foreach(Link * l, fromGraph->edges)
+	{
+		int n1 = nodeIndex.value(l->n1->id, -1), n2 = nodeIndex.value(l->n2->id, -1);
+		if(n1 < 0 || n2 < 0 || n1 == n2) continue;
+
+		adj[n1].push_back(n2);
+		adj[n2].push_back(n1);
+	}
+
+	isExcluded = QVector<bool>(numNodes, false);
+	isMarked = QVector<bool>(numNodes, false);
+}
+
+int ConnectivityView::index( QString nodeID )
+{
+	return nodeIndex.value(nodeID, -1);
+}
+
+void ConnectivityView::exclude( int nodeIdx )
+{
+	if(nodeIdx < 0) return;
+
+	isExcluded[nodeIdx] = true;
+	isAnalyzed = false;
+}
+
+void ConnectivityView::excludeIsolated()
+{
+	for(int v = 0; v < adj.size(); v++)
+		if(adj[v].isEmpty()) exclude(v);
+}
+
+void ConnectivityView::setMarked( const QVector<bool> & marked )
+{
+	isMarked = marked;
+	isAnalyzed = false;
+}
+
+bool ConnectivityView::isCutNode( int nodeIdx )
+{
+	// Missing and flying nodes count as cutting, as in Graph::isCutNode
+	if(nodeIdx < 0 || isExcluded[nodeIdx]) return true;
+
+	if(!isAnalyzed) analyze();
+
+	if(valence[nodeIdx] == 0) return true;
+
+	return isArticulation[nodeIdx] || numConnected > 1;
+}
+
+int ConnectivityView::numComponents()
+{
+	if(!isAnalyzed) analyze();
+
+	return componentMarked.size();
+}
+
+int ConnectivityView::markedComponentsWithout( int nodeIdx )
+{
+	if(!isAnalyzed) analyze();
+
+	int count = 0;
+	foreach(int marked, componentMarked) if(marked > 0) count++;
+
+	if(nodeIdx < 0 || isExcluded[nodeIdx]) return count;
+
+	// Its own component falls apart into the split off subtrees and whatever stays with the parent
+	int c = component[nodeIdx];
+	if(componentMarked[c] > 0) count--;
+
+	count += splitPieces[nodeIdx];
+
+	int rest = componentMarked[c] - (isMarked[nodeIdx] ? 1 : 0) - splitMarked[nodeIdx];
+	if(rest > 0) count++;
+
+	return count;
+}
+
+void ConnectivityView::analyze()
+{
+	int N = adj.size();
+
+	pre.fill(-1, N);
+	low.fill(-1, N);
+	valence.fill(0, N);
+	component.fill(-1, N);
+	isArticulation.fill(false, N);
+	subtreeMarked.fill(0, N);
+	splitPieces.fill(0, N);
+	splitMarked.fill(0, N);
+	componentMarked.clear();
+	numConnected = 0;
+
+	for(int v = 0; v < N; v++)
+	{
+		if(isExcluded[v]) continue;
+		foreach(int w, adj[v]) if(!isExcluded[w]) valence[v]++;
+	}
+
+	int cnt = 0;
+
+	for(int v = 0; v < N; v++)
+	{
+		if(isExcluded[v] || pre[v] != -1) continue;
+
+		componentMarked.push_back(0);
+		articulationDFS(cnt, v, v);
+		componentMarked.back() = subtreeMarked[v];
+
+		if(valence[v] > 0) numConnected++;
+	}
+
+	isAnalyzed = true;
+}
+
+void ConnectivityView::articulationDFS( int & cnt, int u, int v )
+{
+	int children = 0;
+	pre[v] = cnt++;
+	low[v] = pre[v];
+	component[v] = componentMarked.size() - 1;
+	subtreeMarked[v] = isMarked[v] ? 1 : 0;
+
+	foreach(int w, adj[v])
+	{
+		if(isExcluded[w]) continue;
+
+		if (pre[w] == -1) {
+			children++;
+			articulationDFS(cnt, v, w);
+
+			// update low number
+			low[v] = qMin(low[v], low[w]);
+			subtreeMarked[v] += subtreeMarked[w];
+
+			// subtree of w is cut off when v is removed
+			if (low[w] >= pre[v])
+			{
+				// non-root of DFS is an articulation point
+				if (u != v) isArticulation[v] = true;
+
+				if (subtreeMarked[w] > 0) splitPieces[v]++;
+				splitMarked[v] += subtreeMarked[w];
+			}
+		}
+
+		// update low number - ignore reverse of edge leading to v
+		else if (w != u)
+			low[v] = qMin(low[v], pre[w]);
+	}
+
+	// root of DFS is an articulation point if it has more than 1 child
+	if (u == v && children > 1)
+		isArticulation[v] = true;
+}
@@ -14,7 +14,7 @@
 namespace Structure{
 	typedef QVector< QVector<QString> > NodeGroups;
 
-	struct Graph
+	struct Graph : public ArenaObject
 	{
 		// Properties
 		QVector<Node*> nodes;
@@ -32,9 +32,12 @@ namespace Structure{
 	
 		// Constructors
 		Graph();
-		Graph(QString fileName);
+		Graph(QString fileName, bool isLazyMeshes = false);
 		Graph(const Graph & other);
 		~Graph();
+
+		// Copy whose graph, nodes and links share one arena, freed in bulk (see GraphArena.h)
+		Graph * cloneInArena() const;
 		void init();
 	
 		// Modifiers
@@ -94,7 +97,12 @@ namespace Structure{
 
 		// Input / Output
 		void saveToFile(QString fileName, bool isOutParts = true) const;
-		void loadFromFile(QString fileName);
+		void loadFromFile(QString fileName, bool isLazyMeshes = false);
+
+		// Part meshes of a lazily loaded graph stay on disk until drawn, blended or asked for with getMesh
+		void loadMeshes();
+		static void loadMeshes( QVector<Graph*> graphs );
+		static QVector<Graph*> loadGraphs( QStringList fileNames, bool isLazyMeshes = false );
 
 		void exportAsOBJ( QString filename );
 
@@ -151,6 +159,80 @@ namespace Structure{
 		void clearAll();
 		void clearSelections();
 	};
+
+	// The graph as it actually appears at its current blending stage. Stored as masks
+	// and edge end overrides over the original graph, nothing is cloned until materialize()
+	struct ActualGraphView
+	{
+		ActualGraphView( Graph * fromGraph );
+
+		Graph * graph;
+		QVector<bool> isActiveNode;
+		QVector<bool> isActiveEdge;
+
+		// Edge ends after edge transfers, as indices into graph->nodes
+		QVector<int> edgeN1, edgeN2;
+		QMap<int, Array1D_Vector4d> edgeCoord1, edgeCoord2;
+
+		// Split siblings kept as morphing nodes
+		QSet<int> keptNodes;
+		NodeGroups groups;
+
+		// Accessors
+		QVector<int> activeNodes();
+		QVector<int> activeEdges();
+		Array1D_Vector4d coord1( int edgeIdx );
+		Array1D_Vector4d coord2( int edgeIdx );
+
+		// Copy of the active part only, caller owns it
+		Graph * materialize();
+
+	private:
+		QHash<QString, int> nodeIndex;
+		QVector< QVector<int> > nodeEdges;
+
+		int otherNode( int edgeIdx, int nodeIdx );
+		int valence( int nodeIdx );
+		bool shareEdge( int nodeIdx1, int nodeIdx2 );
+		void detachEdge( int edgeIdx, int nodeIdx );
+		void attachEdge( int edgeIdx, int nodeIdx );
+		void removeEdge( int edgeIdx );
+	};
+
+	// Connectivity of a graph by node index. Excluding a node acts like removing it with its edges,
+	// and cut node queries are answered from one articulation pass instead of graph copies
+	struct ConnectivityView
+	{
+		ConnectivityView( Graph * fromGraph );
+
+		int index( QString nodeID );
+		void exclude( int nodeIdx );
+		void excludeIsolated();
+		void setMarked( const QVector<bool> & marked );
+
+		// Same meaning as Graph::isCutNode on the remaining graph
+		bool isCutNode( int nodeIdx );
+		int numComponents();
+
+		// Number of components holding a marked node once this node is removed
+		int markedComponentsWithout( int nodeIdx );
+
+	private:
+		QHash<QString, int> nodeIndex;
+		QVector< QVector<int> > adj;
+		QVector<bool> isExcluded, isMarked;
+
+		// Results of the articulation pass, redone after the masks change
+		bool isAnalyzed;
+		QVector<int> pre, low, valence, component;
+		QVector<bool> isArticulation;
+		QVector<int> subtreeMarked, splitPieces, splitMarked;
+		QVector<int> componentMarked;
+		int numConnected;
+
+		void analyze();
+		void articulationDFS( int & cnt, int u, int v );
+	};
 }
 
 Q_DECLARE_METATYPE( QSharedPointer<SurfaceMeshModel> )
@@ -2,6 +2,7 @@
 
 #include "StructureGlobal.h"
 #include "NurbsDraw.h"
+#include "GraphArena.h"
 
 typedef Array1D_Vector4d LinkCoords;
 typedef QPair< QString,Vector4d > NodeCoord;
@@ -16,7 +17,7 @@ static QString SHEET = "SHEET";
 static QString POINT_EDGE = "POINT";
 static QString LINE_EDGE = "LINE";
 
-struct Link
+struct Link : public ArenaObject
 {
 	// Properties
 	Node *n1, *n2;	
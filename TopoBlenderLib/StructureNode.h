@@ -7,7 +7,7 @@
 
 namespace Structure{
 
-struct Node
+struct Node : public ArenaObject
 {
 	// Constructors
 	virtual Node * clone() = 0;
@@ -493,9 +493,16 @@ SheetEncoding Sheet::encodeSheet( Sheet * sheet, Vector3 origin, Vector3 X, Vect
 	return cpCoords;
 }
 
-Array1D_Vector3 Sheet::decodeSheet( SheetEncoding cpCoords, Vector3 origin, Vector3 X, Vector3 Y, Vector3 Z )
+Array1D_Vector3 Sheet::decodeSheet( const SheetEncoding & cpCoords, Vector3 origin, Vector3 X, Vector3 Y, Vector3 Z )
 {
-	Array1D_Vector3 pnts( cpCoords.size(), Vector3(0,0,0) );
+	Array1D_Vector3 pnts;
+	decodeSheet( Curve::flatEncoding(cpCoords), origin, X, Y, Z, pnts );
+	return pnts;
+}
+
+void Sheet::decodeSheet( const Array1D_Vector4d & cpCoords, Vector3 origin, Vector3 X, Vector3 Y, Vector3 Z, Array1D_Vector3 & pnts )
+{
+	pnts.resize( cpCoords.size() );
 
 	for(int i = 0; i < (int)pnts.size(); i++)
 	{
@@ -508,8 +515,6 @@ Array1D_Vector3 Sheet::decodeSheet( SheetEncoding cpCoords, Vector3 origin, Vect
 
 		pnts[i] = origin + (dir * offset);
 	}
-
-	return pnts;
 }
 
 void Sheet::deformTo( const Vector4d & handle, const Vector3 & to, bool isRigid )
@@ -56,7 +56,8 @@ struct Sheet : public Node
 
 	// Encode and decode
 	static SheetEncoding encodeSheet( Sheet * sheet, Vector3 origin, Vector3 X, Vector3 Y, Vector3 Z );
-	static Array1D_Vector3 decodeSheet( SheetEncoding cpCoords, Vector3 origin, Vector3 X, Vector3 Y, Vector3 Z );
+	static Array1D_Vector3 decodeSheet( const SheetEncoding & cpCoords, Vector3 origin, Vector3 X, Vector3 Y, Vector3 Z );
+	static void decodeSheet( const Array1D_Vector4d & cpCoords, Vector3 origin, Vector3 X, Vector3 Y, Vector3 Z, Array1D_Vector3 & pnts );
 
     // Connections
 
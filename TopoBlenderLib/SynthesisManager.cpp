@@ -20,13 +20,12 @@ GlSplatRenderer * splat_renderer = NULL;
 #include "Scheduler.h"
 #include "TopoBlender.h"
 #include "Task.h"
+#include "Tracing.h"
 
 // The following depends on the power of the GPU
 #define POINTS_LIMIT 600000
 
 QStack<double> nurbsQuality;
-
-Q_DECLARE_METATYPE( std::vector<bool> )
 	
 SynthesisManager::SynthesisManager( GraphCorresponder * gcorr, Scheduler * scheduler, TopoBlender * blender, int samplesCount ) :
 	gcorr(gcorr), scheduler(scheduler), blender(blender), samplesCount(samplesCount), isSplatRenderer(false), 
@@ -63,6 +62,8 @@ void SynthesisManager::setSampleCount(int numSamples)
 
 void SynthesisManager::genSynData()
 {
+	TRACE_ZONE("SynthesisManager::genSynData");
+
 	clear();
 
     qApp->setOverrideCursor(Qt::WaitCursor);
@@ -95,6 +96,8 @@ void SynthesisManager::genSynData()
 
 		SynthData output;
 
+		TRACE_ZONE("SynthesisManager::prepareNode");
+
         if(snode->type() == Structure::CURVE)
         {
             Synthesizer::prepareSynthesizeCurve((Structure::Curve*)snode, (Structure::Curve*)tnode, sampling_method, output);
@@ -186,6 +189,20 @@ void SynthesisManager::loadSynthesisData(QString parentFolder)
         loadedSamples += Synthesizer::loadSynthesisData(node, parentFolder + foldername + "/[targetGraph]", synthData[tgraph->name()]);
     }
 
+	// Older saves are not in progressive order
+	foreach(Structure::Node * snode, sgraph->nodes)
+	{
+		Structure::Node * tnode = tgraph->getNode( snode->property["correspond"].toString() );
+		if(!tnode || !synthData[sgraph->name()].contains(snode->id)) continue;
+
+		SynthData pair;
+		pair["node1"] = synthData[sgraph->name()][snode->id];
+		pair["node2"] = synthData[tgraph->name()][tnode->id];
+		Synthesizer::makeProgressive( pair );
+		synthData[sgraph->name()][snode->id] = pair["node1"];
+		synthData[tgraph->name()][tnode->id] = pair["node2"];
+	}
+
 	scheduler->property["synthDataReady"] = true;
 
     setMessage("Synth data loaded.");
@@ -270,13 +287,15 @@ void SynthesisManager::renderCurrent(Structure::Graph * currentGraph, QString pa
 }
 
 void SynthesisManager::renderGraph( Structure::Graph graph, QString filename, bool isOutPointCloud, 
-									int reconLevel, bool isOutGraph /*= false*/, bool isOutParts /*= true */ )
+									int reconLevel, bool isOutGraph /*= false*/, bool isOutParts /*= true */, int pointsLimit /*= -1 */ )
 {
+	TRACE_ZONE("SynthesisManager::renderGraph");
+
 	QMap<QString, SurfaceMesh::Model*> reconMeshes;
 
 	renderData.clear();
 
-    geometryMorph(renderData, &graph, false);
+    geometryMorph(renderData, &graph, false, pointsLimit);
 
 	QVector<Node *> usedNodes;
 
@@ -401,7 +420,11 @@ void SynthesisManager::renderGraph( Structure::Graph graph, QString filename, bo
         }
 
 		SimpleMesh mesh;
-		PoissonRecon::makeFromCloud( pointCloudf(finalP), pointCloudf(finalN), mesh, reconLevel );
+		{
+			TRACE_ZONE("PoissonRecon::makeFromCloud");
+			TRACE_COUNTER("poisson octree depth", reconLevel);
+			PoissonRecon::makeFromCloud( pointCloudf(finalP), pointCloudf(finalN), mesh, reconLevel );
+		}
 		
 		reconMeshes[node->id] = new SurfaceMesh::Model;
 		SurfaceMesh::Model* nodeMesh = reconMeshes[node->id];
@@ -683,6 +706,8 @@ void SynthesisManager::drawSampled()
 
 void SynthesisManager::geometryMorph( SynthData & data, Structure::Graph * graph, bool isApprox, int limit )
 {
+	TRACE_ZONE("SynthesisManager::geometryMorph");
+
 	Structure::Graph * activeGraph = scheduler->activeGraph;
 	Structure::Graph * targetGraph = scheduler->targetGraph;
 	QVector<Node*> usedNodes;
@@ -753,52 +778,11 @@ void SynthesisManager::geometryMorph( SynthData & data, Structure::Graph * graph
 			int numSamplesNode = synthData[ag][n->id]["numSamples"].toInt();
 			double relative = double(numSamplesNode) / numTotalSamples;
 
-			// Subsample once
-			if( !synthData[ag][n->id].contains("mask") )
-			{
-				synthData[ag][n->id]["mask"].setValue( subsampleMask(relative * limit, numSamplesNode) );
-			
-				std::vector<bool> mask = synthData[ag][n->id]["mask"].value< std::vector<bool> >();
-
-				QVector< QVector<ParameterCoord> > nsamples(4);
-				QVector< QVector<float> > noffsets(4);
-				QVector< QVector<Vec2f> > nnormals(4);
-
-				nsamples[0] = synthData[ag][n->id]["samples"].value< QVector<ParameterCoord> >();
-				noffsets[0] = synthData[ag][n->id]["offsets"].value< QVector<float> >();
-				nnormals[0] = synthData[ag][n->id]["normals"].value< QVector<Vec2f> >();
-
-				nsamples[1] = synthData[tg][tgnid]["samples"].value< QVector<ParameterCoord> >();
-				noffsets[1] = synthData[tg][tgnid]["offsets"].value< QVector<float> >();
-				nnormals[1] = synthData[tg][tgnid]["normals"].value< QVector<Vec2f> >();
-
-				for(int i = 0; i < numSamplesNode; i++){
-					if(mask[i]){
-						nsamples[2].push_back( nsamples[0][i] );
-						noffsets[2].push_back( noffsets[0][i] );
-						nnormals[2].push_back( nnormals[0][i] );
-
-						nsamples[3].push_back( nsamples[1][i] );
-						noffsets[3].push_back( noffsets[1][i] );
-						nnormals[3].push_back( nnormals[1][i] );
-					}
-				}
-				synthData[ag][n->id]["subsamples"].setValue( nsamples[2] );
-				synthData[ag][n->id]["suboffsets"].setValue( noffsets[2] );
-				synthData[ag][n->id]["subnormals"].setValue( nnormals[2] );
-
-				synthData[tg][tgnid]["subsamples"].setValue( nsamples[3] );
-				synthData[tg][tgnid]["suboffsets"].setValue( noffsets[3] );
-				synthData[tg][tgnid]["subnormals"].setValue( nnormals[3] );
-			}
-
-			ndata["node1"]["samples"] = synthData[ag][n->id]["subsamples"];
-			ndata["node1"]["offsets"] = synthData[ag][n->id]["suboffsets"];
-			ndata["node1"]["normals"] = synthData[ag][n->id]["subnormals"];
+			// Samples are stored in progressive order, so a prefix is a uniform subsample
+			int count = qMax(1, qMin(numSamplesNode, int(relative * limit)));
 
-			ndata["node2"]["samples"] = synthData[tg][tgnid]["subsamples"];
-			ndata["node2"]["offsets"] = synthData[tg][tgnid]["suboffsets"];
-			ndata["node2"]["normals"] = synthData[tg][tgnid]["subnormals"];
+			ndata["node1"] = Synthesizer::samplesPrefix( synthData[ag][n->id], count );
+			ndata["node2"] = Synthesizer::samplesPrefix( synthData[tg][tgnid], count );
 		}
 		else
 		{
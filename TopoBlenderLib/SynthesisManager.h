@@ -15,6 +15,9 @@ class Scheduler;
 class TopoBlender;
 typedef QMap<QString, QMap<QString, QVariant> > SynthData;
 
+// Samples used by quick preview renders, exported shapes always take them all
+#define PREVIEW_POINTS_LIMIT 300000
+
 extern QStack<double> nurbsQuality;
 
 static void inline beginFastNURBS(){
@@ -84,7 +87,7 @@ public slots:
     void renderAll();
 	void renderCurrent();
 	void renderCurrent( Structure::Graph * currentGraph, QString path = "" );
-	void renderGraph( Structure::Graph graph, QString filename, bool isOutPointCloud, int reconLevel, bool isOutGraph = false, bool isOutParts = true );
+	void renderGraph( Structure::Graph graph, QString filename, bool isOutPointCloud, int reconLevel, bool isOutGraph = false, bool isOutParts = true, int pointsLimit = -1 );
 
 	void drawSampled();
 	void geometryMorph( SynthData & data, Structure::Graph * graph, bool isApprox, int limit = -1 );
@@ -12,6 +12,7 @@
 
 #include "Synthesizer.h"
 #include "weld.h"
+#include "Tracing.h"
 Q_DECLARE_METATYPE(RMF)
 Q_DECLARE_METATYPE(RMF::Frame)
 Q_DECLARE_METATYPE(std::vector<RMF::Frame>)
@@ -46,21 +47,14 @@ int uniformTriCount = UNIFORM_TRI_SAMPLES;
 // Helper functions
 RMF Synthesizer::consistentFrame( Structure::Curve * curve, Array1D_Vector4d & coords )
 {
-	// Generate consistent frames along curve
-	std::vector<Scalar> times;
-	curve->curve.SubdivideByLengthTime(CURVE_FRAME_COUNT, times);
-	foreach(Scalar t, times) coords.push_back(Vector4d(t,0,0,0));
-	std::vector<Vector3d> samplePoints;
-	foreach(Vector4d c, coords) samplePoints.push_back( curve->position(c) );
-
-    RMF rmf = RMF( samplePoints );
-	rmf.compute();
-	//rmf.generate();
+	// Consistent frames along curve, rebuilt only when the curve changed
+	QSharedPointer<const Structure::CurveFrames> frames = curve->frames( CURVE_FRAME_COUNT );
+	coords.insert(coords.end(), frames->coords.begin(), frames->coords.end());
 
 	// Save RMF frames
-	curve->property["rmf_frames"].setValue(rmf.U);
+	curve->property["rmf_frames"].setValue(frames->rmf.U);
 
-	return rmf;
+	return frames->rmf;
 }
 
 
@@ -80,13 +74,13 @@ QVector<ParameterCoord> Synthesizer::genPointCoordsCurve( Structure::Curve * cur
 	kdtree.build();
 
 	// Project
+	// Curve evaluation is const, so all threads share it
+	const NURBS::NURBSCurved & mycurve = curve->curve;
 	int N = points.size();
 
 	#pragma omp parallel for
 	for(int i = 0; i < N; i++)
 	{
-		NURBS::NURBSCurved mycurve = curve->curve;
-
 		float theta, psi;
 
 		Vector3f point = points[i];
@@ -133,13 +127,12 @@ QVector<ParameterCoord> Synthesizer::genPointCoordsSheet( Structure::Sheet * she
 	}
 	kdtree.build();
 
+	const NURBS::NURBSRectangled & r = sheet->surface;
 	int N = points.size();
 
 	#pragma omp parallel for
 	for(int i = 0; i < N; i++)
 	{
-		NURBS::NURBSRectangled r = sheet->surface;
-
 		Vector3f point = points[i];
 
 		// Project
@@ -255,12 +248,21 @@ QVector<ParameterCoord> Synthesizer::genUniformCoords(Node *node, float sampling
 }
 
 QVector<ParameterCoord> Synthesizer::genRemeshCoords( Structure::Node * node )
+{
+	std::vector<Vector3f> samplePoints, sampleNormals;
+	remeshPoints( node, samplePoints, sampleNormals );
+
+	if(node->type() == Structure::CURVE)
+		return genPointCoordsCurve((Structure::Curve*)node, samplePoints, sampleNormals);
+	else
+		return genPointCoordsSheet((Structure::Sheet*)node, samplePoints, sampleNormals);
+}
+
+void Synthesizer::remeshPoints( Structure::Node * node, std::vector<Vector3f> & samplePoints, std::vector<Vector3f> & sampleNormals )
 {
 	SurfaceMesh::Model * model = node->property["mesh"].value< QSharedPointer<SurfaceMeshModel> >().data();
 	SurfaceMesh::Model copyModel;
 
-	std::vector<Vector3f> samplePoints, sampleNormals;
-
 	Vector3VertexProperty points = model->vertex_property<Vector3d>(VPOINT);
 
 	foreach(Vertex v, model->vertices()) copyModel.add_vertex( points[v] );
@@ -294,11 +296,6 @@ QVector<ParameterCoord> Synthesizer::genRemeshCoords( Structure::Node * node )
 
 	//foreach(Edge e, copyModel.edges()) 
 	//	samplePoints.push_back( (new_points[copyModel.vertex(e,0)]+new_points[copyModel.vertex(e,1)]) / 2.0 );
-
-	if(node->type() == Structure::CURVE)
-		return genPointCoordsCurve((Structure::Curve*)node, samplePoints, sampleNormals);
-	else
-		return genPointCoordsSheet((Structure::Sheet*)node, samplePoints, sampleNormals);
 }
 
 QVector<ParameterCoord> Synthesizer::genUniformTrisCoords( Structure::Node * node )
@@ -401,6 +398,9 @@ QVector<ParameterCoord> Synthesizer::genSampleCoordsSheet( Structure::Sheet * sh
 // Compute offset and normal for each ray
 void Synthesizer::sampleGeometryCurve( QVector<ParameterCoord> samples, Structure::Curve * curve, QVector<float> &offsets, QVector<Vec2f> &normals )
 {
+	TRACE_ZONE("Synthesizer::sampleGeometryCurve");
+	TRACE_COUNT("ray casts", samples.size());
+
 	SurfaceMesh::Model * model = curve->property["mesh"].value< QSharedPointer<SurfaceMeshModel> >().data();
 
 	model->update_face_normals();
@@ -420,14 +420,12 @@ void Synthesizer::sampleGeometryCurve( QVector<ParameterCoord> samples, Structur
 	RMF rmf = consistentFrame(curve,coords);
 	qDebug() << "Curve RMF count = " << rmf.U.size() << ", Samples = " << samples.size();
 
-	const std::vector<Vector3d> curvePnts = curve->curve.mCtrlPoint;
+	const NURBS::NURBSCurved mycurve = NURBS::NURBSCurved::createCurveFromPoints(curve->curve.mCtrlPoint);
 	int N = samples.size();
 
 	#pragma omp parallel for
 	for(int i = 0; i < N; i++)
 	{
-		NURBS::NURBSCurved mycurve = NURBS::NURBSCurved::createCurveFromPoints(curvePnts);
-
 		ParameterCoord sample = samplesArray[i];
 		
 		int idx = sample.u * (rmf.count() - 1);
@@ -473,6 +471,9 @@ void Synthesizer::sampleGeometryCurve( QVector<ParameterCoord> samples, Structur
 
 void Synthesizer::sampleGeometrySheet( QVector<ParameterCoord> samples, Structure::Sheet * sheet, QVector<float> &offsets, QVector<Vec2f> &normals )
 {
+	TRACE_ZONE("Synthesizer::sampleGeometrySheet");
+	TRACE_COUNT("ray casts", samples.size());
+
 	SurfaceMesh::Model * model = sheet->property["mesh"].value< QSharedPointer<SurfaceMeshModel> >().data();
 
 	model->update_face_normals();
@@ -489,14 +490,12 @@ void Synthesizer::sampleGeometrySheet( QVector<ParameterCoord> samples, Structur
 
 	const ParameterCoord * samplesArray = samples.data();
 
-	const Array2D_Vector3 sheetPnts = sheet->surface.mCtrlPoint;
+	const NURBS::NURBSRectangled r = NURBS::NURBSRectangled::createSheetFromPoints(sheet->surface.mCtrlPoint);
 	int N = samples.size();
 
 	#pragma omp parallel for
 	for(int i = 0; i < N; i++)
 	{
-		NURBS::NURBSRectangled r = NURBS::NURBSRectangled::createSheetFromPoints(sheetPnts);
-
 		ParameterCoord sample = samplesArray[i];
 
 		Vector3d X(0,0,0), Y(0,0,0), Z(0,0,0);
@@ -541,8 +540,7 @@ void Synthesizer::prepareSynthesizeCurve( Structure::Curve * curve1, Structure::
 {
 	if(!curve1 || !curve2 || !curve1->property.contains("mesh") || !curve2->property.contains("mesh")) return;
 
-	QElapsedTimer timer; timer.start();
-	qDebug() << "Generating samples..";
+	TRACE_ZONE("Synthesizer::prepareSynthesizeCurve");
 
 	QVector<ParameterCoord> samples;
 	QVector<float> offsets1, offsets2;
@@ -574,9 +572,7 @@ void Synthesizer::prepareSynthesizeCurve( Structure::Curve * curve1, Structure::
 		sort(samples.begin(), samples.end());
 	}
 
-	qDebug() << QString("Samples Time [ %1 ms ]").arg(timer.elapsed());timer.restart();
-
-	qDebug() << "Re-sampling mesh..";
+	TRACE_COUNT("samples", samples.size());
 
 	// Compute offset and normal for each ray
 	{
@@ -595,15 +591,14 @@ void Synthesizer::prepareSynthesizeCurve( Structure::Curve * curve1, Structure::
 		output["node2"]["samplesCount"] = samples.size();
 	}
 
-	qDebug() << QString("Resampling Time [ %1 ms ]\n==\n").arg(timer.elapsed());
+	makeProgressive( output );
 }
 
 void Synthesizer::prepareSynthesizeSheet( Structure::Sheet * sheet1, Structure::Sheet * sheet2, int s, SynthData & output  )
 {
 	if(!sheet1 || !sheet2 || !sheet1->property.contains("mesh") || !sheet2->property.contains("mesh")) return;
 
-	QElapsedTimer timer; timer.start();
-	qDebug() << "Generating samples..";
+	TRACE_ZONE("Synthesizer::prepareSynthesizeSheet");
 
 	QVector<ParameterCoord> samples;
 	QVector<float> offsets1, offsets2;
@@ -619,9 +614,7 @@ void Synthesizer::prepareSynthesizeSheet( Structure::Sheet * sheet1, Structure::
 		if(sheet1 != sheet2) samples += genSampleCoordsSheet(sheet2, s);
 	}
 
-	qDebug() << QString("Samples Time [ %1 ms ]").arg(timer.elapsed());timer.restart();
-
-	qDebug() << "Re-sampling mesh..";
+	TRACE_COUNT("samples", samples.size());
 
 	// Re-sample the meshes
 	{	
@@ -643,13 +636,134 @@ void Synthesizer::prepareSynthesizeSheet( Structure::Sheet * sheet1, Structure::
 		output["node2"]["samplesCount"] = samples.size();
 	}
 
-	qDebug() << QString("Resampling Time [ %1 ms ]\n==\n").arg(timer.elapsed());
+	makeProgressive( output );
+}
+
+/// PROGRESSIVE ORDERING
+static inline quint32 sampleHash( const ParameterCoord & s )
+{
+	// Depends only on the sample itself, so re-ordering an ordered set is a no-op
+	float f[4] = { s.u, s.v, s.theta, s.psi };
+	quint32 h = 2166136261u;
+	for(int i = 0; i < 4; i++){
+		quint32 b; memcpy(&b, &f[i], sizeof(b));
+		h = (h ^ b) * 16777619u;
+		h ^= h >> 15;
+	}
+	return h;
+}
+
+QVector<int> Synthesizer::progressiveOrder( const QVector<ParameterCoord> & samples, const QVector<float> & offsets )
+{
+	int N = samples.size();
+	QVector<int> order(N);
+	if(N == 0) return order;
+
+	// Position proxy in the node's parameter space: skeleton coordinate plus the ray direction scaled by its offset
+	float maxOffset = 1e-6f;
+	for(int i = 0; i < offsets.size(); i++) maxOffset = qMax(maxOffset, std::abs(offsets[i]));
+
+	QVector<Vector3f> keys(N);
+	Vector3f minKey = Vector3f::Constant( 1e30f ), maxKey = Vector3f::Constant( -1e30f );
+	for(int i = 0; i < N; i++)
+	{
+		const ParameterCoord & s = samples[i];
+		float r = (i < offsets.size()) ? 0.5f * offsets[i] / maxOffset : 0.0f;
+		Vector3f dir( sin(s.theta) * cos(s.psi), sin(s.theta) * sin(s.psi), cos(s.theta) );
+		keys[i] = Vector3f(s.u, s.v, 0) + dir * r;
+		minKey = minKey.cwiseMin(keys[i]);
+		maxKey = maxKey.cwiseMax(keys[i]);
+	}
+	float extent = qMax(1e-6f, (maxKey - minKey).maxCoeff());
+
+	// Visit samples in a pseudo-random but sample-determined order
+	std::vector< std::pair<quint32,int> > visit(N);
+	for(int i = 0; i < N; i++) visit[i] = std::make_pair(sampleHash(samples[i]), i);
+	std::sort(visit.begin(), visit.end());
+
+	// Each sample takes the coarsest grid level whose cell is still empty
+	int maxLevel = 1;
+	while(maxLevel < 8 && (1 << (3 * maxLevel)) < N) maxLevel++;
+
+	QVector< QSet<quint32> > occupied(maxLevel + 1);
+	std::vector< std::pair<int,int> > ranked(N);
+	for(int k = 0; k < N; k++)
+	{
+		int i = visit[k].second;
+		Vector3f p = (keys[i] - minKey) / extent;
+
+		int level = maxLevel + 1;
+		for(int l = 0; l <= maxLevel; l++)
+		{
+			int res = 1 << l;
+			quint32 x = qMin(res - 1, int(p[0] * res)), y = qMin(res - 1, int(p[1] * res)), z = qMin(res - 1, int(p[2] * res));
+			quint32 cell = (x << 16) | (y << 8) | z;
+			if( !occupied[l].contains(cell) ){
+				occupied[l].insert(cell);
+				level = l;
+				break;
+			}
+		}
+
+		ranked[k] = std::make_pair(level, k);
+	}
+
+	// Coarse levels first, visit order within a level
+	std::sort(ranked.begin(), ranked.end());
+	for(int k = 0; k < N; k++) order[k] = visit[ ranked[k].second ].second;
+
+	return order;
+}
+
+template<typename T>
+static inline QVector<T> permuted( const QVector<T> & v, const QVector<int> & order )
+{
+	if(v.size() != order.size()) return v;
+	QVector<T> result(v.size());
+	for(int i = 0; i < order.size(); i++) result[i] = v[ order[i] ];
+	return result;
+}
+
+void Synthesizer::makeProgressive( SynthData & data )
+{
+	QVector<ParameterCoord> samples = data["node1"]["samples"].value< QVector<ParameterCoord> >();
+	if(samples.isEmpty()) return;
+
+	QVector<int> order = progressiveOrder( samples, data["node1"]["offsets"].value< QVector<float> >() );
+
+	// Both nodes share the same rays, so they are permuted together
+	QStringList nodeKeys; nodeKeys << "node1" << "node2";
+	foreach(QString key, nodeKeys)
+	{
+		if(!data.contains(key) || !data[key].contains("samples")) continue;
+
+		data[key]["samples"].setValue( permuted(data[key]["samples"].value< QVector<ParameterCoord> >(), order) );
+		data[key]["offsets"].setValue( permuted(data[key]["offsets"].value< QVector<float> >(), order) );
+		data[key]["normals"].setValue( permuted(data[key]["normals"].value< QVector<Vec2f> >(), order) );
+	}
+}
+
+QMap<QString, QVariant> Synthesizer::samplesPrefix( const QMap<QString, QVariant> & nodeData, int count )
+{
+	QMap<QString, QVariant> result = nodeData;
+
+	QVector<ParameterCoord> samples = nodeData["samples"].value< QVector<ParameterCoord> >();
+	if(count < 0 || count >= samples.size()) return result;
+
+	result["samples"].setValue( samples.mid(0, count) );
+	result["offsets"].setValue( nodeData["offsets"].value< QVector<float> >().mid(0, count) );
+	result["normals"].setValue( nodeData["normals"].value< QVector<Vec2f> >().mid(0, count) );
+	result["samplesCount"] = count;
+
+	return result;
 }
 
 /// RECONSTRUCTION
 void Synthesizer::reconstructGeometryCurve( Structure::Curve * base_curve, const QVector<ParameterCoord> & in_samples, const QVector<float> &in_offsets,
 	const QVector<Vec2f> &in_normals, QVector<Vector3f> &out_points, QVector<Vector3f> &out_normals, bool isApprox )
 {
+	TRACE_ZONE("Synthesizer::reconstructGeometryCurve");
+
 	// Clear
 	out_points.clear();
 	out_points.resize(in_samples.size());
@@ -674,7 +788,7 @@ void Synthesizer::reconstructGeometryCurve( Structure::Curve * base_curve, const
 		if(!proxy.size()) isApprox = false;
 	}
 
-	const std::vector<Vector3d> curvePnts = base_curve->curve.mCtrlPoint;
+	const NURBS::NURBSCurved baseCurve = NURBS::NURBSCurved::createCurveFromPoints(base_curve->curve.mCtrlPoint);
 
 	int N = in_samples.size();
 
@@ -694,10 +808,7 @@ void Synthesizer::reconstructGeometryCurve( Structure::Curve * base_curve, const
 		if(isApprox)
 			rayPos = proxy[ sample.u * (proxy.size()-1) ];
 		else
-		{
-			NURBS::NURBSCurved c = NURBS::NURBSCurved::createCurveFromPoints(curvePnts);
-			rayPos = c.GetPosition(sample.u).cast<float>();
-		}
+			rayPos = baseCurve.GetPosition(sample.u).cast<float>();
 
 		localSphericalToGlobal(X, Y, Z, sample.theta, sample.psi, rayDir);
 
@@ -722,6 +833,8 @@ void Synthesizer::reconstructGeometryCurve( Structure::Curve * base_curve, const
 void Synthesizer::reconstructGeometrySheet( Structure::Sheet * base_sheet, const QVector<ParameterCoord> &in_samples, const QVector<float> &in_offsets,
 	const QVector<Vec2f> &in_normals, QVector<Vector3f> &out_points, QVector<Vector3f> &out_normals, bool isApprox )
 {
+	TRACE_ZONE("Synthesizer::reconstructGeometrySheet");
+
 	out_points.clear();
 	out_points.resize(in_samples.size());
 
@@ -751,7 +864,7 @@ void Synthesizer::reconstructGeometrySheet( Structure::Sheet * base_sheet, const
 			isApprox = false;
 	}
 
-	const Array2D_Vector3 sheetPnts = base_sheet->surface.mCtrlPoint;
+	const NURBS::NURBSRectangled r = NURBS::NURBSRectangled::createSheetFromPoints(base_sheet->surface.mCtrlPoint);
 
 	int N = in_samples.size();
 
@@ -773,10 +886,7 @@ void Synthesizer::reconstructGeometrySheet( Structure::Sheet * base_sheet, const
 			_Z = proxy[u][v][3];
 		}
 		else
-		{
-			NURBS::NURBSRectangled r = NURBS::NURBSRectangled::createSheetFromPoints(sheetPnts);
 			r.GetFrame( sample.u, sample.v, sheetPoint, _X, vDirection, _Z );
-		}
 
 		rayPos = Vector3f(sheetPoint[0],sheetPoint[1],sheetPoint[2]);
 
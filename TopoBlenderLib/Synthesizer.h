@@ -51,6 +51,7 @@ struct Synthesizer{
     static QVector<ParameterCoord> genRandomCoords( Structure::Node * node, int samples_count );
 	static QVector<ParameterCoord> genUniformCoords( Structure::Node * node, float sampling_resolution = -1);
 	static QVector<ParameterCoord> genRemeshCoords( Structure::Node * node );
+	static void remeshPoints( Structure::Node * node, std::vector<Eigen::Vector3f> & points, std::vector<Eigen::Vector3f> & normals );
 	static QVector<ParameterCoord> genUniformTrisCoords( Structure::Node * node );
 
 	static QVector<ParameterCoord> genSampleCoordsCurve(Structure::Curve * curve, int samplingType = Features | Random);
@@ -65,6 +66,11 @@ struct Synthesizer{
 
 	static void prepareSynthesizeCurve( Structure::Curve * curve1, Structure::Curve * curve2, int samplingType, SynthData & output );
 	static void prepareSynthesizeSheet( Structure::Sheet * sheet1, Structure::Sheet * sheet2, int samplingType, SynthData & output );
+
+	// Progressive ordering: reorders samples so that any prefix is a spatially uniform subsample
+	static QVector<int> progressiveOrder( const QVector<ParameterCoord> & samples, const QVector<float> & offsets );
+	static void makeProgressive( SynthData & data );
+	static QMap<QString, QVariant> samplesPrefix( const QMap<QString, QVariant> & nodeData, int count );
 	
 	// Blend geometries
 	static void blendGeometryCurves( Structure::Curve * curve, float alpha, const SynthData & data, QVector<Eigen::Vector3f> &points, QVector<Eigen::Vector3f> &normals, bool isApprox);
@@ -343,11 +343,97 @@ void Task::prepare()
         prepareSheet();
 	}
 
+	compilePlan();
+
 	this->isReady = true;
 	node()->property["isReady"] = true;
 	node()->property["taskIsReady"] = true;
 }
 
+void Task::compilePlan()
+{
+	Node * n = node();
+	bool isSheet = (n->type() == Structure::SHEET);
+
+	plan = ExecutionPlan();
+
+	// Edges with their target counterparts, looked up by value so no empty entries get inserted
+	foreach(int uid, property.value("edges").value< QVector<int> >())
+	{
+		PlanEdge e;
+		e.uid = uid;
+
+		Link * l = active->getEdge(uid);
+		e.targetLink = l ? target->getEdge( l->property["correspond"].toInt() ) : NULL;
+		e.sourceDelta = l ? l->property["delta"].value<Vector3d>() : Vector3d(0,0,0);
+		e.targetDelta = e.targetLink ? e.targetLink->property["delta"].value<Vector3d>() : Vector3d(0,0,0);
+
+		plan.edges.push_back(e);
+	}
+
+	// Folding
+	plan.hasDeltas = property.contains("deltas");
+	if( isSheet )
+	{
+		plan.orgCtrlPoints2D = property.value("orgCtrlPoints").value<Array2D_Vector3>();
+		plan.deltas2D = property.value("deltas").value<Array2D_Vector3>();
+	}
+	else
+	{
+		plan.orgCtrlPoints = property.value("orgCtrlPoints").value<Array1D_Vector3>();
+		plan.deltas = property.value("deltas").value<Array1D_Vector3>();
+	}
+
+	// Paths
+	plan.hasPath = property.contains("path");
+	plan.path = property.value("path").value<Array1D_Vector3>();
+
+	plan.hasPaths = property.contains("pathA") && property.contains("pathB");
+	if( isSheet )
+	{
+		plan.relativePathA = property.value("pathA").value< QVector< GraphDistance::PathPointPair > >();
+		plan.relativePathB = property.value("pathB").value< QVector< GraphDistance::PathPointPair > >();
+	}
+	else
+	{
+		plan.pathA = property.value("pathA").value<Array1D_Vector3>();
+		plan.pathB = property.value("pathB").value<Array1D_Vector3>();
+	}
+
+	// Encoding
+	plan.hasEncoding = property.contains("cpCoords");
+	plan.cpCoords = Curve::flatEncoding( property.value("cpCoords").value<CurveEncoding>() );
+	plan.cpCoordsT = Curve::flatEncoding( property.value("cpCoordsT").value<CurveEncoding>() );
+
+	plan.sourceA = property.value("sourceA").value<Vector3>();
+	plan.sourceB = property.value("sourceB").value<Vector3>();
+	plan.targetA = property.value("targetA").value<Vector3>();
+	plan.targetB = property.value("targetB").value<Vector3>();
+
+	plan.sframe = property.value("sframe").value<RMF::Frame>();
+	plan.tframe = property.value("tframe").value<RMF::Frame>();
+
+	QVector<double> rot = property.value("rotation").value< QVector<double> >();
+	if(rot.size() != 4) { rot.clear(); rot << 1 << 0 << 0 << 0; }
+	for(int i = 0; i < 4; i++) plan.rotation[i] = rot[i];
+
+	plan.isCompiled = true;
+}
+
+// Index of the first planned edge, walking from 'from' by 'step', that is still in the active graph
+int Task::plannedEdge( int from, int step, Structure::Link *& link )
+{
+	link = NULL;
+
+	for(int i = from; i >= 0 && i < plan.edges.size(); i += step)
+	{
+		link = active->getEdge( plan.edges[i].uid );
+		if( link ) return i;
+	}
+
+	return -1;
+}
+
 QVector<Structure::Link*> Task::filterEdges( Structure::Node * n, QVector<Structure::Link*> allEdges )
 {
 	// Check edge's real ownership
@@ -806,10 +892,11 @@ void Task::executeMorphEdges( double t )
 {
 	Node * n = node();
 
-	QVector<Structure::Link*> edges = active->getEdges( property["edges"].value< QVector<int> >() );
-
-	foreach (Structure::Link* link, edges)
+	foreach (const PlanEdge & e, plan.edges)
 	{
+		Structure::Link* link = active->getEdge( e.uid );
+		if(!link) continue;
+
 		QVector< GraphDistance::PathPointPair > path = link->property["path"].value< QVector< GraphDistance::PathPointPair > >();
 		if(!path.size()) continue;
 
@@ -864,12 +951,9 @@ bool Task::isCrossing()
 
 bool Task::isCutting( bool isSkipUngrown )
 {
-	bool result = false;
-
-	Structure::Graph copyActive (*active);
-
-	// Clean up
-	copyActive.removeIsolatedNodes();
+	// Connectivity of the active graph without flying nodes
+	Structure::ConnectivityView view( active );
+	view.excludeIsolated();
 
 	// Exclude nodes that is active and non-existing
 	QSet<QString> excludeNodes;
@@ -880,49 +964,29 @@ bool Task::isCutting( bool isSkipUngrown )
 	// Skip un-grown nodes
 	if( isSkipUngrown )
 	{
-		foreach(Node* n, active->nodes)
-		{
-			if ( ungrownNode(n->id) ) 
-			{
-				// If it cuts the graph, check if both halves have grown nodes 
-				if( copyActive.isCutNode(n->id) )
-				{
-					int numGrownComponents = 0;
+		QVector<bool> isGrown( active->nodes.size() );
+		for(int i = 0; i < active->nodes.size(); i++)
+			isGrown[i] = !ungrownNode( active->nodes[i]->id );
 
-					Structure::Graph cutCheckGraph ( copyActive );
-					cutCheckGraph.removeNode(n->id);
+		view.setMarked( isGrown );
 
-					foreach(QSet<QString> component, cutCheckGraph.connectedComponents())
-					{
-						bool hasGrown = false;
-
-						foreach(QString element, component){
-							if( !ungrownNode(element) ){
-								hasGrown = true;
-								break;
-							}
-						}
-
-						if( hasGrown )
-							numGrownComponents++;
-					}
+		for(int i = 0; i < active->nodes.size(); i++)
+		{
+			if ( isGrown[i] ) continue;
 
-					if( numGrownComponents > 1 )
-						continue;
-				}
+			// If it cuts the graph, keep it when both halves have grown nodes 
+			if( view.isCutNode(i) && view.markedComponentsWithout(i) > 1 )
+				continue;
 
-				excludeNodes.insert(n->id);
-			}
+			excludeNodes.insert( active->nodes[i]->id );
 		}
 	}
 
 	// Keep myself in graph for checking
 	excludeNodes.remove(nodeID);
-	foreach (QString nid, excludeNodes)	copyActive.removeNode(nid);
-
-	result = copyActive.isCutNode(nodeID);
+	foreach (QString nid, excludeNodes)	view.exclude( view.index(nid) );
 
-	return result;
+	return view.isCutNode( view.index(nodeID) );
 }
 
 bool Task::ungrownNode( QString nid )
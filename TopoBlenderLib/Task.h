@@ -3,6 +3,7 @@
 #include <QGraphicsDropShadowEffect>
 #include "TopoBlender.h"
 #include "RMF.h"
+#include "GraphDistance.h"
 
 class Task : public QGraphicsObject
 {
@@ -74,6 +75,36 @@ public:
 
 	QString nodeID;
 
+	// Execution plan: typed copy of the prepared properties, compiled once at the end of prepare()
+	// so that executing a step does not decode QVariants or resolve target links again
+	struct PlanEdge{
+		int uid;
+		Structure::Link * targetLink;
+		Vector3d sourceDelta, targetDelta;
+	};
+	struct ExecutionPlan{
+		bool isCompiled;
+		QVector<PlanEdge> edges;
+
+		bool hasDeltas, hasPath, hasPaths, hasEncoding;
+		Array1D_Vector3 orgCtrlPoints, deltas;
+		Array2D_Vector3 orgCtrlPoints2D, deltas2D;
+		Array1D_Vector3 path, pathA, pathB;
+		QVector< GraphDistance::PathPointPair > relativePathA, relativePathB;
+		Array1D_Vector4d cpCoords, cpCoordsT;
+		Vector3 sourceA, sourceB, targetA, targetB;
+		RMF::Frame sframe, tframe;
+		double rotation[4];
+
+		// Decoding buffers, reused across steps
+		Array1D_Vector3 points, pointsT;
+
+		ExecutionPlan() : isCompiled(false), hasDeltas(false), hasPath(false), hasPaths(false), hasEncoding(false) {}
+	};
+	ExecutionPlan plan;
+	void compilePlan();
+	int plannedEdge( int from, int step, Structure::Link *& link );
+
 	// Time related
 	int start;
 	int length;
@@ -446,7 +446,7 @@ void TaskCurve::executeCurve(double t)
 	case GROW:
 	case SHRINK:
 		{
-			if ( property.contains("deltas") )	foldCurve(t);
+			if ( plan.hasDeltas )	foldCurve(t);
 			else executeCrossingCurve(t);
 		}
 		break;
@@ -467,20 +467,21 @@ void TaskCurve::foldCurve( double t )
 	Curve* structure_curve = ((Curve*)n);
 
 	// Grow curve
-	Array1D_Vector3 cpts = property["orgCtrlPoints"].value<Array1D_Vector3>();
-	Array1D_Vector3 deltas = property["deltas"].value<Array1D_Vector3>();
+	const Array1D_Vector3 & cpts = plan.orgCtrlPoints;
+	const Array1D_Vector3 & deltas = plan.deltas;
 
 	if(cpts.size() != deltas.size()) return;
 	for(int u = 0; u < structure_curve->curve.mNumCtrlPoints; u++)
 		structure_curve->curve.mCtrlPoint[u] = cpts[u] + (deltas[u] * t);
 
-	// Placement
-	QVector<Link*> edges = active->getEdges( property["edges"].value< QVector<int> >() );
-
-	// Only valid edges
-	QVector<Link*> keep;
-	foreach(Link* l, edges) if(l->hasNode(n->id)) keep.push_back(l);
-	edges = keep;
+	// Placement, only valid edges
+	QVector<Link*> edges;
+	int planned = -1;
+	for(int i = 0; i < plan.edges.size() && edges.isEmpty(); i++)
+	{
+		Link * l = active->getEdge( plan.edges[i].uid );
+		if(l && l->hasNode(n->id)) { edges.push_back(l); planned = i; }
+	}
 
 	// Something went wrong..
 	if( edges.isEmpty() ){
@@ -512,7 +513,7 @@ void TaskCurve::foldCurve( double t )
 
 	if(this->type == Task::GROW) 
 	{
-		Link * tl = target->getEdge( l->property["correspond"].toInt() );
+		Link * tl = (planned < 0) ? target->getEdge( l->property["correspond"].toInt() ) : plan.edges[planned].targetLink;
 		delta = tl->delta();
 	}
 
@@ -526,34 +527,36 @@ void TaskCurve::executeCrossingCurve( double t )
 {
     Node *n = node();
 
-	QVector<Link*> edges = active->getEdges( property["edges"].value< QVector<int> >() );
+	// First and last planned edges still in the graph
+	Structure::Link *slinkA = NULL, *slinkB = NULL;
+	int ia = plannedEdge(0, 1, slinkA);
+	int ib = plannedEdge(plan.edges.size() - 1, -1, slinkB);
 
-	if (property.contains("path"))
+	if (plan.hasPath)
 	{
 		// Blend the geometry
 		executeMorphCurve(t);
 
+		if(ia < 0) return;
+
 		// Move it to the correct position
-		Array1D_Vector3 path = property["path"].value< Array1D_Vector3 >();
+		const Array1D_Vector3 & path = plan.path;
 		int idx = t * (path.size() - 1);
 		Vector3 point = path[idx];
 
-		Link* link = edges.front();
-		Vector3 oldPos = link->position(n->id);
+		Vector3 oldPos = slinkA->position(n->id);
 
 		// Blend Deltas, directions are the same as source
-        Structure::Link *slink = edges.front();
-		Vector3d sDelta = slink->property["delta"].value<Vector3d>();
+		Vector3d sDelta = plan.edges[ia].sourceDelta;
 		if (type == Task::GROW) sDelta = Vector3d(0,0,0);
 
-		Structure::Link* tlink = target->getEdge(slink->property["correspond"].toInt());
-		Vector3d tDelta = tlink->property["delta"].value<Vector3d>();
+		Vector3d tDelta = plan.edges[ia].targetDelta;
 		if (type == Task::SHRINK) tDelta = Vector3d(0,0,0);
 
 		Vector3d delta = AlphaBlend(t, sDelta, tDelta);
 
 		// Deltas to myself
-		if (slink->n1->id == n->id) delta *= -1;
+		if (slinkA->n1->id == n->id) delta *= -1;
 
 		Vector3 newPos = point + delta;
 
@@ -562,14 +565,14 @@ void TaskCurve::executeCrossingCurve( double t )
 	}
 
 	// Walk along using two edges
-	if(property.contains("pathA") && property.contains("pathB"))
+	if(plan.hasPaths)
 	{
-		Array1D_Vector3 pathA = property["pathA"].value< Array1D_Vector3 >();
-		Array1D_Vector3 pathB = property["pathB"].value< Array1D_Vector3 >();
+		const Array1D_Vector3 & pathA = plan.pathA;
+		const Array1D_Vector3 & pathB = plan.pathB;
 
 		int nA = pathA.size(), nB = pathB.size();
 
-		if(nA == 0 || nB == 0 || edges.isEmpty())  return;
+		if(nA == 0 || nB == 0 || ia < 0)  return;
 
 		int idxA = t * (pathA.size() - 1);
 		int idxB = t * (pathB.size() - 1);
@@ -578,20 +581,13 @@ void TaskCurve::executeCrossingCurve( double t )
 		Vector3 pointA = pathA[idxA];
 		Vector3 pointB = pathB[idxB];
 
-		// Decode
-		SheetEncoding cpCoords = property["cpCoords"].value<SheetEncoding>();
-		SheetEncoding cpCoordsT = property["cpCoordsT"].value<SheetEncoding>();
-
 		// Blend Deltas, directions are the same as source
-		Structure::Link *slinkA = edges.front(), *slinkB = edges.back();
-		Vector3d sDeltaA = slinkA->property["delta"].value<Vector3d>();
-		Vector3d sDeltaB = slinkB->property["delta"].value<Vector3d>();
+		Vector3d sDeltaA = plan.edges[ia].sourceDelta;
+		Vector3d sDeltaB = plan.edges[ib].sourceDelta;
 		if (type == Task::GROW) {sDeltaA = Vector3d(0,0,0); sDeltaB = Vector3d(0,0,0);}
 
-		Structure::Link* tlinkA = target->getEdge(slinkA->property["correspond"].toInt());
-		Structure::Link* tlinkB = target->getEdge(slinkB->property["correspond"].toInt());
-		Vector3d tDeltaA = tlinkA->property["delta"].value<Vector3d>();
-		Vector3d tDeltaB = tlinkB->property["delta"].value<Vector3d>();
+		Vector3d tDeltaA = plan.edges[ia].targetDelta;
+		Vector3d tDeltaB = plan.edges[ib].targetDelta;
 		if (type == Task::SHRINK) {tDeltaA = Vector3d(0,0,0); tDeltaB = Vector3d(0,0,0);}
 
 		Vector3d deltaA = AlphaBlend(t, sDeltaA, tDeltaA);
@@ -601,19 +597,18 @@ void TaskCurve::executeCrossingCurve( double t )
 		if (slinkA->n1->id == n->id) deltaA *= -1;
 		if (slinkB->n1->id == n->id) deltaB *= -1;
 
-		Array1D_Vector3 newPnts = Curve::decodeCurve(property["cpCoords"].value<CurveEncoding>(), pointA + deltaA, pointB + deltaB);
-		Array1D_Vector3 newPntsT = Curve::decodeCurve(property["cpCoordsT"].value<CurveEncoding>(), pointA + deltaA, pointB + deltaB);
+		// Decode
+		Array1D_Vector3 & newPnts = plan.points;
+		Array1D_Vector3 & newPntsT = plan.pointsT;
+		Curve::decodeCurve(plan.cpCoords, pointA + deltaA, pointB + deltaB, 1.0, newPnts);
+		Curve::decodeCurve(plan.cpCoordsT, pointA + deltaA, pointB + deltaB, 1.0, newPntsT);
 
 		if(!newPntsT.size()) newPntsT = newPnts;
 
-		Array1D_Vector3 blendedPnts;
-
 		for(int i = 0; i < (int)newPnts.size(); i++)
-		{
-			blendedPnts.push_back( AlphaBlend(t, newPnts[i], newPntsT[i]) );
-		}
+			newPnts[i] = AlphaBlend(t, newPnts[i], newPntsT[i]);
 
-		n->setControlPoints( blendedPnts );
+		n->setControlPoints( newPnts );
 	}
 }
 
@@ -622,18 +617,17 @@ void TaskCurve::executeMorphCurve( double t )
     Node *n = node();
 
 	// Blend controlling "line segment"
-	Vector3 pointA = AlphaBlend(t, property["sourceA"].value<Vector3>(), property["targetA"].value<Vector3>());
-	Vector3 pointB = AlphaBlend(t, property["sourceB"].value<Vector3>(), property["targetB"].value<Vector3>());
+	Vector3 pointA = AlphaBlend(t, plan.sourceA, plan.targetA);
+	Vector3 pointB = AlphaBlend(t, plan.sourceB, plan.targetB);
 
 	// Blend geometry of skeleton
-	CurveEncoding cpCoords = property["cpCoords"].value<CurveEncoding>();
-	CurveEncoding cpCoordsT = property["cpCoordsT"].value<CurveEncoding>();
-	Array1D_Vector3 newPnts = Curve::decodeCurve(property["cpCoords"].value<CurveEncoding>(), pointA, pointB);
-	Array1D_Vector3 newPntsT = Curve::decodeCurve(property["cpCoordsT"].value<CurveEncoding>(), pointA, pointB);
+	Array1D_Vector3 & newPnts = plan.points;
+	Array1D_Vector3 & newPntsT = plan.pointsT;
+	Curve::decodeCurve(plan.cpCoords, pointA, pointB, 1.0, newPnts);
+	Curve::decodeCurve(plan.cpCoordsT, pointA, pointB, 1.0, newPntsT);
 
-	Array1D_Vector3 blendedPnts;
 	for(int i = 0; i < (int)newPnts.size(); i++) 
-		blendedPnts.push_back( AlphaBlend(t, newPnts[i], newPntsT[i]) );
+		newPnts[i] = AlphaBlend(t, newPnts[i], newPntsT[i]);
 	
-	n->setControlPoints( blendedPnts );
+	n->setControlPoints( newPnts );
 }
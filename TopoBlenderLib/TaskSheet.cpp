@@ -153,13 +153,12 @@ void TaskSheet::prepareGrowShrinkSheet()
 void TaskSheet::executeGrowShrinkSheet(double t)
 {
 	Structure::Sheet* structure_sheet = ((Structure::Sheet*)node());
-	QVector<Link*> edges = active->getEdges( property["edges"].value< QVector<int> >() );
 
 	/// Single edge case
-	if ( property.contains("deltas") )
+	if ( plan.hasDeltas )
 	{
-		Array2D_Vector3 cpts = property["orgCtrlPoints"].value<Array2D_Vector3>();
-		Array2D_Vector3 deltas = property["deltas"].value<Array2D_Vector3>();
+		const Array2D_Vector3 & cpts = plan.orgCtrlPoints2D;
+		const Array2D_Vector3 & deltas = plan.deltas2D;
 
 		// Grow sheet
 		for(int u = 0; u < structure_sheet->surface.mNumUCtrlPoints; u++)
@@ -168,12 +167,17 @@ void TaskSheet::executeGrowShrinkSheet(double t)
 	}
 
 	/// Two edges case
-	if( property.contains("pathA") && property.contains("pathB") && property.contains("cpCoords") )
+	if( plan.hasPaths && plan.hasEncoding )
 	{
-		QVector< GraphDistance::PathPointPair > pathA = property["pathA"].value< QVector< GraphDistance::PathPointPair > >();
-		QVector< GraphDistance::PathPointPair > pathB = property["pathB"].value< QVector< GraphDistance::PathPointPair > >();
+		const QVector< GraphDistance::PathPointPair > & pathA = plan.relativePathA;
+		const QVector< GraphDistance::PathPointPair > & pathB = plan.relativePathB;
 		if(pathA.size() == 0 || pathB.size() == 0)	return;
 
+		Structure::Link *linkA = NULL, *linkB = NULL;
+		int ia = plannedEdge(0, 1, linkA);
+		int ib = plannedEdge(plan.edges.size() - 1, -1, linkB);
+		if(ia < 0) return;
+
 		double dt = t;
 		if(type == SHRINK) dt = 1 - t;
 
@@ -186,17 +190,12 @@ void TaskSheet::executeGrowShrinkSheet(double t)
 		Vector3 pointA = pathA[idxA].position(active);
 		Vector3 pointB = pathB[idxB].position(active);
 
-		Structure::Link *linkA = edges.front(), *linkB = edges.back();
-		if (type == GROW){
-			linkA = target->getEdge(linkA->property["correspond"].toInt());
-			linkB = target->getEdge(linkB->property["correspond"].toInt());
-		}
-
-		Vector3d deltaA = linkA->property["delta"].value<Vector3d>() * dt;
-		Vector3d deltaB = linkB->property["delta"].value<Vector3d>() * dt;
+		// Growing sheets follow the target edges
+		Vector3d deltaA = ((type == GROW) ? plan.edges[ia].targetDelta : plan.edges[ia].sourceDelta) * dt;
+		Vector3d deltaB = ((type == GROW) ? plan.edges[ib].targetDelta : plan.edges[ib].sourceDelta) * dt;
 
-		Array1D_Vector3 decoded = Curve::decodeCurve(property["cpCoords"].value<CurveEncoding>(), pointA + deltaA, pointB + deltaB, decodeT);
-		structure_sheet->setControlPoints( decoded );
+		Curve::decodeCurve(plan.cpCoords, pointA + deltaA, pointB + deltaB, decodeT, plan.points);
+		structure_sheet->setControlPoints( plan.points );
 	}
 }
 
@@ -266,14 +265,9 @@ void TaskSheet::executeMorphSheet( double t )
     Structure::Node * n = node();
     Structure::Sheet * sheet = (Structure::Sheet *)n;
 
-    // Decode
-    SheetEncoding cpCoords = property["cpCoords"].value<SheetEncoding>();
-    SheetEncoding cpCoordsT = property["cpCoordsT"].value<SheetEncoding>();
-
-    RMF::Frame sframe = property["sframe"].value<RMF::Frame>();
-    RMF::Frame tframe = property["tframe"].value<RMF::Frame>();
-	QVector<double> rot = property["rotation"].value< QVector<double> >();
-    Eigen::Quaterniond rotation(rot[0],rot[1],rot[2],rot[3]),
+    const RMF::Frame & sframe = plan.sframe;
+    RMF::Frame tframe = plan.tframe;
+    Eigen::Quaterniond rotation(plan.rotation[0],plan.rotation[1],plan.rotation[2],plan.rotation[3]),
         eye = Eigen::Quaterniond::Identity();
 
     // Source sheet
@@ -285,17 +279,16 @@ void TaskSheet::executeMorphSheet( double t )
 
     curFrame.center = tframe.center = AlphaBlend(t, sframe.center, tframe.center);
 
-    Array1D_Vector3 newPnts = Sheet::decodeSheet( cpCoords, curFrame.center, curFrame.r, curFrame.s, curFrame.t );
-    Array1D_Vector3 newPntsT = Sheet::decodeSheet( cpCoordsT, tframe.center, tframe.r, tframe.s, tframe.t );
-
-    Array1D_Vector3 blendedPnts;
+    // Decode
+    Array1D_Vector3 & newPnts = plan.points;
+    Array1D_Vector3 & newPntsT = plan.pointsT;
+    Sheet::decodeSheet( plan.cpCoords, curFrame.center, curFrame.r, curFrame.s, curFrame.t, newPnts );
+    Sheet::decodeSheet( plan.cpCoordsT, tframe.center, tframe.r, tframe.s, tframe.t, newPntsT );
 
     for(int i = 0; i < (int)newPnts.size(); i++)
-    {
-        blendedPnts.push_back( AlphaBlend(t, newPnts[i], newPntsT[i]) );
-    }
+        newPnts[i] = AlphaBlend(t, newPnts[i], newPntsT[i]);
 
-    sheet->setControlPoints( blendedPnts );
+    sheet->setControlPoints( newPnts );
 }
 
 void TaskSheet::encodeSheet( const Vector4d& coordinateA, const Vector4d& coordinateB )
@@ -357,20 +350,20 @@ void TaskSheet::executeCrossingSheet( double t )
 {
 	Node *n = node(), *tn = targetNode();
 
-	QVector<Link*> edges = active->getEdges( property["edges"].value< QVector<int> >() );
+	Structure::Link *slink = NULL;
+	int is = plannedEdge(0, 1, slink);
 
-	if (property.contains("path"))
+	if (plan.hasPath)
 	{
 		Vector3 p0 = n->position(Vec4d(0,0,0,0));
 		Vector3 delta(0,0,0);
 
-		if(!edges.isEmpty())
+		if(slink)
 		{
-			p0 = edges.front()->position(n->id);
+			p0 = slink->position(n->id);
 
 			// Blend Deltas
-			Structure::Link *slink = edges.front();
-			Structure::Link* tlink = target->getEdge(slink->property["correspond"].toInt());
+			Structure::Link* tlink = plan.edges[is].targetLink;
 			Vector3 d1 = slink->position(n->id) - slink->positionOther(n->id);
 			Vector3 d2 = tlink->position(tn->id) - tlink->positionOther(tn->id);
 			delta = AlphaBlend(t, d1, d2);
@@ -379,11 +372,11 @@ void TaskSheet::executeCrossingSheet( double t )
 		executeMorphSheet(t);
 		
 		// Cancel any absolute movement
-		if(!edges.isEmpty())
-			n->moveBy(p0 - edges.front()->position(n->id));
+		if(slink)
+			n->moveBy(p0 - slink->position(n->id));
 
 		// Move it to the correct position
-		Array1D_Vector3 path = property["path"].value< Array1D_Vector3 >();
+		const Array1D_Vector3 & path = plan.path;
 		int idx = t * (path.size() - 1);
 
 		Vector3 oldPosOnMe = p0;
@@ -0,0 +1,339 @@
+#include <omp.h>
+#include <cfloat>
+#include <algorithm>
+#include <QFileInfo>
+
+#include "SurfaceMeshHelper.h"
+#include "ThumbnailRenderer.h"
+#include "Tracing.h"
+
+using namespace SurfaceMesh;
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846264338328
+#endif
+
+// Rows per tile, each tile is rasterized by one thread
+#define THUMB_TILE_ROWS 16
+
+namespace ThumbnailInternal{
+
+	struct Camera{
+		Eigen::Vector3d eye, s, u, f;
+		double focal;
+		int width, height;
+
+		// Same framing as the demo's ShapeRenderer::setupCamera
+		Camera( const Eigen::AlignedBox3d & bbox, const Eigen::Vector3d & cameraDelta, int w, int h ) : width(w), height(h)
+		{
+			Eigen::Vector3d up(0,0,1);
+			Eigen::Vector3d position(-2,-2,1.5);
+			if( cameraDelta.norm() != 0.0 ) position += cameraDelta.normalized();
+
+			f = (-position).normalized();
+			s = f.cross(up).normalized();
+			u = s.cross(f);
+
+			double distance = bbox.diagonal().size() * 1.4;
+			double n = cameraDelta.norm();
+			if(n > 0.5) distance *= n;
+
+			eye = bbox.center() - (distance * f);
+
+			// Default QGLViewer field of view is 45 degrees
+			focal = 1.0 / tan( (M_PI / 4.0) * 0.5 );
+		}
+
+		// Returns screen position in pixels and view depth
+		inline Eigen::Vector3d project( const Eigen::Vector3d & p ) const
+		{
+			Eigen::Vector3d d = p - eye;
+			double depth = f.dot(d);
+			double x = (s.dot(d) / depth) * focal;
+			double y = (u.dot(d) / depth) * focal;
+			return Eigen::Vector3d( (x + 1.0) * 0.5 * width, (1.0 - y) * 0.5 * height, depth );
+		}
+
+		inline Eigen::Vector3f toEye( const Eigen::Vector3d & n ) const
+		{
+			return Eigen::Vector3f( s.dot(n), u.dot(n), -f.dot(n) );
+		}
+	};
+
+	// Fixed function lighting of ShapeRenderer::initializeGL, evaluated per pixel
+	inline QRgb shade( const Eigen::Vector3f & normal, const QColor & color )
+	{
+		static const Eigen::Vector3f L = Eigen::Vector3f(1,1,1).normalized();
+		static const Eigen::Vector3f H = (L + Eigen::Vector3f(0,0,1)).normalized();
+
+		Eigen::Vector3f n = normal.normalized();
+		float diffuse = std::max(0.0f, n.dot(L));
+		float specular = (diffuse > 0) ? pow(std::max(0.0f, n.dot(H)), 56.0f) : 0.0f;
+
+		// Global ambient (0.2) + light ambient (0.2), diffuse 0.9, specular 0.95 * 0.8
+		float k = 0.4f + 0.9f * diffuse;
+		float spec = 0.95f * 0.8f * specular;
+
+		int r = qMin(255, int((color.redF() * k + spec) * 255));
+		int g = qMin(255, int((color.greenF() * k + spec) * 255));
+		int b = qMin(255, int((color.blueF() * k + spec) * 255));
+		return qRgba(r, g, b, 255);
+	}
+
+	inline double edge( const Eigen::Vector3d & a, const Eigen::Vector3d & b, double x, double y )
+	{
+		return (b[0] - a[0]) * (y - a[1]) - (b[1] - a[1]) * (x - a[0]);
+	}
+}
+
+using namespace ThumbnailInternal;
+
+ThumbnailRenderer::Geometry ThumbnailRenderer::fromMesh( SurfaceMeshModel * mesh )
+{
+	Geometry g;
+	if( !mesh || mesh->n_vertices() < 1 ) return g;
+
+	mesh->update_face_normals();
+	mesh->update_vertex_normals();
+
+	Vector3VertexProperty m_points = mesh->vertex_coordinates();
+	Vector3VertexProperty m_normals = mesh->vertex_normals();
+
+	g.points.reserve( mesh->n_vertices() );
+	g.normals.reserve( mesh->n_vertices() );
+	g.triangles.reserve( mesh->n_faces() * 3 );
+
+	foreach(Vertex v, mesh->vertices()){
+		g.points.push_back( m_points[v] );
+		g.normals.push_back( m_normals[v] );
+	}
+
+	// Fan triangulation of polygons
+	foreach(Face f, mesh->faces()){
+		std::vector<int> poly;
+		foreach(Vertex v, mesh->vertices(f)) poly.push_back( v.idx() );
+
+		for(int i = 1; i + 1 < (int)poly.size(); i++){
+			g.triangles.push_back( poly[0] );
+			g.triangles.push_back( poly[i] );
+			g.triangles.push_back( poly[i+1] );
+		}
+	}
+
+	return g;
+}
+
+ThumbnailRenderer::Geometry ThumbnailRenderer::fromFile( QString filename )
+{
+	SurfaceMeshModel mesh;
+	if( QFileInfo(filename).exists() ) mesh.read( qPrintable(filename) );
+	return fromMesh( &mesh );
+}
+
+QImage ThumbnailRenderer::render( const Geometry & geometry, const Settings & settings )
+{
+	TRACE_ZONE("ThumbnailRenderer::render");
+
+	int numPoints = (int)geometry.points.size();
+	if( numPoints < 1 ){
+		QImage empty(settings.resolution, settings.resolution, QImage::Format_ARGB32);
+		empty.fill( qRgba(0,0,0,0) );
+		return empty;
+	}
+
+	int ss = qMax(1, settings.supersample);
+	int w = settings.resolution * ss, h = w;
+
+	QImage img(w, h, QImage::Format_ARGB32_Premultiplied);
+	img.fill( qRgba(0,0,0,0) );
+
+	bool isPointSet = geometry.triangles.empty();
+	bool hasNormals = (int)geometry.normals.size() == numPoints;
+
+	Eigen::AlignedBox3d bbox;
+	for(int i = 0; i < numPoints; i++) bbox.extend( geometry.points[i] );
+
+	Camera camera( bbox, settings.cameraDelta, w, h );
+	double nearDepth = 1e-3 * (camera.eye - bbox.center()).norm();
+
+	// Transform everything once
+	std::vector<Eigen::Vector3d> screen( numPoints );
+	std::vector<Eigen::Vector3f> eyeNormals( numPoints, Eigen::Vector3f(0,0,1) );
+
+	#pragma omp parallel for
+	for(int i = 0; i < numPoints; i++){
+		screen[i] = camera.project( geometry.points[i] );
+		if( hasNormals ) eyeNormals[i] = camera.toEye( geometry.normals[i] );
+	}
+
+	// Bin primitives into row tiles
+	int numTiles = (h + THUMB_TILE_ROWS - 1) / THUMB_TILE_ROWS;
+	std::vector< std::vector<int> > bins( numTiles );
+
+	int numPrims = isPointSet ? numPoints : (int)geometry.triangles.size() / 3;
+	double splat = settings.splatRadius * ss;
+
+	std::vector<Eigen::Vector4d> primBox( numPrims ); // minx, miny, maxx, maxy
+
+	for(int p = 0; p < numPrims; p++)
+	{
+		double minx, miny, maxx, maxy;
+
+		if( isPointSet )
+		{
+			const Eigen::Vector3d & c = screen[p];
+			if( c[2] < nearDepth ) continue;
+			minx = c[0] - splat; maxx = c[0] + splat;
+			miny = c[1] - splat; maxy = c[1] + splat;
+		}
+		else
+		{
+			const Eigen::Vector3d & a = screen[ geometry.triangles[p*3+0] ];
+			const Eigen::Vector3d & b = screen[ geometry.triangles[p*3+1] ];
+			const Eigen::Vector3d & c = screen[ geometry.triangles[p*3+2] ];
+			if( a[2] < nearDepth || b[2] < nearDepth || c[2] < nearDepth ) continue;
+			minx = std::min(a[0], std::min(b[0], c[0])); maxx = std::max(a[0], std::max(b[0], c[0]));
+			miny = std::min(a[1], std::min(b[1], c[1])); maxy = std::max(a[1], std::max(b[1], c[1]));
+		}
+
+		if( maxx < 0 || maxy < 0 || minx >= w || miny >= h ) continue;
+
+		primBox[p] = Eigen::Vector4d( std::max(0.0, minx), std::max(0.0, miny), std::min(w - 1.0, maxx), std::min(h - 1.0, maxy) );
+
+		int t0 = int(primBox[p][1]) / THUMB_TILE_ROWS, t1 = int(primBox[p][3]) / THUMB_TILE_ROWS;
+		for(int t = t0; t <= t1; t++) bins[t].push_back(p);
+	}
+
+	// scanLine() may detach the image, so rows are addressed from the shared bits
+	uchar * bits = img.bits();
+	int bpl = img.bytesPerLine();
+
+	#pragma omp parallel for schedule(dynamic)
+	for(int t = 0; t < numTiles; t++)
+	{
+		int y0 = t * THUMB_TILE_ROWS, y1 = std::min(h, y0 + THUMB_TILE_ROWS);
+		int rows = y1 - y0;
+
+		std::vector<double> zbuffer( rows * w, DBL_MAX );
+		std::vector<Eigen::Vector3f> nbuffer( rows * w );
+
+		for(int bi = 0; bi < (int)bins[t].size(); bi++)
+		{
+			int p = bins[t][bi];
+			const Eigen::Vector4d & box = primBox[p];
+			int bx0 = int(box[0]), bx1 = int(box[2]);
+			int by0 = std::max(y0, int(box[1])), by1 = std::min(y1 - 1, int(box[3]));
+
+			if( isPointSet )
+			{
+				const Eigen::Vector3d & c = screen[p];
+				double r2 = splat * splat;
+
+				for(int y = by0; y <= by1; y++){
+					for(int x = bx0; x <= bx1; x++){
+						double dx = (x + 0.5) - c[0], dy = (y + 0.5) - c[1];
+						if( dx*dx + dy*dy > r2 ) continue;
+
+						int idx = (y - y0) * w + x;
+						if( c[2] >= zbuffer[idx] ) continue;
+						zbuffer[idx] = c[2];
+						nbuffer[idx] = eyeNormals[p];
+					}
+				}
+				continue;
+			}
+
+			int i0 = geometry.triangles[p*3+0], i1 = geometry.triangles[p*3+1], i2 = geometry.triangles[p*3+2];
+			const Eigen::Vector3d & a = screen[i0], & b = screen[i1], & c = screen[i2];
+
+			double area = edge(a, b, c[0], c[1]);
+			if( fabs(area) < 1e-12 ) continue;
+			double invArea = 1.0 / area;
+
+			// Perspective correct interpolation uses 1/z
+			double iz0 = 1.0 / a[2], iz1 = 1.0 / b[2], iz2 = 1.0 / c[2];
+
+			Eigen::Vector3f faceNormal;
+			if( settings.isFlatShading || !hasNormals ){
+				Eigen::Vector3d fn = (geometry.points[i1] - geometry.points[i0]).cross(geometry.points[i2] - geometry.points[i0]);
+				faceNormal = camera.toEye( fn.normalized() );
+			}
+
+			for(int y = by0; y <= by1; y++){
+				double py = y + 0.5;
+				for(int x = bx0; x <= bx1; x++){
+					double px = x + 0.5;
+
+					double w0 = edge(b, c, px, py) * invArea;
+					double w1 = edge(c, a, px, py) * invArea;
+					double w2 = 1.0 - w0 - w1;
+					if( w0 < 0 || w1 < 0 || w2 < 0 ) continue;
+
+					double iz = w0 * iz0 + w1 * iz1 + w2 * iz2;
+					double depth = 1.0 / iz;
+
+					int idx = (y - y0) * w + x;
+					if( depth >= zbuffer[idx] ) continue;
+					zbuffer[idx] = depth;
+
+					if( settings.isFlatShading || !hasNormals )
+						nbuffer[idx] = faceNormal;
+					else
+						nbuffer[idx] = (eyeNormals[i0] * float(w0 * iz0) + eyeNormals[i1] * float(w1 * iz1) + eyeNormals[i2] * float(w2 * iz2)) * float(depth);
+				}
+			}
+		}
+
+		// Shade visible pixels only
+		for(int y = y0; y < y1; y++){
+			QRgb * line = (QRgb*)(bits + y * bpl);
+			for(int x = 0; x < w; x++){
+				int idx = (y - y0) * w + x;
+				if( zbuffer[idx] == DBL_MAX ) continue;
+				line[x] = shade( nbuffer[idx], settings.color );
+			}
+		}
+	}
+
+	if( ss > 1 ) img = img.scaled(settings.resolution, settings.resolution, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+
+	return img.convertToFormat( QImage::Format_ARGB32 );
+}
+
+QImage ThumbnailRenderer::render( SurfaceMeshModel * mesh, const Settings & settings )
+{
+	return render( fromMesh(mesh), settings );
+}
+
+QImage ThumbnailRenderer::render( const std::vector<Eigen::Vector3f> & points, const std::vector<Eigen::Vector3f> & normals, const Settings & settings )
+{
+	Geometry g;
+	g.points.reserve( points.size() );
+	for(int i = 0; i < (int)points.size(); i++) g.points.push_back( points[i].cast<double>() );
+	if( normals.size() == points.size() ){
+		g.normals.reserve( normals.size() );
+		for(int i = 0; i < (int)normals.size(); i++) g.normals.push_back( normals[i].cast<double>() );
+	}
+	return render( g, settings );
+}
+
+QImage ThumbnailRenderer::renderFile( QString filename, const Settings & settings )
+{
+	return render( fromFile(filename), settings );
+}
+
+int ThumbnailRenderer::renderFiles( const QStringList & inputFiles, const QStringList & outputFiles, const Settings & settings )
+{
+	int count = 0;
+	int N = qMin(inputFiles.size(), outputFiles.size());
+
+	// One image per thread, tiles inside each image then run serially
+	#pragma omp parallel for schedule(dynamic) reduction(+:count)
+	for(int i = 0; i < N; i++)
+	{
+		QImage img = renderFile( inputFiles[i], settings );
+		if( img.save( outputFiles[i] ) ) count++;
+	}
+
+	return count;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vector>
+#include <QImage>
+#include <QColor>
+#include <QStringList>
+
+#include "SurfaceMeshModel.h"
+
+// Headless CPU version of the demo's ShapeRenderer: no OpenGL context needed.
+// Triangles are rasterized with a z-buffer over row tiles in parallel, point sets are splatted as discs.
+struct ThumbnailRenderer{
+
+	struct Settings{
+		int resolution;
+		int supersample;			// 2 => 2x2 samples per pixel, similar to the multisampled GL buffer
+		QColor color;
+		bool isFlatShading;
+		Eigen::Vector3d cameraDelta;
+		double splatRadius;			// in output pixels, for point sets
+
+		Settings() : resolution(512), supersample(2), color(203, 127, 92), isFlatShading(false), 
+			cameraDelta(0,0,0), splatRadius(1.5) {}
+	};
+
+	// Geometry in a renderer friendly layout
+	struct Geometry{
+		std::vector<Eigen::Vector3d> points;
+		std::vector<Eigen::Vector3d> normals;	// per vertex, can be empty for point sets
+		std::vector<int> triangles;				// three indices per face, empty for point sets
+	};
+
+	static Geometry fromMesh( SurfaceMesh::SurfaceMeshModel * mesh );
+	static Geometry fromFile( QString filename );
+
+	static QImage render( const Geometry & geometry, const Settings & settings = Settings() );
+	static QImage render( SurfaceMesh::SurfaceMeshModel * mesh, const Settings & settings = Settings() );
+	static QImage render( const std::vector<Eigen::Vector3f> & points, const std::vector<Eigen::Vector3f> & normals, 
+		const Settings & settings = Settings() );
+	static QImage renderFile( QString filename, const Settings & settings = Settings() );
+
+	// Render many files, one image per thread. Returns number of thumbnails written.
+	static int renderFiles( const QStringList & inputFiles, const QStringList & outputFiles, const Settings & settings = Settings() );
+};
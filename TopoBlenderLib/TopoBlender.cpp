@@ -15,6 +15,7 @@ using namespace DynamicGraphs;
 
 #include "Scheduler.h"
 #include "SchedulerWidget.h"
+#include "Tracing.h"
 
 // Temporary solution for output
 #include "surface_mesh/IO.h"
@@ -33,16 +34,28 @@ TopoBlender::TopoBlender(GraphCorresponder * useCorresponder, Scheduler * useSch
 	this->sg = useCorresponder->sg;
 	this->tg = useCorresponder->tg;
 
+	// Lazily loaded inputs get their part meshes now
+	Structure::Graph::loadMeshes( QVector<Structure::Graph*>() << sg << tg );
+
 	/// STEP 2) Generate super graphs
-	generateSuperGraphs();
+	{
+		TRACE_ZONE("TopoBlender::generateSuperGraphs");
+		generateSuperGraphs();
+	}
 
 	/// STEP 3) Generate tasks 
 	scheduler->setInputGraphs(super_sg, super_tg);
 	scheduler->superNodeCorr = this->superNodeCorr;
-	scheduler->generateTasks();
+	{
+		TRACE_ZONE("Scheduler::generateTasks");
+		scheduler->generateTasks();
+	}
 
 	/// STEP 4) Order and schedule the tasks
-	scheduler->schedule();
+	{
+		TRACE_ZONE("Scheduler::schedule");
+		scheduler->schedule();
+	}
 }
 
 TopoBlender::~TopoBlender()
@@ -140,6 +153,8 @@ QVector<QString> TopoBlender::cloneGraphNode( Structure::Graph *g, QString nodeI
 
 void TopoBlender::correspondSuperNodes()
 {
+	QStringList sourceNulls, targetNulls;
+
 	// Add virtual corresponding nodes for missing nodes
 
 	// To shrink:
@@ -151,6 +166,7 @@ void TopoBlender::correspondSuperNodes()
 
 		assert(!super_tg->getNode(ctnode->id));
 		super_tg->addNode(ctnode);
+		targetNulls << ctnode->id;
 
 		superNodeCorr[snodeID] = ctnode->id;
 	}
@@ -164,6 +180,7 @@ void TopoBlender::correspondSuperNodes()
 
 		assert(!super_sg->getNode(csnode->id));
 		super_sg->addNode(csnode);
+		sourceNulls << csnode->id;
 
 		superNodeCorr[csnode->id] = tnodeID;
 	}
@@ -217,13 +234,18 @@ void TopoBlender::correspondSuperNodes()
 		}
 	}
 
+	// Indexed tables used from here on
+	corr.build( super_sg, super_tg, superNodeCorr );
+	foreach(QString nodeID, sourceNulls) corr.setNull(0, nodeID);
+	foreach(QString nodeID, targetNulls) corr.setNull(1, nodeID);
+
 	// Store correspondences in the graphs
 	foreach(QString snode, superNodeCorr.keys())
 	{
 		QString tnode = superNodeCorr[snode];
 
-		Structure::Node * sn = super_sg->getNode(snode);
-		Structure::Node * tn = super_tg->getNode(tnode);
+		Structure::Node * sn = corr.node(0, snode);
+		Structure::Node * tn = corr.node(1, tnode);
 
 		if(!sn || !tn){
 			qDebug() << "ERROR: many to many cases are not handled";
@@ -237,22 +259,22 @@ void TopoBlender::correspondSuperNodes()
 
 void TopoBlender::correspondTwoEdges( Structure::Link *slink, Structure::Link *tlink, bool isFlip, Structure::Graph* source )
 {
-	if(slink->property.contains("correspond") || tlink->property.contains("correspond")) return;
+	if(corr.isCorresponded(slink) || corr.isCorresponded(tlink)) return;
 
 	// Force flip order of nodes of link on super_sg
 	if (isFlip)
 	{
-		QString n1 = slink->n1->id;
-		QString n2 = slink->n2->id;
+		int s = corr.side(source);
+		Structure::Node * n1 = slink->n1;
+		Structure::Node * n2 = slink->n2;
 		Array1D_Vector4d c1 = slink->coord.front();
 		Array1D_Vector4d c2 = slink->coord.back();
 
-		source->removeEdge(n1,n2);
-		slink = source->addEdge(source->getNode(n2), source->getNode(n1), c2, c1, source->linkName(n2,n1) );
+		corr.removeEdge(s, slink);
+		slink = corr.addEdge(s, n2, n1, c2, c1);
 	}
 
-	slink->property["correspond"] = tlink->property["uid"].toInt();
-	tlink->property["correspond"] = slink->property["uid"].toInt();
+	corr.setCorrespond(slink, tlink);
 }
 
 // This function could be written with [graphA] and [graphB] but we should 
@@ -269,6 +291,8 @@ void TopoBlender::correspondSuperEdges()
 
 	bool dbg = false;
 
+	corr.buildEdges();
+
 	if(dbg) debugSuperGraphs("00");
 
 	/// Correspond trivial edges, i.e. both nodes exist on both graphs
@@ -336,8 +360,7 @@ void TopoBlender::correspondSuperEdges()
 	// Visualization: assign global unique ids
 	int viz_uid = 0;
 	foreach(Structure::Link * slink, super_sg->edges){
-		if(!slink->property.contains("correspond")) continue;
-		Link* tlink = super_tg->getEdge(slink->property["correspond"].toInt());
+		Link* tlink = corr.edgeCorr.value(slink);
 		if(!tlink) continue;
 		slink->property["viz_uid"] = tlink->property["viz_uid"] = viz_uid++;
 	}
@@ -345,13 +368,15 @@ void TopoBlender::correspondSuperEdges()
 
 void TopoBlender::correspondTrivialEdges( Structure::Graph * source, Structure::Graph * target )
 {
+	int s = corr.side(source), t = corr.side(target);
+
 	foreach(Structure::Link * slink, source->edges)
 	{
 		Structure::Node *sn1 = slink->n1, *sn2 = slink->n2;
-		Structure::Node *tn1 = target->getNode( sn1->property["correspond"].toString() ),
-			*tn2 = target->getNode( sn2->property["correspond"].toString() );
+		Structure::Node *tn1 = corr.correspondNode(s, sn1), *tn2 = corr.correspondNode(s, sn2);
+		if(!tn1 || !tn2) continue;
 
-		Structure::Link * tlink = target->getEdge(tn1->id, tn2->id);
+		Structure::Link * tlink = corr.getEdge(t, tn1, tn2);
 
 		if(!tlink) continue;
 
@@ -362,16 +387,18 @@ void TopoBlender::correspondTrivialEdges( Structure::Graph * source, Structure::
 
 void TopoBlender::correspondSimilarType( Structure::Graph * source, Structure::Graph * target )
 {
+	int s = corr.side(source), t = corr.side(target);
+
 	foreach(Structure::Link * slink, source->edges)
 	{
-		if (slink->property.contains("correspond")) continue;
+		if (corr.isCorresponded(slink)) continue;
 
 		Structure::Node *sn1 = slink->n1, *sn2 = slink->n2;
-		Structure::Node *tn1 = target->getNode(sn1->property["correspond"].toString()),
-			*tn2 = target->getNode(sn2->property["correspond"].toString());
+		Structure::Node *tn1 = corr.correspondNode(s, sn1), *tn2 = corr.correspondNode(s, sn2);
+		if(!tn1 || !tn2) continue;
 
 		// We are only looking for missing edges
-		if(!(tn1->id.contains("_null") && tn2->id.contains("_null"))) continue;
+		if(!(corr.isNullNode(t, tn1) && corr.isNullNode(t, tn2))) continue;
 
 		Structure::Link * tlink = addMissingLink(target, slink);
 		correspondTwoEdges(slink, tlink, false, source);
@@ -380,13 +407,15 @@ void TopoBlender::correspondSimilarType( Structure::Graph * source, Structure::G
 
 void TopoBlender::connectNullNodes( Structure::Graph * source, Structure::Graph * target )
 {
+	int s = corr.side(source), t = corr.side(target);
+
 	// Sorted by valence descending
 	QVector<Structure::Node*> nullNodes;
 	typedef QPair<int,Node*> ValenceNode;
 	QMap<Node*,int> nodeV;
 	foreach(Structure::Node * n, source->nodes){
-		if (!n->id.contains("_null")) continue;
-		nodeV[n] = source->valence(n);
+		if (!corr.isNullNode(s, n)) continue;
+		nodeV[n] = corr.valence(s, n);
 	}
 
 	// high to low
@@ -395,16 +424,15 @@ void TopoBlender::connectNullNodes( Structure::Graph * source, Structure::Graph
 
 	foreach(Structure::Node * snode, nullNodes)
 	{
-		Structure::Node * tnode = target->getNode( snode->property["correspond"].toString() );
+		Structure::Node * tnode = corr.correspondNode(s, snode);
+		if(!tnode) continue;
 
 		// Get edges of target node
-		QVector<Structure::Link*> tedges = edgesNotContain( target->getEdges(tnode->id), "correspond" );
+		QVector<Structure::Link*> tedges = corr.freeEdges(t, tnode);
 		if(tedges.isEmpty()) continue;
 
 		// Make sure our connected sub-graph is in fact disconnected
-		bool isConnectedViaOthers = false;
-		foreach(QString nid, source->nodesCanVisit(snode))	if(!nid.contains("_null")) { isConnectedViaOthers = true; break; }
-		if( isConnectedViaOthers ) continue;
+		if( corr.reachesRealNode(s, snode) ) continue;
 
 		if (tedges.size() == 1)
 		{
@@ -422,32 +450,39 @@ void TopoBlender::connectNullNodes( Structure::Graph * source, Structure::Graph
 		}
 		else
 		{
-			// Collect names, in source, of target's neighboring nodes
-			QStringList nodesKeep;
+			// Collect, in source, the target's neighboring nodes
+			QSet<Node*> nodesKeep;
 			foreach(Link * tlink, tedges){
 				Node* tOther = tlink->otherNode(tnode->id);
-				Node* sOther = source->getNode(tOther->property["correspond"].toString());
-				nodesKeep << sOther->id;
+				Node* sOther = corr.correspondNode(t, tOther);
+				if(sOther) nodesKeep.insert(sOther);
 			}
+			if(nodesKeep.isEmpty()) continue;
 
-			// Keep only subgraph with names from above
-			Structure::Graph copy(*source);
-			foreach(Node*n, source->nodes) if(!nodesKeep.contains(n->id)) copy.removeNode(n->id);
-
-			// Find node with most valence, otherwise pick first
+			// Find node with most valence within the kept subgraph, otherwise pick first
 			int bestValence = 0;
-			QString bestID = copy.nodes.front()->id;
-			foreach(Node * n, copy.nodes){
-				int valence = copy.valence(n);
+			Node * bestNode = NULL;
+			foreach(Node * n, source->nodes){
+				if(!nodesKeep.contains(n)) continue;
+				if(!bestNode) bestNode = n;
+
+				QSet<Node*> neighbours;
+				foreach(Link * l, corr.edgesOf(s, n)){
+					Node * other = l->otherNode(n->id);
+					if(other != n && nodesKeep.contains(other)) neighbours.insert(other);
+				}
+
+				int valence = neighbours.size();
 				if (valence > bestValence){
-					bestID = n->id;
+					bestNode = n;
 					bestValence = valence;
 				}
 			}
+			QString bestID = bestNode->id;
 
 			// Find corresponding link on target
-			Node* bestTNode = target->getNode( source->getNode(bestID)->property["correspond"].toString() );
-			Link* bestTLink = target->getEdge( tnode->id, bestTNode->id ); 
+			Node* bestTNode = corr.correspondNode(s, bestNode);
+			Link* bestTLink = corr.getEdge(t, tnode, bestTNode);
 
 			// Add the link to source
 			Link* slink = addMissingLink(source, bestTLink);
@@ -456,13 +491,12 @@ void TopoBlender::connectNullNodes( Structure::Graph * source, Structure::Graph
 			/// Respect the groups:
 			foreach(QVector<QString> group, target->groupsOf(bestTNode->id)){
 				foreach(QString element, group){
-					Node * tn = target->getNode(element);
-					//Node * sn = source->getNode(tn->property["correspond"].toString());
+					Node * tn = corr.node(t, element);
 
 					if(element == bestTNode->id) continue;
 
 					// If there is an edge on the target between me and the element of the group
-					Link * tlink = target->getEdge(tnode->id, tn->id);
+					Link * tlink = corr.getEdge(t, tnode, tn);
 					if( tlink )
 					{
 						Link* slink = addMissingLink(source, tlink);
@@ -473,10 +507,10 @@ void TopoBlender::connectNullNodes( Structure::Graph * source, Structure::Graph
 
 			foreach(QVector<QString> group, source->groupsOf(bestID)){
 				foreach(QString element, group){
-					Node * sn = source->getNode(element);
-					Node * tn = target->getNode(sn->property["correspond"].toString());
+					Node * sn = corr.node(s, element);
+					Node * tn = corr.correspondNode(s, sn);
 					if(element == bestID) continue;
-					Link * tlink = target->getEdge(tnode->id, tn->id);
+					Link * tlink = corr.getEdge(t, tnode, tn);
 					if( tlink )
 					{
 						Link* slink = addMissingLink(source, tlink);
@@ -490,16 +524,19 @@ void TopoBlender::connectNullNodes( Structure::Graph * source, Structure::Graph
 
 void TopoBlender::correspondChangedEnds( Structure::Graph * source, Structure::Graph * target )
 {
+	int s = corr.side(source), t = corr.side(target);
+
 	bool isRunning = true;
 	do{
 		isRunning = false;
 
 		foreach(Structure::Node * snode, source->nodes)
 		{
-			Structure::Node * tnode = target->getNode( snode->property["correspond"].toString() );
+			Structure::Node * tnode = corr.correspondNode(s, snode);
+			if(!tnode) continue;
 
-			QVector<Structure::Link*> sedges = edgesNotContain( source->getEdges(snode->id), "correspond" );
-			QVector<Structure::Link*> tedges = edgesNotContain( target->getEdges(tnode->id), "correspond" );
+			QVector<Structure::Link*> sedges = corr.freeEdges(s, snode);
+			QVector<Structure::Link*> tedges = corr.freeEdges(t, tnode);
 
 			if(!sedges.size() || !tedges.size()) continue;
 
@@ -510,7 +547,7 @@ void TopoBlender::correspondChangedEnds( Structure::Graph * source, Structure::G
 				if( false )
 				{
 					bool isPartOfGroup = !source->groupsOf(snode->id).front().isEmpty();
-					if( snode->id.contains("_null") && isPartOfGroup ) continue;
+					if( corr.isNullNode(s, snode) && isPartOfGroup ) continue;
 				}
 
 				for( int i = 0; i < (int)sedges.size(); i++)
@@ -535,9 +572,9 @@ void TopoBlender::correspondChangedEnds( Structure::Graph * source, Structure::G
 				// A single edge from the target graph is ground truth
 				if(target == super_tg)
 				{
-					Structure::Node * n1 = source->getNode( tlink->getNode(tnode->id)->property["correspond"].toString() );
-					Structure::Node * n2 = source->getNode( tlink->otherNode(tnode->id)->property["correspond"].toString() );
-					Structure::Link * newEdge = source->addEdge(n1, n2, tlink->getCoord(tnode->id), tlink->getCoordOther(tnode->id), source->linkName(n1,n2));
+					Structure::Node * n1 = corr.correspondNode(t, tlink->getNode(tnode->id));
+					Structure::Node * n2 = corr.correspondNode(t, tlink->otherNode(tnode->id));
+					Structure::Link * newEdge = corr.addEdge(s, n1, n2, tlink->getCoord(tnode->id), tlink->getCoordOther(tnode->id));
 					sedges.push_front( newEdge );
 				}
 
@@ -554,13 +591,16 @@ void TopoBlender::correspondChangedEnds( Structure::Graph * source, Structure::G
 
 void TopoBlender::correspondRemainingOfNull( Structure::Graph * source, Structure::Graph * target )
 {
+	int s = corr.side(source), t = corr.side(target);
+
 	foreach(Structure::Node * snode, source->nodes)
 	{
-		if (!snode->id.contains("_null")) continue;
-		Structure::Node * tnode = target->getNode( snode->property["correspond"].toString() );
+		if (!corr.isNullNode(s, snode)) continue;
+		Structure::Node * tnode = corr.correspondNode(s, snode);
+		if(!tnode) continue;
 
 		// Get un-corresponded of target
-		QVector<Structure::Link*> tedges = edgesNotContain( target->getEdges(tnode->id), "correspond" );
+		QVector<Structure::Link*> tedges = corr.freeEdges(t, tnode);
 		if(tedges.isEmpty()) continue;
 
 		foreach(Link * tlink, tedges)
@@ -574,18 +614,20 @@ void TopoBlender::correspondRemainingOfNull( Structure::Graph * source, Structur
 
 void TopoBlender::connectFloatingRealNodes( Structure::Graph * source, Structure::Graph * target )
 {
+	int s = corr.side(source), t = corr.side(target);
+
 	foreach(Structure::Node * snode, source->nodes)
 	{
-		if (snode->id.contains("_null")) continue;
+		if (corr.isNullNode(s, snode)) continue;
 
-		QVector<Link*> alledges = source->getEdges(snode->id);
-		QVector<Link*> sedges = edgesNotContain(alledges, "correspond");
+		QVector<Link*> sedges = corr.freeEdges(s, snode);
 
 		// No edges are corresponded yet
-		if (sedges.size() == alledges.size())
+		if (sedges.size() == corr.edgesOf(s, snode).size())
 		{
-			Structure::Node * tnode = target->getNode( snode->property["correspond"].toString() );
-			QVector<Structure::Link*> tedges = edgesNotContain( target->getEdges(tnode->id), "correspond" );
+			Structure::Node * tnode = corr.correspondNode(s, snode);
+			if(!tnode) continue;
+			QVector<Structure::Link*> tedges = corr.freeEdges(t, tnode);
 
 			int N = qMin(sedges.size(), tedges.size());
 			for(int i = 0; i < N; i++)
@@ -605,12 +647,14 @@ void TopoBlender::connectFloatingRealNodes( Structure::Graph * source, Structure
 
 void TopoBlender::removeRedundantEdges( Structure::Graph * source )
 {
+	int s = corr.side(source);
+
 	foreach(Structure::Node * snode, source->nodes)
 	{
-		if (snode->id.contains("_null")) continue;
+		if (corr.isNullNode(s, snode)) continue;
 
-		foreach(Link* link, edgesNotContain( source->getEdges(snode->id), "correspond" ))
-			source->removeEdge(link->n1, link->n2);
+		foreach(Link* link, corr.freeEdges(s, snode))
+			corr.removeEdge(s, link);
 	}
 }
 
@@ -640,8 +684,7 @@ void TopoBlender::generateSuperGraphs()
 	// Visualization - color similar items
 	foreach(Structure::Node * n, super_sg->nodes)
 	{
-		QString corrId = n->property["correspond"].toString();
-		Structure::Node * other = super_tg->getNode(corrId);
+		Structure::Node * other = corr.correspondNode(0, n);
 		if(other) n->vis_property["color"].setValue( other->vis_property["color"] );
 	}
 
@@ -668,17 +711,18 @@ void TopoBlender::postprocessSuperEdges()
 	// >> More real: put null at the centoid of relative joint to all real neighbours
 	//               and the delta is computed thus from there
 	foreach (Node* n, super_sg->nodes){
-		if (n->id.contains("_null")){
-			foreach(Link* sl, super_sg->getEdges( n->id )) {
+		if (corr.isNullNode(0, n)){
+			foreach(Link* sl, corr.edgesOf(0, n)) {
 				//Link* tl = super_tg->getEdge(sl->property["correspond"].toInt());
 				sl->property["delta"].setValue( Vector3d(0,0,0) );
 			}
 		}
 	}
 	foreach (Node* n, super_tg->nodes){
-		if (n->id.contains("_null")){
-			foreach(Link* tl, super_tg->getEdges(n->id)) {
-				Link* sl = super_sg->getEdge(tl->property["correspond"].toInt());
+		if (corr.isNullNode(1, n)){
+			foreach(Link* tl, corr.edgesOf(1, n)) {
+				Link* sl = corr.edgeCorr.value(tl);
+				if(!sl) continue;
 				tl->property["delta"].setValue( sl->delta() );
 			}
 		}
@@ -708,26 +752,26 @@ void TopoBlender::equalizeSuperNodeResolutions()
 {
 	foreach(QVector<QString> group, super_sg->groups){
 		int maxNum = -1;
-		foreach(QString nid, group) maxNum = qMax(maxNum, super_sg->getNode(nid)->numCtrlPnts());
-		foreach(QString nid, group) super_sg->getNode(nid)->refineControlPoints(maxNum, maxNum);
+		foreach(QString nid, group) maxNum = qMax(maxNum, corr.node(0, nid)->numCtrlPnts());
+		foreach(QString nid, group) corr.node(0, nid)->refineControlPoints(maxNum, maxNum);
 	}
 
 	foreach(QVector<QString> group, super_tg->groups){
 		int maxNum = -1;
-		foreach(QString nid, group) maxNum = qMax(maxNum, super_tg->getNode(nid)->numCtrlPnts());
-		foreach(QString nid, group) super_tg->getNode(nid)->refineControlPoints(maxNum, maxNum);
+		foreach(QString nid, group) maxNum = qMax(maxNum, corr.node(1, nid)->numCtrlPnts());
+		foreach(QString nid, group) corr.node(1, nid)->refineControlPoints(maxNum, maxNum);
 	}
 
-	foreach(QString snodeID, superNodeCorr.keys())
+	for(int si = 0; si < corr.nodes[0].size(); si++)
 	{
-		QString tnodeID = superNodeCorr[snodeID];
+		int ti = corr.nodeCorr[0][si];
 
 		// skip non-corresponded nodes
-		if (snodeID.contains("_null") || tnodeID.contains("_null"))
+		if (ti < 0 || corr.isNull[0][si] || corr.isNull[1][ti])
 			continue;
 
-		Structure::Node* snode = super_sg->getNode(snodeID);
-		Structure::Node* tnode = super_tg->getNode(tnodeID);
+		Structure::Node* snode = corr.nodes[0][si];
+		Structure::Node* tnode = corr.nodes[1][ti];
 
 		if (snode->type() == tnode->type())
 		{
@@ -765,9 +809,9 @@ void TopoBlender::equalizeSuperNodeResolutions()
 
 	// Final phase
 	foreach(Node * snode, super_sg->nodes){
-		Node * tnode = super_tg->getNode(snode->property["correspond"].toString());
+		Node * tnode = corr.correspondNode(0, snode);
 
-		if (snode->type() == tnode->type())
+		if (tnode && snode->type() == tnode->type())
 		{
 			if (snode->numCtrlPnts() < tnode->numCtrlPnts())
 				snode->equalizeControlPoints(tnode);
@@ -781,18 +825,19 @@ void TopoBlender::equalizeSuperNodeTypes()
 {
 	// initial tags and collect the node pairs that need to be converted
 	QMap<QString, QString> diffPairs;
-	foreach(QString snodeID, superNodeCorr.keys())
+	for(int si = 0; si < corr.nodes[0].size(); si++)
 	{
-		QString tnodeID = superNodeCorr[snodeID];
+		int ti = corr.nodeCorr[0][si];
+		if (ti < 0) continue;
 
-		Structure::Node* snode = super_sg->getNode(snodeID);
-		Structure::Node* tnode = super_tg->getNode(tnodeID);
+		Structure::Node* snode = corr.nodes[0][si];
+		Structure::Node* tnode = corr.nodes[1][ti];
 
 		bool equalType = true;
 		if (snode->type() != tnode->type())
 		{
 			equalType = false;
-			diffPairs[snodeID] = tnodeID;
+			diffPairs[snode->id] = tnode->id;
 		}
 
 		snode->property["type_equalized"] = equalType;
@@ -807,7 +852,7 @@ void TopoBlender::equalizeSuperNodeTypes()
 		{
 			QString tnodeID = diffPairs[snodeID];
 
-			Structure::Node* snode = super_sg->getNode(snodeID);
+			Structure::Node* snode = corr.node(0, snodeID);
 
 			// try to convert
 			bool converted;
@@ -837,8 +882,10 @@ void TopoBlender::equalizeSuperNodeTypes()
 // we can relink the new curves (converted sheet) in the same way as the curve
 bool TopoBlender::convertSheetToCurve( QString nodeID1, QString nodeID2, Structure::Graph* superG1, Structure::Graph* superG2 )
 {
-	Structure::Node* node1 = superG1->getNode(nodeID1);
-	Structure::Node* node2 = superG2->getNode(nodeID2);
+	int s1 = corr.side(superG1), s2 = corr.side(superG2);
+
+	Structure::Node* node1 = corr.node(s1, nodeID1);
+	Structure::Node* node2 = corr.node(s2, nodeID2);
 
 	Structure::Sheet *oldSheet = (Structure::Sheet*)node1;
 	Structure::Curve *curve2 = (Structure::Curve*)node2;
@@ -856,9 +903,8 @@ bool TopoBlender::convertSheetToCurve( QString nodeID1, QString nodeID2, Structu
 
 		// choose type-equalized neighbours
 		if (other2->property["type_equalized"].toBool()){
-			QString otherID1 = other2->property["correspond"].toString();
-
-			Structure::Node* other1 = superG1->getNode(otherID1);
+			Structure::Node* other1 = corr.correspondNode(s2, other2);
+			if(!other1) continue;
 			Vector4d otherCoord = link2->getCoordOther(nodeID2).front();
 			Vector3d linkOtherPos1 = other1->position(otherCoord);
 
@@ -899,7 +945,8 @@ bool TopoBlender::convertSheetToCurve( QString nodeID1, QString nodeID2, Structu
 		superG1->addEdge(n1, n2, coordOnNew, l->getCoord(n2->id), superG1->linkName(n1,n2));
 	}
 
-	// Remove old node
+	// Remove old node, the new one takes its slot
+	corr.replaceNode( s1, oldSheet, newCurve );
 	superG1->removeNode( oldSheet->id );
 
 	// Replace ID for new node
@@ -912,46 +959,202 @@ bool TopoBlender::convertSheetToCurve( QString nodeID1, QString nodeID2, Structu
 
 Structure::Link * TopoBlender::addMissingLink( Structure::Graph *g, Structure::Link * link )
 {
+	int s = corr.side(g);
+
 	Structure::Node * bn1 = link->n1;
 	Structure::Node * bn2 = link->n2;
-	Structure::Node * an1 = g->getNode(bn1->property["correspond"].toString());
-	Structure::Node * an2 = g->getNode(bn2->property["correspond"].toString());
+	Structure::Node * an1 = corr.correspondNode(1 - s, bn1);
+	Structure::Node * an2 = corr.correspondNode(1 - s, bn2);
 	LinkCoords c1 = link->getCoord(bn1->id);
 	LinkCoords c2 = link->getCoordOther(bn1->id);
 
-	Structure::Link * existEdge = g->getEdge(an1->id,an2->id);
+	Structure::Link * existEdge = corr.getEdge(s, an1, an2);
 
 	if(!existEdge)
-		return g->addEdge(an1, an2, c1, c2, g->linkName(an1, an2));
+		return corr.addEdge(s, an1, an2, c1, c2);
 	else
 		return existEdge;
 }
 
-QVector<Structure::Link*> TopoBlender::edgesContain( QVector<Structure::Link*> edges, QString property_name )
+void SuperCorrespondence::build( Structure::Graph * source, Structure::Graph * target, const QMap<QString, QString> & corr )
 {
-	QVector<Structure::Link*> result;
-	foreach(Structure::Link * edge, edges) 
-		if(edge->property.contains(property_name)) 
-			result.push_back(edge);
-	return result;
+	graph[0] = source;
+	graph[1] = target;
+
+	for(int s = 0; s < 2; s++)
+	{
+		nodes[s] = graph[s]->nodes;
+		nodeCorr[s] = QVector<int>(nodes[s].size(), -1);
+		isNull[s] = QVector<bool>(nodes[s].size(), false);
+		nodeSlot[s].clear();
+		idSlot[s].clear();
+
+		for(int i = 0; i < nodes[s].size(); i++){
+			nodeSlot[s][nodes[s][i]] = i;
+			idSlot[s][nodes[s][i]->id] = i;
+		}
+	}
+
+	foreach(QString snodeID, corr.keys())
+	{
+		int si = slot(0, snodeID), ti = slot(1, corr[snodeID]);
+		if(si < 0 || ti < 0) continue;
+
+		nodeCorr[0][si] = ti;
+		nodeCorr[1][ti] = si;
+	}
+
+	edgeCorr.clear();
 }
 
-QVector<Structure::Link*> TopoBlender::edgesNotContain( QVector<Structure::Link*> edges, QString property_name )
+void SuperCorrespondence::buildEdges()
+{
+	edgeCorr.clear();
+
+	for(int s = 0; s < 2; s++)
+	{
+		nodeEdges[s] = QVector< QVector<Structure::Link*> >(nodes[s].size());
+
+		foreach(Structure::Link * l, graph[s]->edges)
+		{
+			int i1 = slot(s, l->n1), i2 = slot(s, l->n2);
+			if(i1 >= 0) nodeEdges[s][i1].push_back(l);
+			if(i2 >= 0 && i2 != i1) nodeEdges[s][i2].push_back(l);
+
+			// Links already tagged count as corresponded
+			if(l->property.contains("correspond"))
+				edgeCorr[l] = graph[1 - s]->getEdge(l->property["correspond"].toInt());
+		}
+	}
+}
+
+Structure::Node * SuperCorrespondence::node( int s, QString nodeID ) const
+{
+	int i = slot(s, nodeID);
+	return (i < 0) ? NULL : nodes[s][i];
+}
+
+Structure::Node * SuperCorrespondence::correspondNode( int s, Structure::Node * n ) const
+{
+	int i = slot(s, n);
+	if(i < 0 || nodeCorr[s][i] < 0) return NULL;
+	return nodes[1 - s][ nodeCorr[s][i] ];
+}
+
+bool SuperCorrespondence::isNullNode( int s, Structure::Node * n ) const
+{
+	int i = slot(s, n);
+	return (i >= 0) && isNull[s][i];
+}
+
+void SuperCorrespondence::setNull( int s, QString nodeID )
+{
+	int i = slot(s, nodeID);
+	if(i >= 0) isNull[s][i] = true;
+}
+
+void SuperCorrespondence::replaceNode( int s, Structure::Node * oldNode, Structure::Node * newNode )
+{
+	int i = slot(s, oldNode);
+	if(i < 0) return;
+
+	nodeSlot[s].remove(oldNode);
+	nodeSlot[s][newNode] = i;
+	nodes[s][i] = newNode;
+}
+
+QVector<Structure::Link*> SuperCorrespondence::freeEdges( int s, Structure::Node * n ) const
 {
 	QVector<Structure::Link*> result;
-	foreach(Structure::Link * edge, edges) 
-		if(!edge->property.contains(property_name)) 
-			result.push_back(edge);
+	foreach(Structure::Link * l, edgesOf(s, n))
+		if(!edgeCorr.contains(l)) result.push_back(l);
 	return result;
 }
 
+Structure::Link * SuperCorrespondence::getEdge( int s, Structure::Node * n1, Structure::Node * n2 ) const
+{
+	// First edge in graph order, as Graph::getEdge
+	foreach(Structure::Link * l, edgesOf(s, n1))
+		if((l->n1 == n1 && l->n2 == n2) || (l->n1 == n2 && l->n2 == n1)) return l;
+	return NULL;
+}
+
+Structure::Link * SuperCorrespondence::addEdge( int s, Structure::Node * n1, Structure::Node * n2, Array1D_Vector4d c1, Array1D_Vector4d c2 )
+{
+	Structure::Link * l = graph[s]->addEdge(n1, n2, c1, c2, graph[s]->linkName(n1, n2));
+
+	int i1 = slot(s, n1), i2 = slot(s, n2);
+	nodeEdges[s][i1].push_back(l);
+	if(i2 != i1) nodeEdges[s][i2].push_back(l);
+
+	return l;
+}
+
+void SuperCorrespondence::removeEdge( int s, Structure::Link * l )
+{
+	// The exact link, parallel edges between the same nodes are left alone
+	if(!l) return;
+
+	int i1 = slot(s, l->n1), i2 = slot(s, l->n2);
+	nodeEdges[s][i1].remove( nodeEdges[s][i1].indexOf(l) );
+	if(i2 != i1) nodeEdges[s][i2].remove( nodeEdges[s][i2].indexOf(l) );
+
+	Structure::Link * other = edgeCorr.take(l);
+	if(other) edgeCorr.remove(other);
+
+	graph[s]->removeEdge( l->property["uid"].toInt() );
+}
+
+void SuperCorrespondence::setCorrespond( Structure::Link * l1, Structure::Link * l2 )
+{
+	l1->property["correspond"] = l2->property["uid"].toInt();
+	l2->property["correspond"] = l1->property["uid"].toInt();
+
+	edgeCorr[l1] = l2;
+	edgeCorr[l2] = l1;
+}
+
+int SuperCorrespondence::valence( int s, Structure::Node * n ) const
+{
+	QSet<Structure::Node*> neighbours;
+	foreach(Structure::Link * l, edgesOf(s, n))
+		neighbours.insert( (l->n1 == n) ? l->n2 : l->n1 );
+	neighbours.remove(n);
+	return neighbours.size();
+}
+
+bool SuperCorrespondence::reachesRealNode( int s, Structure::Node * n ) const
+{
+	QVector<bool> visited(nodes[s].size(), false);
+	QStack<int> toVisit;
+
+	int start = slot(s, n);
+	visited[start] = true;
+	toVisit.push(start);
+
+	while(!toVisit.isEmpty())
+	{
+		int i = toVisit.pop();
+		if(!isNull[s][i]) return true;
+
+		foreach(Structure::Link * l, nodeEdges[s][i])
+		{
+			int j = slot(s, (l->n1 == nodes[s][i]) ? l->n2 : l->n1);
+			if(j < 0 || visited[j]) continue;
+			visited[j] = true;
+			toVisit.push(j);
+		}
+	}
+
+	return false;
+}
+
 void TopoBlender::debugSuperGraphs( QString info )
 {
 	// Visualization: assign global unique ids
 	int viz_uid = 0;
 	foreach(Structure::Link * slink, super_sg->edges){
-		if(!slink->property.contains("correspond")) continue;
-		Link* tlink = super_tg->getEdge(slink->property["correspond"].toInt());
+		Link* tlink = corr.edgeCorr.value(slink);
 		if(!tlink) continue;
 		slink->property["viz_uid"] = tlink->property["viz_uid"] = viz_uid++;
 	}
@@ -14,6 +14,48 @@ struct SetNodes{
 	QMap<QString,QVariant> property;
 };
 
+// Node and edge correspondence of the two super graphs by integer index, side 0 being the source super graph.
+// Node slots are fixed once built, edge tables mirror each graph's edge order and follow the edge changes made here
+struct SuperCorrespondence
+{
+	Structure::Graph * graph[2];
+
+	// Nodes
+	QVector<Structure::Node*> nodes[2];
+	QVector<int> nodeCorr[2];		// slot on the other side, -1 if none
+	QVector<bool> isNull[2];		// stands in for a part missing on its own side
+	QHash<Structure::Node*, int> nodeSlot[2];
+	QHash<QString, int> idSlot[2];
+
+	// Edges
+	QVector< QVector<Structure::Link*> > nodeEdges[2];
+	QHash<Structure::Link*, Structure::Link*> edgeCorr;
+
+	void build( Structure::Graph * source, Structure::Graph * target, const QMap<QString, QString> & corr );
+	void buildEdges();
+
+	int side( Structure::Graph * g ) const { return (g == graph[0]) ? 0 : 1; }
+	int slot( int s, Structure::Node * n ) const { return nodeSlot[s].value(n, -1); }
+	int slot( int s, QString nodeID ) const { return idSlot[s].value(nodeID, -1); }
+	Structure::Node * node( int s, QString nodeID ) const;
+	Structure::Node * correspondNode( int s, Structure::Node * n ) const;
+	bool isNullNode( int s, Structure::Node * n ) const;
+	void setNull( int s, QString nodeID );
+	void replaceNode( int s, Structure::Node * oldNode, Structure::Node * newNode );
+
+	// Edge queries and changes, the graph is changed too
+	bool isCorresponded( Structure::Link * l ) const { return edgeCorr.contains(l); }
+	const QVector<Structure::Link*> & edgesOf( int s, Structure::Node * n ) const { return nodeEdges[s][slot(s, n)]; }
+	QVector<Structure::Link*> freeEdges( int s, Structure::Node * n ) const;
+	Structure::Link * getEdge( int s, Structure::Node * n1, Structure::Node * n2 ) const;
+	Structure::Link * addEdge( int s, Structure::Node * n1, Structure::Node * n2, Array1D_Vector4d c1, Array1D_Vector4d c2 );
+	void removeEdge( int s, Structure::Link * l );
+	void setCorrespond( Structure::Link * l1, Structure::Link * l2 );
+
+	int valence( int s, Structure::Node * n ) const;
+	bool reachesRealNode( int s, Structure::Node * n ) const;
+};
+
 class TopoBlender : public QObject
 {
     Q_OBJECT
@@ -34,6 +76,7 @@ public:
 	Structure::Graph * super_tg;
 	QMap<QString, QString> superNodeCorr;
 	QMap<QString, QString> superEdgeCorr;
+	SuperCorrespondence corr;
 
 	/// Super graphs operations:
 	void generateSuperGraphs();
@@ -64,10 +107,6 @@ public:
 
 	// Query
 	bool isExtraNode( Structure::Node *node );
-
-	// Edge lists filtering
-	QVector<Structure::Link*> edgesContain(QVector<Structure::Link*> edges, QString property_name);
-	QVector<Structure::Link*> edgesNotContain(QVector<Structure::Link*> edges, QString property_name);
 	
 	/// Tasks:
 	void generateTasks();
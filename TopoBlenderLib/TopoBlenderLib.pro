@@ -61,7 +61,11 @@ HEADERS += StructureNode.h \
     Relink.h \
     GraphModifyWidget.h \
     GraphDissimilarity.h \
-    GraphExplorer.h
+    GraphExplorer.h \
+    ThumbnailRenderer.h \
+    Tracing.h \
+    GraphArena.h \
+    ObjReader.h
 
 SOURCES += StructureGraph.cpp \
     StructureCurve.cpp \
@@ -85,7 +89,11 @@ SOURCES += StructureGraph.cpp \
     Relink.cpp \
     GraphModifyWidget.cpp \
     GraphDissimilarity.cpp \
-    GraphExplorer.cpp
+    GraphExplorer.cpp \
+    ThumbnailRenderer.cpp \
+    Tracing.cpp \
+    GraphArena.cpp \
+    ObjReader.cpp
 
 # Graph visualization
 SOURCES += QGraphViz/svgview.cpp
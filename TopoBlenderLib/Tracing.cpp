@@ -0,0 +1,196 @@
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThreadStorage>
+#include <QElapsedTimer>
+#include <QCoreApplication>
+#include <QFile>
+#include <QTextStream>
+#include <QVector>
+#include <QList>
+#include <QMap>
+
+#include "Tracing.h"
+
+namespace Trace{
+
+volatile bool enabled = false;
+
+struct Event{
+	const char * name;
+	char phase;
+	qint64 time; // nanoseconds
+	double value;
+};
+
+// Each buffer has its own lock, only its thread and clear() or save() ever take it
+struct ThreadBuffer{
+	int tid;
+	QMutex mutex;
+	QVector<Event> events;
+};
+
+// QThreadStorage deletes its data when a thread ends, buffers must outlive it
+struct BufferHandle{
+	ThreadBuffer * buffer;
+	BufferHandle( ThreadBuffer * b ) : buffer(b) {}
+};
+
+static QMutex mutex;
+static QList<ThreadBuffer*> buffers;
+static QThreadStorage<BufferHandle*> localBuffer;
+static QMap<QString, double> counters;
+static QElapsedTimer traceClock;
+static QString exitFilename;
+static bool isExitRegistered = false;
+
+static void saveOnExit();
+
+static inline ThreadBuffer * threadBuffer()
+{
+	if( !localBuffer.hasLocalData() )
+	{
+		ThreadBuffer * b = new ThreadBuffer;
+		b->events.reserve( 1024 );
+
+		QMutexLocker locker( &mutex );
+		b->tid = buffers.size();
+		buffers.push_back( b );
+		localBuffer.setLocalData( new BufferHandle(b) );
+
+		// The application exists by the time anything is recorded
+		if( !isExitRegistered && !exitFilename.isEmpty() ){
+			qAddPostRoutine( saveOnExit );
+			isExitRegistered = true;
+		}
+	}
+	return localBuffer.localData()->buffer;
+}
+
+static inline void record( const char * name, char phase, double value = 0 )
+{
+	Event e;
+	e.name = name;
+	e.phase = phase;
+	e.time = traceClock.nsecsElapsed();
+	e.value = value;
+
+	ThreadBuffer * b = threadBuffer();
+	QMutexLocker locker( &b->mutex );
+	b->events.push_back( e );
+}
+
+void setEnabled( bool isEnabled )
+{
+	if( isEnabled && !traceClock.isValid() ) traceClock.start();
+	enabled = isEnabled;
+}
+
+void beginZone( const char * name )
+{
+	record( name, 'B' );
+}
+
+void endZone()
+{
+	record( NULL, 'E' );
+}
+
+void count( const char * name, double delta )
+{
+	double total;
+	{
+		QMutexLocker locker( &mutex );
+		total = (counters[name] += delta);
+	}
+	record( name, 'C', total );
+}
+
+void setCounter( const char * name, double value )
+{
+	{
+		QMutexLocker locker( &mutex );
+		counters[name] = value;
+	}
+	record( name, 'C', value );
+}
+
+void clear()
+{
+	QMutexLocker locker( &mutex );
+	foreach(ThreadBuffer * b, buffers){
+		QMutexLocker bufferLocker( &b->mutex );
+		b->events.clear();
+	}
+	counters.clear();
+}
+
+static QString escaped( QString s )
+{
+	return s.replace("\\", "\\\\").replace("\"", "\\\"");
+}
+
+bool save( QString filename )
+{
+	QFile file( filename );
+	if( !file.open(QIODevice::WriteOnly | QIODevice::Text) ) return false;
+	QTextStream out( &file );
+
+	QMutexLocker locker( &mutex );
+
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+	bool isFirst = true;
+	foreach(ThreadBuffer * b, buffers)
+	{
+		if(!isFirst) out << ",\n";
+		isFirst = false;
+		out << QString("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%1,\"args\":{\"name\":\"%2\"}}")
+			.arg(b->tid).arg(b->tid == 0 ? QString("main") : QString("worker %1").arg(b->tid));
+
+		QMutexLocker bufferLocker( &b->mutex );
+		foreach(const Event & e, b->events)
+		{
+			QString ts = QString::number(double(e.time) / 1000.0, 'f', 3);
+
+			out << ",\n";
+			if( e.phase == 'C' )
+				out << QString("{\"name\":\"%1\",\"ph\":\"C\",\"ts\":%2,\"pid\":1,\"tid\":%3,\"args\":{\"value\":%4}}")
+					.arg(escaped(e.name)).arg(ts).arg(b->tid).arg(e.value, 0, 'g', 12);
+			else if( e.phase == 'B' )
+				out << QString("{\"name\":\"%1\",\"ph\":\"B\",\"ts\":%2,\"pid\":1,\"tid\":%3}").arg(escaped(e.name)).arg(ts).arg(b->tid);
+			else
+				out << QString("{\"ph\":\"E\",\"ts\":%1,\"pid\":1,\"tid\":%2}").arg(ts).arg(b->tid);
+		}
+	}
+
+	out << "\n],\"counters\":{";
+	isFirst = true;
+	foreach(QString name, counters.keys()){
+		if(!isFirst) out << ",";
+		isFirst = false;
+		out << QString("\"%1\":%2").arg(escaped(name)).arg(counters[name], 0, 'g', 12);
+	}
+	out << "}}\n";
+
+	return true;
+}
+
+static void saveOnExit()
+{
+	if( !exitFilename.isEmpty() ) save( exitFilename );
+}
+
+// Runtime selection from the environment, works for the plugins and the demo alike
+struct EnvironmentSetup{
+	EnvironmentSetup()
+	{
+		QByteArray f = qgetenv("TOPOBLEND_TRACE");
+		if( f.isEmpty() ) return;
+
+		exitFilename = QString::fromLocal8Bit( f );
+		setEnabled( true );
+	}
+};
+static EnvironmentSetup environmentSetup;
+
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <QString>
+
+// Scoped timing zones and counters, exported as a Chrome trace (chrome://tracing or Perfetto).
+// Off by default. Turn on with Trace::setEnabled(), or by setting TOPOBLEND_TRACE=<file.json>,
+// in which case the trace is written when the application exits.
+namespace Trace{
+
+	extern volatile bool enabled;
+
+	inline bool isEnabled() { return enabled; }
+	void setEnabled( bool isEnabled );
+
+	// Events are kept in per-thread buffers, names must be string literals
+	void beginZone( const char * name );
+	void endZone();
+
+	void count( const char * name, double delta );		// accumulating counter, e.g. samples
+	void setCounter( const char * name, double value );	// absolute value, e.g. octree depth
+
+	void clear();
+	bool save( QString filename );
+
+	class Zone{
+	public:
+		Zone( const char * name ) : isActive(enabled) { if(isActive) beginZone(name); }
+		~Zone() { if(isActive) endZone(); }
+	private:
+		bool isActive;
+	};
+}
+
+#define TRACE_CONCAT_(a,b) a##b
+#define TRACE_CONCAT(a,b) TRACE_CONCAT_(a,b)
+
+#define TRACE_ZONE(name) Trace::Zone TRACE_CONCAT(traceZone, __LINE__)(name)
+#define TRACE_COUNT(name, delta) do{ if(Trace::enabled) Trace::count(name, delta); } while(0)
+#define TRACE_COUNTER(name, value) do{ if(Trace::enabled) Trace::setCounter(name, value); } while(0)
@@ -29,6 +29,8 @@ Date:   2 April 2013
 
 #include <iostream>
 #include <stdio.h>
+#include <float.h>
+#include <vector>
 
 #include "Eigen/Dense"
 
@@ -58,7 +60,7 @@ namespace kmeansFast
 	static unsigned long mt[N_N]; /* the array for the state vector  */
 	static int mti=N_N+1; /* mti==N_N+1 means mt[N_N] is not initialized */
 	/* initializes mt[N_N] with a seed */
-	void init_genrand(unsigned long s)
+	static void init_genrand(unsigned long s)
 	{
 		mt[0]= s & 0xffffffffUL;
 		for (mti=1; mti<N_N; mti++) {
@@ -76,7 +78,7 @@ namespace kmeansFast
 	/* init_key is the array for initializing keys */
 	/* key_length is its length */
 	/* slight change for C++, 2004/2/26 */
-	void init_by_array(unsigned long init_key[], int key_length)
+	static void init_by_array(unsigned long init_key[], int key_length)
 	{
 		int i, j, k;
 		init_genrand(19650218UL);
@@ -101,7 +103,7 @@ namespace kmeansFast
 		mt[0] = 0x80000000UL; /* MSB is 1; assuring non-zero initial array */ 
 	}
 	/* generates a random number on [0,0xffffffff]-interval */
-	unsigned long genrand_int32(void)
+	static unsigned long genrand_int32(void)
 	{
 		unsigned long y;
 		static unsigned long mag01[2]={0x0UL, MATRIX_A};
@@ -147,7 +149,7 @@ namespace kmeansFast
 	replacing the last return(), following to these five functions.
 	 *  =====================================================================
 	 */
-	double genrand_double(void)
+	static double genrand_double(void)
 	{
 		unsigned long y;
 		static unsigned long mag01[2]={0x0UL, MATRIX_A};
@@ -183,30 +185,30 @@ namespace kmeansFast
 		return y*(1.0/4294967295.0); 
 	}
 	/* generates a random number on [0,0x7fffffff]-interval */
-	long genrand_int31(void)
+	static long genrand_int31(void)
 	{
 		return (long)(genrand_int32()>>1);
 	}
 	/* generates a random number on [0,1]-real-interval */
-	double genrand_real1(void)
+	static double genrand_real1(void)
 	{
 		return genrand_int32()*(1.0/4294967295.0); 
 		/* divided by 2^32-1 */ 
 	}
 	/* generates a random number on [0,1)-real-interval */
-	double genrand_real2(void)
+	static double genrand_real2(void)
 	{
 		return genrand_int32()*(1.0/4294967296.0); 
 		/* divided by 2^32 */
 	}
 	/* generates a random number on (0,1)-real-interval */
-	double genrand_real3(void)
+	static double genrand_real3(void)
 	{
 		return (((double)genrand_int32()) + 0.5)*(1.0/4294967296.0); 
 		/* divided by 2^32 */
 	}
 	/* generates a random number on [0,1) with 53-bit resolution*/
-	double genrand_res53(void) 
+	static double genrand_res53(void) 
 	{ 
 		unsigned long a=genrand_int32()>>5, b=genrand_int32()>>6; 
 		return(a*67108864.0+b)*(1.0/9007199254740992.0); 
@@ -215,11 +217,11 @@ namespace kmeansFast
 
 
 	// ====================================================== Utility Functions
-	void set_seed( int seed ) {
+	static void set_seed( int seed ) {
 	  init_genrand( seed );
 	}
 
-	int discrete_rand( Vec &p ) {
+	static int discrete_rand( Vec &p ) {
 		double total = p.sum();
 		int K = (int) p.size();
 		
@@ -237,7 +239,7 @@ namespace kmeansFast
 		return newk;
 	}
 
-	void select_without_replacement( int N, int K, Vec &chosenIDs) {
+	static void select_without_replacement( int N, int K, Vec &chosenIDs) {
 		Vec p = Vec::Ones(N);
 		for (int kk =0; kk<K; kk++) {
 		  int choice;
@@ -260,7 +262,7 @@ namespace kmeansFast
 
 	// ======================================================= Init Cluster Locs Mu
 
-	void sampleRowsRandom( ExtMat &X, ExtMat &Mu ) {
+	static void sampleRowsRandom( ExtMat &X, ExtMat &Mu ) {
 		int N = X.rows();
 		int K = Mu.rows();
 		Vec ChosenIDs = Vec::Zero(K);
@@ -270,7 +272,7 @@ namespace kmeansFast
 			}
 	}
 
-	void sampleRowsPlusPlus( ExtMat &X, ExtMat &Mu ) {
+	static void sampleRowsPlusPlus( ExtMat &X, ExtMat &Mu ) {
 		int N = X.rows();
 		int K = Mu.rows();
 		Vec ChosenIDs = Vec::Ones(K);
@@ -281,7 +283,7 @@ namespace kmeansFast
 		Vec minDist(N);
 		Vec curDist(N);
 		for (int kk=1; kk<K; kk++) {
-		  curDist = ( X.rowwise() - Mu.row(kk-1) ).square().rowwise().sum().sqrt();
+		  curDist = ( X.rowwise() - Mu.row(kk-1) ).square().rowwise().sum();
 		  if (kk==1) {
 			minDist = curDist;
 		  } else {
@@ -293,7 +295,7 @@ namespace kmeansFast
 		}       
 	}
 
-	void init_Mu( ExtMat &X, ExtMat &Mu, char* initname ) {		  
+	static void init_Mu( ExtMat &X, ExtMat &Mu, char* initname ) {		  
 		  if ( string( initname ) == "random" ) {
 				sampleRowsRandom( X, Mu );
 		  } else if ( string( initname ) == "plusplus" ) {
@@ -302,7 +304,7 @@ namespace kmeansFast
 	}
 
 	// ======================================================= Update Cluster Assignments Z
-	void pairwise_distance( ExtMat &X, ExtMat &Mu, Mat &Dist ) {
+	static void pairwise_distance( ExtMat &X, ExtMat &Mu, Mat &Dist ) {
 	  //int N = X.rows();
 	  int D = X.cols();
 	  int K = Mu.rows();
@@ -319,7 +321,7 @@ namespace kmeansFast
 	  }
 	}
 
-	double assignClosest( ExtMat &X, ExtMat &Mu, ExtMat &Z, Mat &Dist) {
+	static double assignClosest( ExtMat &X, ExtMat &Mu, ExtMat &Z, Mat &Dist) {
 	  double totalDist = 0;
 	  int minRowID;
 
@@ -333,7 +335,7 @@ namespace kmeansFast
 	}
 
 	// ======================================================= Update Cluster Locations Mu
-	void calc_Mu( ExtMat &X, ExtMat &Mu, ExtMat &Z) {
+	static void calc_Mu( ExtMat &X, ExtMat &Mu, ExtMat &Z) {
 	  Mu = Mat::Zero( Mu.rows(), Mu.cols() );
 	  Vec NperCluster = Vec::Zero( Mu.rows() );
 	  
@@ -345,7 +347,7 @@ namespace kmeansFast
 	}
 
 	// ======================================================= Overall Lloyd Algorithm
-	void run_lloyd( ExtMat &X, ExtMat &Mu, ExtMat &Z, int Niter )  {
+	static void run_lloyd( ExtMat &X, ExtMat &Mu, ExtMat &Z, int Niter )  {
 	  double prevDist = 0,totalDist = 0;
 
 	  Mat Dist = Mat::Zero( X.rows(), Mu.rows() );  
@@ -361,12 +363,154 @@ namespace kmeansFast
 	  }
 	}
 
+	// ======================================================= Hamerly's Accelerated Lloyd
+	/*  Same fixed point as run_lloyd, but each point keeps an upper bound on the distance
+		to its center and a lower bound on the distance to the second closest. Points whose
+		bounds cannot change the assignment skip the distance computations.
+		see G. Hamerly, "Making k-means even faster", SDM 2010
+	*/
+	// Points and centers are stored as columns here, so each distance runs over contiguous memory
+	static void closestTwo( const MatrixXd &Xt, const MatrixXd &Ct, int nn, int &best, double &d1, double &d2 ) {
+	  best = 0;
+	  d1 = d2 = DBL_MAX;
+	  for (int kk=0; kk<Ct.cols(); kk++) {
+		double d = ( Xt.col(nn) - Ct.col(kk) ).norm();
+		if ( d < d1 ) {
+		  d2 = d1;
+		  d1 = d;
+		  best = kk;
+		} else if ( d < d2 ) {
+		  d2 = d;
+		}
+	  }
+	}
+
+	static void run_hamerly( ExtMat &X, ExtMat &Mu, ExtMat &Z, int Niter ) {
+	  int N = X.rows();
+	  int K = Mu.rows();
+
+	  MatrixXd Xt = X.matrix().transpose();
+	  MatrixXd Ct = Mu.matrix().transpose();
+	  Vec upper(N), lower(N);
+	  std::vector<int> a(N);
+
+	  #pragma omp parallel for
+	  for (int nn=0; nn<N; nn++) {
+		closestTwo( Xt, Ct, nn, a[nn], upper[nn], lower[nn] );
+	  }
+
+	  Vec s(K), moved(K), NperCluster(K);
+
+	  for (int iter=0; iter<Niter; iter++) {
+		
+		// Update cluster locations, empty clusters stay where they are
+		MatrixXd newCt = MatrixXd::Zero( Ct.rows(), K );
+		NperCluster.setZero();
+		for (int nn=0; nn<N; nn++) {
+		  newCt.col( a[nn] ) += Xt.col( nn );
+		  NperCluster[ a[nn] ] += 1;
+		}
+		for (int kk=0; kk<K; kk++) {
+		  if ( NperCluster[kk] > 0 ) newCt.col(kk) /= NperCluster[kk];
+		  else newCt.col(kk) = Ct.col(kk);
+		  moved[kk] = ( newCt.col(kk) - Ct.col(kk) ).norm();
+		}
+		Ct = newCt;
+
+		// Loosen bounds by how far centers moved
+		int farthest = 0;
+		double maxMoved = moved.maxCoeff( &farthest );
+		double secondMoved = 0;
+		for (int kk=0; kk<K; kk++) if ( kk != farthest ) secondMoved = std::max( secondMoved, moved[kk] );
+
+		for (int nn=0; nn<N; nn++) {
+		  upper[nn] += moved[ a[nn] ];
+		  lower[nn] -= ( a[nn] == farthest ) ? secondMoved : maxMoved;
+		}
+
+		// Half distance to the closest other center
+		for (int kk=0; kk<K; kk++) {
+		  s[kk] = DBL_MAX;
+		  for (int jj=0; jj<K; jj++) {
+			if ( jj == kk ) continue;
+			s[kk] = std::min( s[kk], 0.5 * ( Ct.col(kk) - Ct.col(jj) ).norm() );
+		  }
+		}
+
+		// Update cluster assignments
+		int changed = 0;
+
+		#pragma omp parallel for reduction(+:changed)
+		for (int nn=0; nn<N; nn++) {
+		  double m = std::max( s[ a[nn] ], lower[nn] );
+		  if ( upper[nn] <= m ) continue;
+
+		  // Tighten upper bound
+		  upper[nn] = ( Xt.col(nn) - Ct.col( a[nn] ) ).norm();
+		  if ( upper[nn] <= m ) continue;
+
+		  int best;
+		  closestTwo( Xt, Ct, nn, best, upper[nn], lower[nn] );
+		  if ( best != a[nn] ) {
+			a[nn] = best;
+			changed++;
+		  }
+		}
+
+		if ( changed == 0 ) break;
+	  }
+
+	  Mu = Ct.transpose().array();
+	  for (int nn=0; nn<N; nn++) Z(nn,0) = a[nn];
+	}
+
+	// ======================================================= Mini-batch K-Means
+	/*  Centers are updated from small random batches with per-center learning rates,
+		for inputs where full Lloyd iterations are too costly.
+		see D. Sculley, "Web-scale k-means clustering", WWW 2010
+	*/
+	static void run_minibatch( ExtMat &X, ExtMat &Mu, ExtMat &Z, int batchSize, int Niter ) {
+	  int N = X.rows();
+	  int K = Mu.rows();
+	  batchSize = std::min( batchSize, N );
+
+	  MatrixXd Ct = Mu.matrix().transpose();
+	  MatrixXd Xb( batchSize, X.cols() );
+	  Vec counts = Vec::Zero( K );
+	  std::vector<int> batch( batchSize );
+
+	  for (int iter=0; iter<Niter; iter++) {
+		for (int bb=0; bb<batchSize; bb++) {
+		  batch[bb] = genrand_int32() % N;
+		  Xb.row(bb) = X.row( batch[bb] ).matrix();
+		}
+
+		// Squared distances up to a per-row constant, as one product
+		MatrixXd Dist = -2 * ( Xb * Ct );
+		Dist.rowwise() += Ct.colwise().squaredNorm();
+
+		for (int bb=0; bb<batchSize; bb++) {
+		  int kk;
+		  Dist.row(bb).minCoeff( &kk );
+		  counts[kk] += 1;
+		  double eta = 1.0 / counts[kk];
+		  Ct.col(kk) = ( 1.0 - eta ) * Ct.col(kk) + eta * Xb.row(bb).transpose();
+		}
+	  }
+
+	  Mu = Ct.transpose().array();
+
+	  // Final assignment over all points
+	  Mat Dist( N, K );
+	  assignClosest( X, Mu, Z, Dist );
+	}
+
 	// =================================================================================
 	// =================================================================================
 	// ===========================  EXTERNALLY CALLABLE FUNCTIONS ======================
 	// =================================================================================
 	// =================================================================================
-	void RunKMeans(double *X_IN,  int N,  int D, int K, int Niter, \
+	static void RunKMeans(double *X_IN,  int N,  int D, int K, int Niter, \
 				   int seed, char* initname, double *Mu_OUT, double *Z_OUT) {
 	  set_seed( seed );
 
@@ -378,7 +522,7 @@ namespace kmeansFast
 	  run_lloyd( X, Mu, Z, Niter );
 	}
 	
-	void SampleRowsPlusPlus(double *X_IN,  int N,  int D, int K, int seed, double *Mu_OUT) {
+	static void SampleRowsPlusPlus(double *X_IN,  int N,  int D, int K, int seed, double *Mu_OUT) {
 	  set_seed( seed );
 
 	  ExtMat X  ( X_IN, N, D);
@@ -396,10 +540,53 @@ namespace kmeansFast
 		int num_clusters;
 	};
 
-	Clusters kmeans( MatrixXd X_IN, int K, int iterations = 25 )
+	static Clusters toClusters( ExtMat &Mu, ExtMat &Z )
+	{
+		Clusters result;
+
+		for(int i = 0; i < Z.rows(); i++)
+		{
+			int c = Z(i);
+
+			result.cluster.push_back( c );
+			result.size[c]++;
+		}
+
+		result.num_clusters = result.size.size();
+
+		for(int i = 0; i < Mu.rows(); i++)
+		{
+			result.centers.push_back( Mu.row(i) );
+		}
+
+		return result;
+	}
+
+	// A negative seed picks a random one
+	static Clusters kmeans( MatrixXd X_IN, int K, int iterations = 25, int seed = -1 )
 	{
-		// random seed
-		set_seed( (int) clock() );
+		set_seed( seed < 0 ? (int) clock() : seed );
+
+		int N = X_IN.rows();
+		int D = X_IN.cols();
+
+		MatrixXd Mu_OUT(K, D);
+		MatrixXd Z_OUT(N, 1);
+
+		ExtMat X  ( X_IN.data(), N, D);
+		ExtMat Mu ( Mu_OUT.data(), K, D);
+		ExtMat Z  ( Z_OUT.data(), N, 1);
+
+		init_Mu( X, Mu, "plusplus");
+		run_hamerly( X, Mu, Z, iterations );
+
+		return toClusters( Mu, Z );
+	}
+
+	// Plain Lloyd iterations, the previous implementation, kept for comparison
+	static Clusters kmeansLloyd( MatrixXd X_IN, int K, int iterations = 25, int seed = -1 )
+	{
+		set_seed( seed < 0 ? (int) clock() : seed );
 
 		int N = X_IN.rows();
 		int D = X_IN.cols();
@@ -414,23 +601,35 @@ namespace kmeansFast
 		init_Mu( X, Mu, "plusplus");
 		run_lloyd( X, Mu, Z, iterations );
 
-		Clusters result;
+		return toClusters( Mu, Z );
+	}
 
-		for(int i = 0; i < N; i++)
-		{
-			int c = Z(i);
+	// Sum of squared distances of points to their centers
+	static double cost( const MatrixXd & X, const Clusters & c )
+	{
+		double total = 0;
+		for(int i = 0; i < X.rows(); i++)
+			total += ( X.row(i).transpose().array() - c.centers[ c.cluster[i] ] ).square().sum();
+		return total;
+	}
 
-			result.cluster.push_back( c );
-			result.size[c]++;
-		}
+	static Clusters kmeansMiniBatch( MatrixXd X_IN, int K, int batchSize = 256, int iterations = 50, int seed = -1 )
+	{
+		set_seed( seed < 0 ? (int) clock() : seed );
 
-		result.num_clusters = result.size.size();
+		int N = X_IN.rows();
+		int D = X_IN.cols();
 
-		for(int i = 0; i < Mu.rows(); i++)
-		{
-			result.centers.push_back( Mu.row(i) );
-		}
+		MatrixXd Mu_OUT(K, D);
+		MatrixXd Z_OUT(N, 1);
 
-		return result;
+		ExtMat X  ( X_IN.data(), N, D);
+		ExtMat Mu ( Mu_OUT.data(), K, D);
+		ExtMat Z  ( Z_OUT.data(), N, 1);
+
+		init_Mu( X, Mu, "plusplus");
+		run_minibatch( X, Mu, Z, batchSize, iterations );
+
+		return toClusters( Mu, Z );
 	}
 }
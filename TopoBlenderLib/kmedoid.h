@@ -147,5 +147,120 @@ struct kmedoid {
 			iterations++;
 		}
 	}
+
+	/* FasterPAM: swap based medoid search with eager swaps, O(n) per candidate swap
+	   instead of O(n k). Dissimilarities are computed once up front.
+	   see E. Schubert and P. J. Rousseeuw, "Fast and eager k-medoids clustering", 2021 */
+	static void nearestTwo( const QVector<double> &D, int n, const QVector<int> &medoids, int o, int &nearest, double &dn, double &ds )
+	{
+		nearest = 0;
+		dn = ds = std::numeric_limits< double >::infinity();
+		for( int i = 0; i < medoids.size(); ++i )
+		{
+			double d = D[ o * n + medoids[i] ];
+			if( d < dn ){ ds = dn; dn = d; nearest = i; }
+			else if( d < ds ){ ds = d; }
+		}
+	}
+
+	static void updateCaches( const QVector<double> &D, int n, const QVector<int> &medoids, QVector<int> &nearest, 
+		QVector<double> &dn, QVector<double> &ds, QVector<double> &removalLoss )
+	{
+		removalLoss.fill( 0 );
+		for( int o = 0; o < n; ++o ){
+			nearestTwo( D, n, medoids, o, nearest[o], dn[o], ds[o] );
+			removalLoss[ nearest[o] ] += ds[o] - dn[o];
+		}
+	}
+
+	static void runFast(const DataSet &data, int clusterCount, QVector<int> &clusters, QVector< QVector<double> > &currentMeans, int seed = 0)
+	{
+		int n = data.points.size();
+		clusterCount = qMin( clusterCount, n );
+		if( clusterCount < 1 ) return;
+
+		// All pairwise dissimilarities
+		QVector<double> D( n * n );
+
+		#pragma omp parallel for
+		for( int i = 0; i < n; ++i )
+			for( int j = 0; j < n; ++j )
+				D[ i * n + j ] = distance( data.points.at( i ), data.points.at( j ) );
+
+		// Distinct random medoids, reproducible for a given seed and leaves qrand() alone
+		QVector<int> medoids;
+		QVector<bool> isMedoid( n, false );
+		quint32 state = seed;
+		while( medoids.size() < clusterCount )
+		{
+			state = state * 1664525u + 1013904223u;
+			int randomRow = int( (quint64(state) * n) >> 32 );
+			if( isMedoid[randomRow] ) continue;
+			isMedoid[randomRow] = true;
+			medoids.push_back( randomRow );
+		}
+
+		// Single medoid, the swap deltas are not finite
+		if( clusterCount == 1 )
+		{
+			int best = 0;
+			double bestCost = std::numeric_limits< double >::infinity();
+			for( int i = 0; i < n; ++i ){
+				double cost = 0;
+				for( int j = 0; j < n; ++j ) cost += D[ i * n + j ];
+				if( cost < bestCost ){ bestCost = cost; best = i; }
+			}
+			clusters.fill( 0, n );
+			currentMeans.clear();
+			currentMeans.append( data.points.at( best ) );
+			return;
+		}
+
+		QVector<int> nearest( n );
+		QVector<double> dn( n ), ds( n ), removalLoss( clusterCount ), delta( clusterCount );
+		updateCaches( D, n, medoids, nearest, dn, ds, removalLoss );
+
+		// Stop after a full pass over the points without any swap
+		int sinceSwap = 0;
+		for( int c = 0; sinceSwap < n; c = (c + 1) % n, ++sinceSwap )
+		{
+			if( isMedoid[c] ) continue;
+
+			delta = removalLoss;
+			double gain = 0;
+
+			for( int o = 0; o < n; ++o )
+			{
+				double doc = D[ o * n + c ];
+
+				if( doc < dn[o] ){
+					gain += doc - dn[o];
+					delta[ nearest[o] ] += dn[o] - ds[o];
+				}
+				else if( doc < ds[o] ){
+					delta[ nearest[o] ] += doc - ds[o];
+				}
+			}
+
+			int best = 0;
+			for( int i = 1; i < clusterCount; ++i ) if( delta[i] < delta[best] ) best = i;
+
+			if( delta[best] + gain >= -1e-12 ) continue;
+
+			// Eager swap
+			isMedoid[ medoids[best] ] = false;
+			isMedoid[ c ] = true;
+			medoids[best] = c;
+			sinceSwap = 0;
+
+			updateCaches( D, n, medoids, nearest, dn, ds, removalLoss );
+		}
+
+		clusters.resize( n );
+		for( int o = 0; o < n; ++o ) clusters[o] = nearest[o];
+
+		currentMeans.clear();
+		foreach( int m, medoids ) currentMeans.append( data.points.at( m ) );
+	}
 };
 
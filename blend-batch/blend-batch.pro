@@ -0,0 +1,49 @@
+include($$[STARLAB])
+include($$[SURFACEMESH])
+StarlabTemplate(appbundle)
+
+# Build flag for the static libraries
+CONFIG(debug, debug|release) {
+    CFG = debug
+} else {
+    CFG = release
+}
+
+# NURBS library
+LIBS += -L$$PWD/../NURBS/$$CFG/lib -lNURBS
+INCLUDEPATH += ../NURBS
+
+# Surface Reconstruction library
+LIBS += -L$$PWD/../Reconstruction/$$CFG/lib -lReconstruction
+INCLUDEPATH += ../Reconstruction
+
+# TopoBlender library
+LIBS += -L$$PWD/../TopoBlenderLib/$$CFG/lib -lTopoBlenderLib
+INCLUDEPATH += ../TopoBlenderLib
+
+# Splat Rendering library
+LIBS += -L$$PWD/../GlSplatRendererLib/$$CFG/lib -lGlSplatRendererLib
+INCLUDEPATH += ../GlSplatRendererLib
+
+QT += core gui opengl svg xml
+
+TARGET = blend-batch
+CONFIG += console
+mac:CONFIG -= app_bundle
+
+# JSON writer shared with the demo
+INCLUDEPATH += ../demo
+
+SOURCES += main.cpp \
+           ../demo/json.cpp
+
+HEADERS += ../demo/json.h
+
+mac:QMAKE_LFLAGS += -fopenmp
+
+unix:!mac:QMAKE_CXXFLAGS = $$QMAKE_CFLAGS -fpermissive
+unix:!mac:LIBS += -lGLU
+
+# This is some weird linker issue..
+unix:!mac:LIBS += $$PWD/../NURBS/$$CFG/lib/libNURBS.a
+unix:!mac:LIBS += $$PWD/../Reconstruction/$$CFG/lib/libReconstruction.a
@@ -0,0 +1,681 @@
+// Headless batch blending: runs the full pipeline on shape pairs and writes a benchmark report
+//
+// Usage:
+//   blend-batch [options] <job file | folder of job files> ...
+//   blend-batch [options] --source a.xml --target b.xml [--corr c.txt] [--schedule s.txt]
+//
+// Options:
+//   --seed N          random seed (default 0)
+//   --samples N       synthesis samples per shape (default from job, or 8000)
+//   --resolution R    graph distance resolution, DIST_RESOLUTION (default from job)
+//   --timestep T      scheduler time step (default from job)
+//   --recon N         Poisson reconstruction depth (default from job, or 7)
+//   --renders N       number of in-betweens to reconstruct (default from job, 0 skips)
+//   --thumbs          render a thumbnail for each reconstructed in-between
+//   --out DIR         output folder (default "batch_output")
+//   --report FILE     report file (default <out>/report.json)
+//   --trace FILE      write a Chrome trace of all stages (chrome://tracing)
+//   --clones N        benchmark N heap copies against N arena clones of every blended frame
+//   --remesh          time the isotropic remeshing of every part of both shapes
+//   --cluster K       compare the old and new k-means and k-medoids on the blended frames
+//   --adaptive        adaptive time stepping in the scheduler (see Scheduler::isAdaptiveTimeStep)
+//   --tolerance T     adaptive step tolerance, control point motion per step relative to graph size
+
+#include <QApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QElapsedTimer>
+#include <QCryptographicHash>
+#include <QDirIterator>
+#include <QDebug>
+
+#include <omp.h>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+#include "StructureGraph.h"
+#include "GraphCorresponder.h"
+#include "TopoBlender.h"
+#include "Scheduler.h"
+#include "Task.h"
+#include "SynthesisManager.h"
+#include "Synthesizer.h"
+#include "GraphDistance.h"
+#include "ThumbnailRenderer.h"
+#include "Tracing.h"
+#include "json.h"
+
+#include "kmeans.h"
+#include "kmedoid.h"
+
+struct BatchJob{
+	QString name;
+	QString path;
+	QString sourceFile, targetFile, corrFile, scheduleFile;
+	int samplesCount;
+	double gdResolution, timeStep;
+	int reconLevel, renderCount;
+
+	BatchJob() : samplesCount(8000), gdResolution(DIST_RESOLUTION), timeStep(1.0 / 100.0), reconLevel(7), renderCount(0) {}
+
+	// Same layout as the job files saved by the blend widgets
+	bool load( QString job_filename )
+	{
+		QFile job_file( job_filename );
+		if (!job_file.open(QIODevice::ReadOnly | QIODevice::Text)) return false;
+		QFileInfo jobFileInfo(job_file.fileName());
+		QTextStream in(&job_file);
+
+		name = jobFileInfo.baseName();
+		path = jobFileInfo.absolutePath() + "/";
+
+		sourceFile = path + in.readLine();
+		targetFile = path + in.readLine();
+		corrFile = path + in.readLine();
+		scheduleFile = path + in.readLine();
+
+		in >> samplesCount;
+		in >> gdResolution >> timeStep;
+		in >> reconLevel >> renderCount;
+
+		return true;
+	}
+};
+
+struct BatchOptions{
+	uint seed;
+	int samplesCount, reconLevel, renderCount, cloneCount, clusterCount;
+	double gdResolution, timeStep, adaptiveTolerance;
+	bool isThumbnails, isRemesh, isAdaptive;
+	QString outputFolder, reportFile, traceFile;
+
+	BatchOptions() : seed(0), samplesCount(-1), reconLevel(-1), renderCount(-1), cloneCount(0), clusterCount(0), gdResolution(-1), timeStep(-1), 
+		adaptiveTolerance(-1), isThumbnails(false), isRemesh(false), isAdaptive(false), outputFolder("batch_output") {}
+
+	void apply( BatchJob & job ) const
+	{
+		if(samplesCount >= 0) job.samplesCount = samplesCount;
+		if(reconLevel >= 0) job.reconLevel = reconLevel;
+		if(renderCount >= 0) job.renderCount = renderCount;
+		if(gdResolution > 0) job.gdResolution = gdResolution;
+		if(timeStep > 0) job.timeStep = timeStep;
+	}
+};
+
+// Peak resident set size of the process so far, in kilobytes
+static qint64 peakMemoryKB()
+{
+#ifdef Q_OS_UNIX
+	struct rusage usage;
+	if( getrusage(RUSAGE_SELF, &usage) == 0 ){
+#ifdef Q_OS_MAC
+		return usage.ru_maxrss / 1024;
+#else
+		return usage.ru_maxrss;
+#endif
+	}
+#endif
+	return 0;
+}
+
+// Largest control point move between consecutive frames, relative to the first frame's size
+static double maxFrameMotion( const QVector<Structure::Graph*> & frames )
+{
+	if( frames.size() < 2 ) return 0;
+
+	double diagonal = qMax(1e-12, frames.front()->bbox().diagonal().norm());
+	double maxMotion = 0;
+
+	for(int f = 1; f < frames.size(); f++)
+	{
+		foreach(Structure::Node * n, frames[f]->nodes)
+		{
+			Structure::Node * prev = frames[f-1]->getNode( n->id );
+			if( !prev ) continue;
+
+			Array1D_Vector3 cp = n->controlPoints(), prevCp = prev->controlPoints();
+			if( cp.size() != prevCp.size() ) continue;
+
+			for(int i = 0; i < (int)cp.size(); i++)
+				maxMotion = qMax(maxMotion, (cp[i] - prevCp[i]).norm());
+		}
+	}
+
+	return maxMotion / diagonal;
+}
+
+// Times and costs of each clustering method on the frames' control points
+static QVariantMap compareClustering( const QVector<Structure::Graph*> & frames, int K, int seed )
+{
+	QVariantMap result;
+	if(frames.size() < 2 || K < 1) return result;
+
+	// One row per frame, all control points of the frame
+	QVector< QVector<double> > rows;
+	int D = 0;
+	foreach(Structure::Graph * g, frames)
+	{
+		QVector<double> row;
+		foreach(Structure::Node * n, g->nodes) foreach(Vector3 p, n->controlPoints()) row << p[0] << p[1] << p[2];
+		D = qMax(D, row.size());
+		rows << row;
+	}
+
+	int N = rows.size();
+	MatrixXd X = MatrixXd::Zero(N, D);
+	for(int i = 0; i < N; i++)
+		for(int j = 0; j < rows[i].size(); j++)
+			X(i,j) = rows[i][j];
+
+	result["points"] = N;
+	result["dims"] = D;
+	result["k"] = K;
+
+	QElapsedTimer timer;
+
+	// k-means, same seed for each method
+	timer.start();
+	kmeansFast::Clusters lloyd = kmeansFast::kmeansLloyd(X, K, 25, seed);
+	result["lloyd_ms"] = timer.nsecsElapsed() * 1e-6;
+	result["lloyd_cost"] = kmeansFast::cost(X, lloyd);
+
+	timer.start();
+	kmeansFast::Clusters hamerly = kmeansFast::kmeans(X, K, 25, seed);
+	result["hamerly_ms"] = timer.nsecsElapsed() * 1e-6;
+	result["hamerly_cost"] = kmeansFast::cost(X, hamerly);
+
+	timer.start();
+	kmeansFast::Clusters minibatch = kmeansFast::kmeansMiniBatch(X, K, 256, 50, seed);
+	result["minibatch_ms"] = timer.nsecsElapsed() * 1e-6;
+	result["minibatch_cost"] = kmeansFast::cost(X, minibatch);
+
+	// k-medoids, total distance of points to their medoid
+	kmedoid::DataSet data;
+	for(int i = 0; i < N; i++){
+		QVector<double> p(D, 0.0);
+		for(int j = 0; j < D; j++) p[j] = X(i,j);
+		data.points << p;
+	}
+
+	QVector<int> clusters;
+	QVector< QVector<double> > medoids;
+
+	timer.start();
+	kmedoid::run(data, K, clusters, medoids);
+	result["pam_ms"] = timer.nsecsElapsed() * 1e-6;
+	double deviation = 0;
+	for(int i = 0; i < N; i++) deviation += kmedoid::distance(data.points[i], medoids[clusters[i]]);
+	result["pam_deviation"] = deviation;
+
+	clusters.clear(); medoids.clear();
+
+	timer.start();
+	kmedoid::runFast(data, K, clusters, medoids, seed);
+	result["fasterpam_ms"] = timer.nsecsElapsed() * 1e-6;
+	deviation = 0;
+	for(int i = 0; i < N; i++) deviation += kmedoid::distance(data.points[i], medoids[clusters[i]]);
+	result["fasterpam_deviation"] = deviation;
+
+	return result;
+}
+
+// Checksums are taken over printed values so they survive harmless changes in memory layout
+class Checksum{
+public:
+	Checksum() : hash(QCryptographicHash::Md5) {}
+	void add( const QString & s ){ hash.addData( s.toUtf8() ); }
+	void add( double v ){ add( QString::number(v, 'g', 6) + " " ); }
+	void add( const Vector3 & v ){ add(v[0]); add(v[1]); add(v[2]); }
+	void addFile( QString filename ){
+		QFile f( filename );
+		if( f.open(QIODevice::ReadOnly) ) hash.addData( f.readAll() );
+	}
+	void addGraph( Structure::Graph * g ){
+		foreach(Structure::Node * n, g->nodes){
+			add( n->id );
+			foreach(Vector3 p, n->controlPoints()) add(p);
+		}
+		foreach(Structure::Link * l, g->edges) add( l->id );
+	}
+	QString result(){ return QString( hash.result().toHex() ); }
+private:
+	QCryptographicHash hash;
+};
+
+class StageTimer{
+public:
+	StageTimer( QVariantList & stages ) : stages(stages), elapsed(0), isStopped(false) { timer.start(); }
+
+	// Ends the timed work of a stage, what follows until done() is the checksum
+	void stop()
+	{
+		if( isStopped ) return;
+		elapsed = timer.elapsed();
+		isStopped = true;
+		timer.restart();
+	}
+
+	void done( QString stage, QString checksum, QVariantMap extra = QVariantMap() )
+	{
+		stop();
+
+		QVariantMap s = extra;
+		s["stage"] = stage;
+		s["time_ms"] = elapsed;
+		s["hash_ms"] = timer.elapsed();
+		s["peak_rss_kb"] = peakMemoryKB();
+		s["checksum"] = checksum;
+		stages << s;
+
+		qDebug() << QString("  %1 [ %2 ms ]").arg(stage).arg(elapsed);
+
+		isStopped = false;
+		timer.restart();
+	}
+
+private:
+	QVariantList & stages;
+	QElapsedTimer timer;
+	qint64 elapsed;
+	bool isStopped;
+};
+
+static QVariantMap runJob( BatchJob job, const BatchOptions & options )
+{
+	TRACE_ZONE("blend-batch::job");
+
+	QVariantMap report;
+	QVariantList stages;
+
+	options.apply( job );
+
+	report["name"] = job.name;
+	report["source"] = job.sourceFile;
+	report["target"] = job.targetFile;
+	report["seed"] = options.seed;
+	report["samples"] = job.samplesCount;
+	report["dist_resolution"] = job.gdResolution;
+	report["time_step"] = job.timeStep;
+	report["recon_level"] = job.reconLevel;
+	report["render_count"] = job.renderCount;
+	report["adaptive"] = options.isAdaptive;
+
+	qDebug() << "Job:" << job.name;
+
+	// Everything random is driven from here
+	srand( options.seed );
+	qsrand( options.seed );
+	DIST_RESOLUTION = job.gdResolution;
+
+	QElapsedTimer totalTimer; totalTimer.start();
+	StageTimer stage( stages );
+
+	// Load graphs, part meshes of both are read in parallel
+	QVector<Structure::Graph*> inputGraphs = Structure::Graph::loadGraphs( QStringList() << job.sourceFile << job.targetFile );
+	Structure::Graph * sg = inputGraphs.front();
+	Structure::Graph * tg = inputGraphs.back();
+	{
+		stage.stop();
+		Checksum c; c.addGraph(sg); c.addGraph(tg);
+		QVariantMap extra; extra["nodes"] = sg->nodes.size() + tg->nodes.size();
+		stage.done("load", c.result(), extra);
+	}
+
+	if( sg->nodes.isEmpty() || tg->nodes.isEmpty() )
+	{
+		report["error"] = "could not load input graphs";
+		report["stages"] = stages;
+		return report;
+	}
+
+	// Remesh sampling of every part, per shape
+	if( options.isRemesh )
+	{
+		QVariantList shapes;
+		QVector< QVector<ParameterCoord> > allSamples;
+		int totalSamples = 0;
+
+		QVector<Structure::Graph*> graphs; graphs << sg << tg;
+		QStringList names; names << QFileInfo(job.sourceFile).baseName() << QFileInfo(job.targetFile).baseName();
+
+		// Remeshing and the projection onto the parameter domain are timed apart
+		for(int i = 0; i < graphs.size(); i++)
+		{
+			QElapsedTimer timer;
+			qint64 remeshNs = 0, projectNs = 0;
+			int numSamples = 0;
+
+			foreach(Structure::Node * n, graphs[i]->nodes)
+			{
+				if( !graphs[i]->getMesh(n->id) ) continue;
+
+				std::vector<Eigen::Vector3f> points, normals;
+				timer.start();
+				Synthesizer::remeshPoints( n, points, normals );
+				remeshNs += timer.nsecsElapsed();
+
+				timer.start();
+				if( n->type() == Structure::CURVE )
+					allSamples.push_back( Synthesizer::genPointCoordsCurve((Structure::Curve*)n, points, normals) );
+				else
+					allSamples.push_back( Synthesizer::genPointCoordsSheet((Structure::Sheet*)n, points, normals) );
+				projectNs += timer.nsecsElapsed();
+
+				numSamples += allSamples.back().size();
+			}
+
+			QVariantMap shape;
+			shape["name"] = names[i];
+			shape["time_ms"] = remeshNs * 1e-6;
+			shape["project_ms"] = projectNs * 1e-6;
+			shape["samples"] = numSamples;
+			shapes << shape;
+
+			totalSamples += numSamples;
+		}
+		stage.stop();
+
+		Checksum c;
+		foreach(QVector<ParameterCoord> samples, allSamples)
+			foreach(ParameterCoord s, samples){ c.add(s.u); c.add(s.v); c.add(s.theta); c.add(s.psi); }
+
+		QVariantMap extra; extra["shapes"] = shapes; extra["samples_total"] = totalSamples; extra["threads"] = omp_get_max_threads();
+		stage.done("remesh", c.result(), extra);
+	}
+
+	// Correspondence
+	GraphCorresponder * gcorr = new GraphCorresponder( sg, tg );
+	{
+		bool isFromFile = QFileInfo(job.corrFile).isFile();
+		if( isFromFile ){
+			gcorr->loadCorrespondences( job.corrFile );
+			gcorr->isReady = true;
+		}
+		else
+			gcorr->computeCorrespondences();
+		stage.stop();
+
+		Checksum c;
+		foreach(PART_LANDMARK vector2vector, gcorr->correspondences){
+			foreach(QString id, vector2vector.first) c.add(id);
+			c.add(QString("->"));
+			foreach(QString id, vector2vector.second) c.add(id);
+		}
+		QVariantMap extra; extra["from_file"] = isFromFile; extra["pairs"] = gcorr->correspondences.size();
+		stage.done("correspond", c.result(), extra);
+	}
+
+	// Super graph and tasks
+	Scheduler * scheduler = new Scheduler;
+	TopoBlender * blender = new TopoBlender( gcorr, scheduler );
+	{
+		if( QFileInfo(job.scheduleFile).isFile() ) scheduler->loadSchedule( job.scheduleFile );
+		scheduler->setTimeStep( job.timeStep );
+		scheduler->isAdaptiveTimeStep = options.isAdaptive;
+		if( options.adaptiveTolerance > 0 ) scheduler->adaptiveTolerance = options.adaptiveTolerance;
+		stage.stop();
+
+		Checksum c;
+		c.addGraph( scheduler->activeGraph );
+		c.addGraph( scheduler->targetGraph );
+		ScheduleType schedule = scheduler->getSchedule();
+		foreach(QString nodeID, schedule.keys()) c.add( QString("%1 %2 %3").arg(nodeID).arg(schedule[nodeID].first).arg(schedule[nodeID].second) );
+
+		QVariantMap extra; extra["tasks"] = scheduler->tasks.size();
+		stage.done("topoblender", c.result(), extra);
+	}
+
+	// Synthesis data
+	SynthesisManager * s_manager = new SynthesisManager( gcorr, scheduler, blender, job.samplesCount );
+	{
+		s_manager->genSynData();
+		stage.stop();
+
+		Checksum c;
+		int totalSamples = 0;
+		foreach(QString graphName, s_manager->synthData.keys()){
+			foreach(QString nodeID, s_manager->synthData[graphName].keys()){
+				QMap<QString,QVariant> & data = s_manager->synthData[graphName][nodeID];
+				QVector<ParameterCoord> samples = data["samples"].value< QVector<ParameterCoord> >();
+				QVector<float> offsets = data["offsets"].value< QVector<float> >();
+
+				c.add( nodeID );
+				foreach(ParameterCoord s, samples){ c.add(s.u); c.add(s.v); c.add(s.theta); c.add(s.psi); }
+				foreach(float o, offsets) c.add(o);
+
+				totalSamples += samples.size();
+			}
+		}
+		QVariantMap extra; extra["samples_total"] = totalSamples;
+		stage.done("synthesis", c.result(), extra);
+	}
+
+	// Blend
+	{
+		scheduler->executeAll();
+		stage.stop();
+
+		Checksum c;
+		foreach(Structure::Graph * g, scheduler->allGraphs) c.addGraph( g );
+		// Frame count against the largest jump between frames, to compare uniform and adaptive stepping
+		QVariantMap extra;
+		extra["frames"] = scheduler->allGraphs.size();
+		extra["adaptive"] = scheduler->isAdaptiveTimeStep;
+		extra["max_frame_motion"] = maxFrameMotion( scheduler->allGraphs );
+		stage.done("execute", c.result(), extra);
+	}
+
+	// Graph copy throughput, on frames that carry the full property trees of a real blend
+	if( options.cloneCount > 0 && scheduler->allGraphs.size() )
+	{
+		QVector<Structure::Graph*> frames = scheduler->allGraphs;
+		QVector<Structure::Graph*> copies;
+		copies.reserve( frames.size() );
+		QElapsedTimer timer;
+
+		// Copies and frees are timed on their own, checksums are taken outside of the timed loops
+		qint64 heapNs = 0, arenaNs = 0, heapFreeNs = 0, arenaFreeNs = 0;
+		Checksum heapSum, arenaSum;
+
+		for(int r = 0; r < options.cloneCount; r++)
+		{
+			timer.start();
+			foreach(Structure::Graph * g, frames) copies.push_back( new Structure::Graph(*g) );
+			heapNs += timer.nsecsElapsed();
+
+			if(r == 0) foreach(Structure::Graph * g, copies) heapSum.addGraph( g );
+
+			timer.start();
+			qDeleteAll( copies ); copies.clear();
+			heapFreeNs += timer.nsecsElapsed();
+
+			timer.start();
+			foreach(Structure::Graph * g, frames) copies.push_back( g->cloneInArena() );
+			arenaNs += timer.nsecsElapsed();
+
+			if(r == 0) foreach(Structure::Graph * g, copies) arenaSum.addGraph( g );
+
+			timer.start();
+			qDeleteAll( copies ); copies.clear();
+			arenaFreeNs += timer.nsecsElapsed();
+		}
+
+		stage.stop();
+
+		int total = options.cloneCount * frames.size();
+		QVariantMap extra;
+		extra["clones"] = total;
+		extra["heap_clones_per_s"] = total / qMax(1e-9, heapNs * 1e-9);
+		extra["arena_clones_per_s"] = total / qMax(1e-9, arenaNs * 1e-9);
+		extra["heap_free_ms"] = heapFreeNs * 1e-6;
+		extra["arena_free_ms"] = arenaFreeNs * 1e-6;
+		extra["identical"] = (heapSum.result() == arenaSum.result());
+		stage.done("clone", arenaSum.result(), extra);
+	}
+
+	// Clustering of the frames, as used to pick in-betweens
+	if( options.clusterCount > 0 && scheduler->allGraphs.size() > 1 )
+	{
+		QVariantMap extra = compareClustering( scheduler->allGraphs, options.clusterCount, options.seed );
+		stage.stop();
+
+		Checksum c;
+		foreach(QString key, extra.keys()) if( !key.endsWith("_ms") && !key.startsWith("pam_") ) c.add( extra[key].toDouble() ); // old k-medoids seeds from the clock
+		stage.done("cluster", c.result(), extra);
+	}
+
+	// Reconstruct in-betweens
+	QStringList objFiles, thumbFiles;
+	if( job.renderCount > 0 && scheduler->allGraphs.size() )
+	{
+		QDir d( options.outputFolder );
+		d.mkpath( job.name );
+		QString prevPath = QDir::currentPath();
+		QDir::setCurrent( d.absolutePath() + "/" + job.name );
+
+		int N = scheduler->allGraphs.size();
+		int stepSize = qMax(1, N / job.renderCount);
+
+		for(int i = 0; i < N; i += stepSize)
+		{
+			QString filename = QString("output_%1").arg(i, 3, 10, QChar('0'));
+			s_manager->renderGraph( *(scheduler->allGraphs[i]), filename, false, job.reconLevel );
+
+			objFiles << QDir::currentPath() + "/" + filename + ".obj";
+			thumbFiles << QDir::currentPath() + "/" + filename + ".png";
+		}
+
+		QDir::setCurrent( prevPath );
+		stage.stop();
+
+		Checksum c;
+		foreach(QString f, objFiles) c.addFile( f );
+
+		QVariantMap extra; extra["meshes"] = objFiles.size();
+		stage.done("reconstruct", c.result(), extra);
+	}
+
+	// Thumbnails
+	if( options.isThumbnails && objFiles.size() )
+	{
+		int count = ThumbnailRenderer::renderFiles( objFiles, thumbFiles );
+		stage.stop();
+
+		Checksum c;
+		foreach(QString f, thumbFiles) c.addFile( f );
+		QVariantMap extra; extra["images"] = count;
+		stage.done("thumbnails", c.result(), extra);
+	}
+
+	report["total_ms"] = totalTimer.elapsed();
+	report["stages"] = stages;
+
+	delete s_manager;
+	delete blender;
+	delete scheduler;
+	delete gcorr;
+	delete sg;
+	delete tg;
+
+	return report;
+}
+
+int main(int argc, char *argv[])
+{
+	// No display server needed
+#ifdef Q_OS_LINUX
+	if( qgetenv("QT_QPA_PLATFORM").isEmpty() ) qputenv("QT_QPA_PLATFORM", "offscreen");
+#endif
+
+	QApplication a(argc, argv);
+
+	BatchOptions options;
+	QVector<BatchJob> jobs;
+	BatchJob pairJob;
+
+	QStringList args = a.arguments();
+	for(int i = 1; i < args.size(); i++)
+	{
+		QString arg = args[i];
+		QString value = (i + 1 < args.size()) ? args[i + 1] : QString();
+
+		if(arg == "--seed")				{ options.seed = value.toUInt(); i++; }
+		else if(arg == "--samples")		{ options.samplesCount = value.toInt(); i++; }
+		else if(arg == "--resolution")	{ options.gdResolution = value.toDouble(); i++; }
+		else if(arg == "--timestep")	{ options.timeStep = value.toDouble(); i++; }
+		else if(arg == "--recon")		{ options.reconLevel = value.toInt(); i++; }
+		else if(arg == "--renders")		{ options.renderCount = value.toInt(); i++; }
+		else if(arg == "--thumbs")		{ options.isThumbnails = true; }
+		else if(arg == "--remesh")		{ options.isRemesh = true; }
+		else if(arg == "--adaptive")	{ options.isAdaptive = true; }
+		else if(arg == "--tolerance")	{ options.adaptiveTolerance = value.toDouble(); i++; }
+		else if(arg == "--out")			{ options.outputFolder = value; i++; }
+		else if(arg == "--report")		{ options.reportFile = value; i++; }
+		else if(arg == "--trace")		{ options.traceFile = value; i++; }
+		else if(arg == "--clones")		{ options.cloneCount = value.toInt(); i++; }
+		else if(arg == "--cluster")		{ options.clusterCount = value.toInt(); i++; }
+		else if(arg == "--source")		{ pairJob.sourceFile = value; i++; }
+		else if(arg == "--target")		{ pairJob.targetFile = value; i++; }
+		else if(arg == "--corr")		{ pairJob.corrFile = value; i++; }
+		else if(arg == "--schedule")	{ pairJob.scheduleFile = value; i++; }
+		else if(QFileInfo(arg).isDir())
+		{
+			// Benchmark suite: every job file under the folder, in a fixed order
+			QStringList found;
+			QDirIterator it(arg, QStringList() << "*.job", QDir::Files, QDirIterator::Subdirectories);
+			while(it.hasNext()) found << it.next();
+			found.sort();
+
+			foreach(QString f, found){
+				BatchJob job;
+				if(job.load(f)) jobs << job;
+			}
+		}
+		else
+		{
+			BatchJob job;
+			if(job.load(arg)) jobs << job;
+			else qDebug() << "Could not read job file" << arg;
+		}
+	}
+
+	if( !pairJob.sourceFile.isEmpty() && !pairJob.targetFile.isEmpty() )
+	{
+		pairJob.name = QFileInfo(pairJob.sourceFile).baseName() + "_" + QFileInfo(pairJob.targetFile).baseName();
+		jobs << pairJob;
+	}
+
+	if( jobs.isEmpty() )
+	{
+		qDebug() << "Usage: blend-batch [options] <job file | folder> ... or --source a.xml --target b.xml";
+		return 1;
+	}
+
+	QDir().mkpath( options.outputFolder );
+	if( options.reportFile.isEmpty() ) options.reportFile = options.outputFolder + "/report.json";
+
+	if( !options.traceFile.isEmpty() ) Trace::setEnabled( true );
+
+	QVariantList results;
+	foreach(BatchJob job, jobs) results << runJob( job, options );
+
+	if( !options.traceFile.isEmpty() ) Trace::save( options.traceFile );
+
+	QVariantMap report;
+	report["threads"] = omp_get_max_threads();
+	report["jobs"] = results;
+	report["peak_rss_kb"] = peakMemoryKB();
+
+	QFile file( options.reportFile );
+	if( !file.open(QIODevice::WriteOnly | QIODevice::Text) ) return 1;
+	file.write( QtJson::serialize( report ) );
+	file.close();
+
+	qDebug() << "Report written to" << options.reportFile;
+
+	return 0;
+}
@@ -76,7 +76,6 @@ void BlendPathSubButton::mousePressEvent( QGraphicsSceneMouseEvent * event )
 
 	BlendPathRenderer * renderer = blender->renderer;
 	Scheduler * scheduler = blender->blendPaths[pathIDX].scheduler.data();
-	int N = scheduler->allGraphs.size();
 
 	int count = 2;
 
@@ -118,7 +117,7 @@ void BlendPathSubButton::mousePressEvent( QGraphicsSceneMouseEvent * event )
 	for(int i = 0; i < count; i++)
 	{
 		double t = start + (step * (i+1));
-		Structure::Graph * g = scheduler->allGraphs[qMin(N-1, int(t * N))];
+		Structure::Graph * g = scheduler->allGraphs[ scheduler->frameIndexAt(t) ];
 
 		g->moveCenterTo( AlphaBlend(g->property["t"].toDouble(), 
 									g->property["sourceGraphCenter"].value<Vector3>(), 
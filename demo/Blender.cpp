@@ -10,9 +10,10 @@
 #include "Scheduler.h"
 #include "Task.h"
 #include "SynthesisManager.h"
-#include "ShapeRenderer.h"
+#include "ThumbnailRenderer.h"
 #include "SchedulerWidget.h"
 #include "PathEvaluator.h"
+#include "Tracing.h"
 
 typedef QVector< QSet<size_t> > ForcedGroups;
 Q_DECLARE_METATYPE( ForcedGroups )
@@ -372,6 +373,8 @@ void Blender::synthDataReady()
 
 void executeJob( const QSharedPointer<Scheduler> & scheduler )
 {
+	TRACE_ZONE("Blender::executeJob");
+
 #ifdef QT_DEBUG
 	scheduler->timeStep = 0.3;
 #endif
@@ -538,7 +541,7 @@ void Blender::keyReleased( QKeyEvent* keyEvent )
 			if(!renderItem) continue;
 
 			QString filename = QString("testRender_%1.obj").arg(renderItem->property["pathID"].toInt());
-			s_manager->renderGraph(*renderItem->graph(), filename, false, 6, true);
+			s_manager->renderGraph(*renderItem->graph(), filename, false, 6, true, true, PREVIEW_POINTS_LIMIT);
 		}
 	}
 
@@ -550,7 +553,7 @@ void Blender::keyReleased( QKeyEvent* keyEvent )
 			for(int j = 0; j < numInBetweens; j++)
 			{
 				QString filename = QString("inbetween_%1_%2.obj").arg( i ).arg( j );
-				s_manager->renderGraph(*resultItems[i][j]->graph(), filename, false, 6, true, false);
+				s_manager->renderGraph(*resultItems[i][j]->graph(), filename, false, 6, true, false, PREVIEW_POINTS_LIMIT);
 			}
 		}
 	}
@@ -763,7 +766,7 @@ void Blender::exportSelected()
 		// Generate thumbnail
 		QString objFile = d.absolutePath() + "/" + filename + "/" + filename + ".obj";
 		QString thumbnailFile = d.absolutePath() + "/" + filename + "/" + filename + ".png";
-		ShapeRenderer::render( objFile ).save( thumbnailFile );
+		ThumbnailRenderer::renderFile( objFile ).save( thumbnailFile );
 
 		// Send to gallery
 		PropertyMap info;
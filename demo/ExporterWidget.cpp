@@ -5,7 +5,7 @@
 #include "SynthesisManager.h"
 #include "BlendRenderItem.h"
 #include "StructureGraph.h"
-#include "ShapeRenderer.h"
+#include "ThumbnailRenderer.h"
 
 #include "HttpUploader.h"
 
@@ -199,13 +199,14 @@ void ExporterWidget::exportSet()
 		s_manager->renderGraph(*g, filename, false, reconLevel, true, !ui->isSimplify->isChecked());
 
 		// Change camera location if requested
-		GLVertex camDelta(0,0,0);
-		if( ui->isMoveCamera->isChecked() ) camDelta = GLVertex( ui->moveCamX->value(), ui->moveCamY->value(), ui->moveCamZ->value() );
+		ThumbnailRenderer::Settings thumbSettings;
+		thumbSettings.isFlatShading = true;
+		if( ui->isMoveCamera->isChecked() ) thumbSettings.cameraDelta = Eigen::Vector3d( ui->moveCamX->value(), ui->moveCamY->value(), ui->moveCamZ->value() );
 
 		// Generate thumbnail
 		QString objFile = QDir::currentPath() + "/" + filename + ".obj";
 		QString thumbnailFile = QDir::currentPath() + "/" + filename + ".png";
-		ShapeRenderer::render( objFile, true, camDelta ).save( thumbnailFile );
+		ThumbnailRenderer::renderFile( objFile, thumbSettings ).save( thumbnailFile );
 
 		// Output schedule for this in-between
 		ScheduleType schedule = g->property["schedule"].value<ScheduleType>();
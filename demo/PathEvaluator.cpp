@@ -8,6 +8,7 @@
 #include "json.h"
 
 #include "ScorerManager.h"
+#include "Tracing.h"
 
 #include "GraphDissimilarity.h"
 #include "ExportDynamicGraph.h"
@@ -82,6 +83,7 @@ void PathEvaluator::test_filtering()
 		s.executeAll();
 
 		// Compute its score
+		TRACE_ZONE("ScorerManager::pathScore");
 		ps[i] = r_manager.pathScore( s.allGraphs );
 
 		QVector<QColor> colors;
@@ -481,6 +483,8 @@ void PathEvaluator::test_topoDistinct()
 
 void PathEvaluator::evaluateFilter( QVector<Structure::Graph*> allGraphs )
 {
+	TRACE_ZONE("PathEvaluator::evaluateFilter");
+
 	QVector<Structure::Graph*> inputGraphs;
 	inputGraphs << b->s->inputGraphs[0]->g << b->s->inputGraphs[1]->g;
 
@@ -495,6 +499,8 @@ void PathEvaluator::evaluateFilter( QVector<Structure::Graph*> allGraphs )
 
 QVector<ScheduleType> PathEvaluator::filteredSchedules( QVector<ScheduleType> randomSchedules )
 {
+	TRACE_ZONE("PathEvaluator::filteredSchedules");
+
 	QVector<ScheduleType> sorted;
 
 	int numSamplesPerPath = 25;
@@ -520,6 +526,8 @@ QVector<ScheduleType> PathEvaluator::filteredSchedules( QVector<ScheduleType> ra
 	#pragma omp parallel for
 	for(int i = 0; i < numPaths; i++)
 	{
+		TRACE_ZONE("PathEvaluator::path");
+
 		// Setup schedule
 		Scheduler s( *b->m_scheduler );
 		s.setSchedule( randomSchedules[i] );
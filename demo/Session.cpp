@@ -52,7 +52,8 @@ void Session::shapeChanged(int i, QGraphicsItem * shapeItem)
 
     QString graphFile = item->property["graph"].toString();
 
-    s->inputGraphs[i] = new GraphItem(new Structure::Graph(graphFile), s->graphRect(i), s->camera);
+    // Part meshes are read when the shape is first drawn
+    s->inputGraphs[i] = new GraphItem(new Structure::Graph(graphFile, true), s->graphRect(i), s->camera);
 	s->inputGraphs[i]->name = item->property["name"].toString();
     s->addItem(s->inputGraphs[i]);
     Structure::Graph * graph = s->inputGraphs[i]->g;
@@ -6,6 +6,7 @@ using namespace SurfaceMesh;
 
 #include "GlSplat/GLee.h"
 #include "ShapeRenderer.h"
+#include "ObjReader.h"
 #include "qglviewer/camera.h"
 
 Q_DECLARE_METATYPE(qglviewer::Vec)
@@ -29,7 +30,8 @@ ShapeRenderer::ShapeRenderer(QString filename, QColor color, bool isFlatShading,
 
     // Read mesh file
 	SurfaceMeshModel mesh;
-	mesh.read(qPrintable(filename));
+	if( !ObjReader::isObj(filename) || !ObjReader::read(&mesh, filename) )
+		mesh.read(qPrintable(filename));
 	mesh.update_face_normals();
 	mesh.update_vertex_normals();
 
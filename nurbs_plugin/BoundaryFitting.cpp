@@ -407,12 +407,6 @@ std::vector< std::vector<Vector3d> > BoundaryFitting::geodesicPaths( std::vector
 	part->update_face_normals();
 	Vector3FaceProperty fnormal = part->get_face_property<Vector3>(FNORMAL);
 
-	// for geodesic computation
-	QVector<Vertex> vertVector;
-	QSet<Vertex> vertSet; 
-	foreach(Vector3d p, toPoints) vertVector.push_back(Vertex(tree.closest(p)));
-	foreach(Vertex v, vertVector) vertSet.insert(v);
-
 	// for actual segments
 	if(segments > 0)
 	{
@@ -420,11 +414,30 @@ std::vector< std::vector<Vector3d> > BoundaryFitting::geodesicPaths( std::vector
 		toPoints = equidistLine(toPoints, segments);
 	}
 
-	for(int sid = 0; sid < (int)fromPoints.size(); sid++)
+	int numPaths = fromPoints.size();
+
+	// Geodesic operators are factored once per part, every segment is then back substitution only
+	if( !geodesics ) geodesics = QSharedPointer<HeatGeodesics>( new HeatGeodesics(part, 50.0) );
+
+	std::vector<Vertex> endVertices( numPaths );
+	for(int sid = 0; sid < numPaths; sid++) endVertices[sid] = Vertex( tree.closest(toPoints[sid]) );
+
+	// Single source distances and face directions toward them, independent per segment
+	std::vector<Eigen::VectorXd> dists( numPaths );
+	std::vector< std::vector<Vector3> > directions( numPaths );
+
+	#pragma omp parallel for schedule(dynamic)
+	for(int sid = 0; sid < numPaths; sid++)
+	{
+		geodesics->distance( std::vector<int>(1, endVertices[sid].idx()), dists[sid] );
+		geodesics->faceGradient( dists[sid], directions[sid], true );
+	}
+
+	for(int sid = 0; sid < numPaths; sid++)
 	{
 		std::vector<Vector3d> path;
 
-		Vertex endVertex( tree.closest(toPoints[sid]) );
+		Vertex endVertex = endVertices[sid];
 
 		// Start with a good face
 		Vector3 fromPoint = fromPoints[sid];
@@ -434,12 +447,7 @@ std::vector< std::vector<Vector3d> > BoundaryFitting::geodesicPaths( std::vector
 		Vector3 toPoint = toPoints[sid];
 		Face endFace = getBestFace(toPoint, endVertex);
 
-		// Single source
-		QSet<Vertex> mySet; mySet.insert( endVertex );
-		GeoHeatHelper geoDist(part);
-		geoDist.t_factor *= 50;
-		ScalarVertexProperty d = geoDist.getUniformDistance( mySet );
-		gradientFaces(d, false, true);
+		const std::vector<Vector3> & fdirection = directions[sid];
 
 		// Avoid spiraling paths
 		if(part->has_edge_property<bool>("e:visited")) 
@@ -462,7 +470,7 @@ std::vector< std::vector<Vector3d> > BoundaryFitting::geodesicPaths( std::vector
 		while( true )
 		{
 			Vector3 prevPoint = path.back();
-			Vector3 direction = fgradient[prevF];
+			Vector3 direction = fdirection[prevF.idx()];
 
 			// Hack: to smooth out path ends..
 			//if(isConstant) 
@@ -504,7 +512,7 @@ std::vector< std::vector<Vector3d> > BoundaryFitting::geodesicPaths( std::vector
 			if( evisited[part->edge(bestEdge)] )
 			{
 				// Get approximate path via vertices and jump ahead
-				std::vector<Vertex> curPath = geoDist.shortestVertexPath(Vertex(tree.closest(prevPoint)));
+				std::vector<Vertex> curPath = geodesics->shortestVertexPath(dists[sid], Vertex(tree.closest(prevPoint)));
 				int idx = 0.9 * curPath.size();
 				Vertex skipVert = curPath[idx];
 				f = getBestFace(points[skipVert], skipVert);
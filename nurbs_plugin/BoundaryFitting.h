@@ -1,7 +1,9 @@
 #pragma once
 
+#include <QSharedPointer>
 #include "SurfaceMeshModel.h"
 #include "FaceBarycenterHelper.h"
+#include "HeatGeodesics.h"
 
 #include "NanoKdTree.h"
 #include "../CustomDrawObjects.h"
@@ -48,6 +50,9 @@ struct BoundaryFitting{
 
 	NanoKdTree tree;
 
+	// Heat method operators of the part, factored on first use
+	QSharedPointer<HeatGeodesics> geodesics;
+
 	// output
 	std::vector< std::vector<Vector3d> > lines;
 
@@ -0,0 +1,199 @@
+#pragma once
+
+#include "SurfaceMeshModel.h"
+
+using namespace SurfaceMesh;
+
+#include <Eigen/Core>
+#include <Eigen/Sparse>
+#include <vector>
+#include <cfloat>
+
+// Geodesics in heat (Crane et al. 2013) with both linear systems factored once per mesh.
+// A distance query is then two back substitutions, so queries can run in parallel
+struct HeatGeodesics
+{
+	HeatGeodesics( SurfaceMesh::Model * useMesh, double t_factor = 1.0 ) : mesh(useMesh)
+	{
+		Vector3VertexProperty points = mesh->vertex_property<Vector3>(VPOINT);
+
+		int nv = mesh->n_vertices(), nf = mesh->n_faces();
+
+		fnormal.resize(nf, Vector3(0,0,0));
+		farea.resize(nf, 0.0);
+		corners.resize(nf * 3, 0);
+		cotan.resize(nf * 3, 0.0);
+
+		std::vector<double> varea(nv, 0.0);
+		std::vector< Eigen::Triplet<double> > L;
+
+		double sumLength = 0;
+		int countLength = 0;
+
+		foreach(Face f, mesh->faces())
+		{
+			// Assume triangular
+			int fi = f.idx(), k = 0;
+			Surface_mesh::Vertex_around_face_circulator vit = mesh->vertices(f), vend = vit;
+			do{ if(k < 3) corners[fi * 3 + k] = Vertex(vit).idx(); k++; } while(++vit != vend);
+
+			Vector3 p[3];
+			for(int i = 0; i < 3; i++) p[i] = points[Vertex(corners[fi * 3 + i])];
+
+			Vector3 n = cross(p[1] - p[0], p[2] - p[0]);
+			double doubleArea = n.norm();
+			if(doubleArea < 1e-30) continue;
+
+			fnormal[fi] = n / doubleArea;
+			farea[fi] = 0.5 * doubleArea;
+
+			for(int i = 0; i < 3; i++)
+			{
+				int j = (i + 1) % 3, l = (i + 2) % 3;
+
+				// Cotangent of the angle at corner i, weights the opposite edge j-l
+				Vector3 a = p[j] - p[i], b = p[l] - p[i];
+				double c = dot(a, b) / doubleArea;
+				cotan[fi * 3 + i] = c;
+
+				int vj = corners[fi * 3 + j], vl = corners[fi * 3 + l];
+				L.push_back( Eigen::Triplet<double>(vj, vl, -0.5 * c) );
+				L.push_back( Eigen::Triplet<double>(vl, vj, -0.5 * c) );
+				L.push_back( Eigen::Triplet<double>(vj, vj, 0.5 * c) );
+				L.push_back( Eigen::Triplet<double>(vl, vl, 0.5 * c) );
+
+				varea[corners[fi * 3 + i]] += farea[fi] / 3.0;
+
+				sumLength += (p[j] - p[i]).norm();
+				countLength++;
+			}
+		}
+
+		// Time step from the mean edge length
+		double h = countLength ? sumLength / countLength : 1.0;
+		double t = t_factor * h * h;
+
+		// Positive semi-definite cotangent Laplacian and lumped mass
+		Eigen::SparseMatrix<double> Lc(nv, nv), M(nv, nv);
+		Lc.setFromTriplets(L.begin(), L.end());
+
+		std::vector< Eigen::Triplet<double> > mass;
+		for(int i = 0; i < nv; i++) mass.push_back( Eigen::Triplet<double>(i, i, varea[i]) );
+		M.setFromTriplets(mass.begin(), mass.end());
+
+		// Heat flow, and Poisson with a tiny mass term for the constant null space
+		Eigen::SparseMatrix<double> A = M + t * Lc;
+		Eigen::SparseMatrix<double> B = Lc + 1e-8 * M;
+
+		heatSolver.compute(A);
+		poissonSolver.compute(B);
+
+		isReady = (heatSolver.info() == Eigen::Success) && (poissonSolver.info() == Eigen::Success);
+	}
+
+	/// Gradient of a vertex function on every face
+	void faceGradient( const Eigen::VectorXd & u, std::vector<Vector3> & grad, bool isNormalizeNegate = false ) const
+	{
+		int nf = farea.size();
+		grad.resize(nf);
+
+		Vector3VertexProperty points = mesh->get_vertex_property<Vector3>(VPOINT);
+
+		for(int fi = 0; fi < nf; fi++)
+		{
+			grad[fi] = Vector3(0,0,0);
+			if(farea[fi] <= 0) continue;
+
+			Vector3 vsum(0,0,0);
+			for(int i = 0; i < 3; i++)
+			{
+				// Edge opposite to corner i, counter clockwise
+				Vector3 e = points[Vertex(corners[fi * 3 + (i + 2) % 3])] - points[Vertex(corners[fi * 3 + (i + 1) % 3])];
+				vsum += u[corners[fi * 3 + i]] * cross(fnormal[fi], e);
+			}
+
+			grad[fi] = vsum / (2.0 * farea[fi]);
+
+			if(isNormalizeNegate)
+				grad[fi] = (-grad[fi]).normalized();
+		}
+	}
+
+	/// Distances to a set of source vertices, zero at the closest source
+	void distance( const std::vector<int> & sources, Eigen::VectorXd & dist ) const
+	{
+		int nv = mesh->n_vertices(), nf = farea.size();
+
+		dist = Eigen::VectorXd::Zero(nv);
+		if(!isReady || sources.empty()) return;
+
+		// Short heat flow from the sources
+		Eigen::VectorXd delta = Eigen::VectorXd::Zero(nv);
+		for(int i = 0; i < (int)sources.size(); i++) delta[sources[i]] = 1.0;
+		Eigen::VectorXd u = heatSolver.solve(delta);
+
+		// Normalized negated gradient of the heat, then its divergence
+		std::vector<Vector3> X;
+		faceGradient(u, X, true);
+
+		Vector3VertexProperty points = mesh->get_vertex_property<Vector3>(VPOINT);
+
+		Eigen::VectorXd div = Eigen::VectorXd::Zero(nv);
+		for(int fi = 0; fi < nf; fi++)
+		{
+			if(farea[fi] <= 0) continue;
+
+			for(int i = 0; i < 3; i++)
+			{
+				int vi = corners[fi * 3 + i], vj = corners[fi * 3 + (i + 1) % 3], vl = corners[fi * 3 + (i + 2) % 3];
+				Vector3 e1 = points[Vertex(vj)] - points[Vertex(vi)];
+				Vector3 e2 = points[Vertex(vl)] - points[Vertex(vi)];
+
+				// Cotangents of the angles facing e1 (at l) and e2 (at j)
+				double cot1 = cotan[fi * 3 + (i + 2) % 3], cot2 = cotan[fi * 3 + (i + 1) % 3];
+				div[vi] += 0.5 * (cot1 * dot(e1, X[fi]) + cot2 * dot(e2, X[fi]));
+			}
+		}
+
+		// Recover distance, with the sign of our positive Laplacian
+		dist = poissonSolver.solve(-div);
+
+		double minDist = DBL_MAX;
+		for(int i = 0; i < (int)sources.size(); i++) minDist = qMin(minDist, dist[sources[i]]);
+		dist.array() -= minDist;
+	}
+
+	/// Vertex path that walks down the distance field to its source
+	std::vector<Vertex> shortestVertexPath( const Eigen::VectorXd & dist, Vertex from ) const
+	{
+		std::vector<Vertex> path;
+		path.push_back(from);
+
+		while( true )
+		{
+			Vertex cur = path.back(), best = cur;
+
+			foreach(Halfedge h, mesh->onering_hedges(cur))
+			{
+				Vertex v = mesh->to_vertex(h);
+				if(dist[v.idx()] < dist[best.idx()]) best = v;
+			}
+
+			if(best == cur) break;
+			path.push_back(best);
+		}
+
+		return path;
+	}
+
+	SurfaceMesh::Model * mesh;
+	bool isReady;
+
+	// Per face geometry
+	std::vector<Vector3> fnormal;
+	std::vector<double> farea;
+	std::vector<int> corners;
+	std::vector<double> cotan;
+
+	Eigen::SimplicialLDLT< Eigen::SparseMatrix<double> > heatSolver, poissonSolver;
+};
@@ -33,7 +33,8 @@ HEADERS +=  nurbs_plugin.h \
             OBB_Volume.h \
             PCA3.h \
             LSCM.h \
-            BoundaryFitting.h
+            BoundaryFitting.h \
+            HeatGeodesics.h
 
 SOURCES +=  nurbs_plugin.cpp \
             nurbstools.cpp \
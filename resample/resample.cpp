@@ -63,13 +63,16 @@ void myresample::doResample()
     foreach(Vector3d p, samples)
         myfile << p[0] << " " << p[1] << " " << p[2] << "\n";
     myfile.close();
+}
 
-	/// MLS - test
-	/*Surface_mesh::Vertex_property<Vector3> points = mesh()->vertex_property<Vector3>(VPOINT);
-	Surface_mesh::Vertex_property<Vector3> normals = mesh()->vertex_property<Vector3>(VNORMAL, Vector3(0,0,0));
+void myresample::doProject()
+{
+	// Smooth the mesh by projecting its vertices onto the RIMLS surface of its own points
+	mesh()->update_face_normals();
+	mesh()->update_vertex_normals();
 
-	Surface_mesh::Vertex_property<Vector3> new_points = mesh()->vertex_property<Vector3>("v:projected", Vector3(0,0,0));
-	Surface_mesh::Vertex_property<Vector3> new_normals = mesh()->vertex_property<Vector3>("v:projected", Vector3(0,0,0));
+	Vector3VertexProperty points = mesh()->vertex_property<Vector3>(VPOINT);
+	Vector3VertexProperty normals = mesh()->vertex_property<Vector3>(VNORMAL);
 
 	RmlsSurface mls( mesh() );
 
@@ -85,15 +88,30 @@ void myresample::doResample()
 	mls.setMaxRefittingIters( MaxRefittingIters );
 	mls.setSigmaN( SigmaN );
 
+	// Project all vertices in parallel, the surface reads the original points until all are done
+	std::vector<Vector3> original, projected, projectedNormals;
+	foreach(Vertex v, mesh()->vertices()) original.push_back(points[v]);
+
+	std::vector<int> errors;
+	mls.project(original, projected, projectedNormals, &errors);
+
+	// Points outside of the surface's domain keep their position
+	int numFailed = 0;
 	foreach(Vertex v, mesh()->vertices())
 	{
-		new_points[v] = mls.project(points[v], new_normals[v]);
+		if(errors[v.idx()] == RmlsSurface::MLS_TOO_FAR){
+			numFailed++;
+			continue;
+		}
+
+		points[v] = projected[v.idx()];
+		normals[v] = projectedNormals[v.idx()];
 	}
 
-	foreach(Vertex v, mesh()->vertices())
-	{
-		points[v] = new_points[v];
-    }*/
+	mainWindow()->setStatusBarMessage( QString("MLS projection: %1 of %2 vertices outside the surface").arg(numFailed).arg(mesh()->n_vertices()) );
+
+	mesh()->update_face_normals();
+	drawArea()->updateGL();
 }
 
 void myresample::doParameterize()
@@ -13,6 +13,7 @@ ResampleWidget::ResampleWidget(myresample *resampler, QWidget *parent): QDialog(
 
     connect(ui->resampleButton, SIGNAL(clicked()), (const QObject*) resampler, SLOT(doResample()));
     connect(ui->parameterizeButton, SIGNAL(clicked()), (const QObject*) resampler, SLOT(doParameterize()));
+    connect(ui->projectButton, SIGNAL(clicked()), (const QObject*) resampler, SLOT(doProject()));
 }
 
 ResampleWidget::~ResampleWidget()
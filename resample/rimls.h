@@ -16,22 +16,46 @@ using namespace Eigen;
 #define E2V(vec) (Vec3d(vec[0], vec[1], vec[2]))
 #endif
 
+// Scratch of a single query: neighborhood, kernel weights and the fitted values.
+// Queries only read the surface, so each thread projects with its own workspace
+struct RmlsWorkspace
+{
+	RmlsWorkspace() : isValid(false) {}
+
+	bool isValid;
+	Vector3 queryPoint;
+
+	KDResults neighborhood;
+	std::vector<Scalar> weights;
+	std::vector<Scalar> weightDerivatives;
+	std::vector<Vector3> weightGradients;
+	std::vector<Scalar> weightSecondDerivatives;
+	std::vector<Scalar> refittingWeights;
+
+	Vector3 gradient;
+	Scalar potential;
+
+	Scalar sumW;
+	Vector3 sumN;
+	Vector3 sumGradWeight;
+	Vector3 sumGradPotential;
+};
+
 class RmlsSurface
 {
 	typedef Matrix3d MatrixType;
 
+	Vector3VertexProperty points, normals;
+	ScalarVertexProperty radii;
+
+public:
 	enum {
 		MLS_OK,	MLS_TOO_FAR, MLS_TOO_MANY_ITERS, MLS_NOT_SUPPORTED,
 		MLS_DERIVATIVE_ACCURATE, MLS_DERIVATIVE_APPROX, MLS_DERIVATIVE_FINITEDIFF
 	};
 
-	Vector3VertexProperty points, normals;
-	ScalarVertexProperty radii;
-
-public:
 	RmlsSurface(SurfaceMeshModel * mMesh) : mesh(mMesh)
 	{
-		mCachedQueryPointIsOK = false;
 		mBallTree = 0;
 
 		points = mesh->vertex_property<Vector3>(VPOINT);
@@ -40,7 +64,7 @@ public:
 
 		mAABB = mesh->bbox();
 
-		// Add original mesh points to KD-tree
+		// Add original mesh points to KD-tree, it is only read from here on
 		mBallTree = new NanoKdTree;
 		foreach(Vertex v, mesh->vertices()) mBallTree->addPoint( points[v] );
 		mBallTree->build();
@@ -74,11 +98,11 @@ public:
 	static const Scalar InvalidValue() { return Scalar(12345679810.11121314151617); }
 
 	/** \returns the value of the reconstructed scalar field at point \a x */
-	Scalar potential(const Vector3& x, int* errorMask = 0)
+	Scalar potential(const Vector3& x, RmlsWorkspace & ws, int* errorMask = 0) const
 	{
-		if ((!mCachedQueryPointIsOK) || mCachedQueryPoint!=x)
+		if ((!ws.isValid) || ws.queryPoint!=x)
 		{
-			if (!computePotentialAndGradient(x))
+			if (!computePotentialAndGradient(x, ws))
 			{
 				if (errorMask)
 					*errorMask = MLS_TOO_FAR;
@@ -86,18 +110,24 @@ public:
 			}
 		}
 
-		return mCachedPotential;
+		return ws.potential;
+	}
+
+	Scalar potential(const Vector3& x, int* errorMask = 0) const
+	{
+		RmlsWorkspace ws;
+		return potential(x, ws, errorMask);
 	}
 
 	/** \returns the gradient of the reconstructed scalar field at point \a x
 	*
 	* The method used to compute the gradient can be controlled with setGradientHint().
 	*/
-	Vector3 gradient(const Vector3& x, int* errorMask = 0)
+	Vector3 gradient(const Vector3& x, RmlsWorkspace & ws, int* errorMask = 0) const
 	{
-		if ((!mCachedQueryPointIsOK) || mCachedQueryPoint!=x)
+		if ((!ws.isValid) || ws.queryPoint!=x)
 		{
-			if (!computePotentialAndGradient(x))
+			if (!computePotentialAndGradient(x, ws))
 			{
 				if (errorMask)
 					*errorMask = MLS_TOO_FAR;
@@ -105,17 +135,23 @@ public:
 			}
 		}
 
-		return mCachedGradient;
+		return ws.gradient;
+	}
+
+	Vector3 gradient(const Vector3& x, int* errorMask = 0) const
+	{
+		RmlsWorkspace ws;
+		return gradient(x, ws, errorMask);
 	}
 
 	/** \returns the hessian matrix of the reconstructed scalar field at point \a x
 	*
 	* The method used to compute the hessian matrix can be controlled with setHessianHint().
 	*/
-	MatrixType hessian(const Vector3& x, int* errorMask = 0)
+	MatrixType hessian(const Vector3& x, RmlsWorkspace & ws, int* errorMask = 0) const
 	{
-		if ((!mCachedQueryPointIsOK) || mCachedQueryPoint!=x){
-			if (!computePotentialAndGradient(x)){
+		if ((!ws.isValid) || ws.queryPoint!=x){
+			if (!computePotentialAndGradient(x, ws)){
 				if (errorMask)
 					*errorMask = MLS_TOO_FAR;
 				return MatrixType();
@@ -123,19 +159,30 @@ public:
 		}
 
 		MatrixType hessian;
-		mlsHessian(x, hessian);
+		mlsHessian(x, ws, hessian);
 		return hessian;
 	}
 
+	MatrixType hessian(const Vector3& x, int* errorMask = 0) const
+	{
+		RmlsWorkspace ws;
+		return hessian(x, ws, errorMask);
+	}
 
 	/** \returns the projection of point x onto the MLS surface, and optionally returns the normal in \a pNormal */
-    Vector3 project(const Vector3& x)
+    Vector3 project(const Vector3& x) const
     {
         Vector3 pNormal(0);
         return project(x, pNormal);
     }
 
-    Vector3 project(const Vector3& x, Vector3 & pNormal, int* errorMask = 0)
+    Vector3 project(const Vector3& x, Vector3 & pNormal, int* errorMask = 0) const
+	{
+		RmlsWorkspace ws;
+		return project(x, pNormal, ws, errorMask);
+	}
+
+    Vector3 project(const Vector3& x, Vector3 & pNormal, RmlsWorkspace & ws, int* errorMask = 0) const
 	{
 		int iterationCount = 0;
 		Vector3 position = x;
@@ -143,15 +190,15 @@ public:
 		Scalar delta;
 		Scalar epsilon = mAveragePointSpacing * mProjectionAccuracy;
 		do {
-			if (!computePotentialAndGradient(position))
+			if (!computePotentialAndGradient(position, ws))
 			{
 				if (errorMask) *errorMask = MLS_TOO_FAR;
 				return x;
 			}
 
-			normal = mCachedGradient;
+			normal = ws.gradient;
 			normal.normalize();
-			delta = mCachedPotential;
+			delta = ws.potential;
 			position = position - normal*delta;
 		} while ( abs(delta) > epsilon && ++iterationCount < mMaxNofProjectionIterations);
 
@@ -163,14 +210,36 @@ public:
 		return position;
 	}
 
+	/** projects a batch of points in parallel, each thread with its own workspace.
+	*	Points that fail to project are returned unchanged, optional \a errorMasks gets their codes */
+	void project(const std::vector<Vector3>& x, std::vector<Vector3>& projected, std::vector<Vector3>& pNormals,
+		std::vector<int>* errorMasks = 0) const
+	{
+		int n = x.size();
+
+		projected.resize(n);
+		pNormals.resize(n, Vector3(0,0,0));
+		if (errorMasks) errorMasks->assign(n, MLS_OK);
+
+		#pragma omp parallel
+		{
+			RmlsWorkspace ws;
+
+			#pragma omp for schedule(dynamic, 64)
+			for (int i = 0; i < n; i++)
+			{
+				projected[i] = project(x[i], pNormals[i], ws, errorMasks ? &(*errorMasks)[i] : 0);
+			}
+		}
+	}
 
 	/** \returns whether \a x is inside the restricted surface definition domain */
-	bool isInDomain(const Vector3& x)
+	bool isInDomain(const Vector3& x, RmlsWorkspace & ws) const
 	{
-		if ((!mCachedQueryPointIsOK) || mCachedQueryPoint!=x){
-			computeNeighborhood(x, false);
+		if ((!ws.isValid) || ws.queryPoint!=x){
+			computeNeighborhood(x, ws, false);
 		}
-		int nb = mNeighborhood.size();
+		int nb = ws.neighborhood.size();
 		if (nb < mDomainMinNofNeighbors)
 			return false;
 
@@ -179,10 +248,10 @@ public:
 		bool hasNormal = true;
 		if ((mDomainNormalScale == 1.0) || (!hasNormal)){
 			while (out && i<nb){
-				int id = mNeighborhood[i].first;
+				int id = ws.neighborhood[i].first;
 				Scalar rs2 = radii[Vertex(id)] * mDomainRadiusScale;
 				rs2 = rs2*rs2;
-				out = pow(mNeighborhood[i].second, 2) > rs2;
+				out = pow(ws.neighborhood[i].second, 2) > rs2;
 				++i;
 			}
 		}
@@ -190,18 +259,24 @@ public:
 		{
 			Scalar s = 1./(mDomainNormalScale*mDomainNormalScale) - 1.f;
 			while (out && i<nb){
-				int id = mNeighborhood[i].first;
+				int id = ws.neighborhood[i].first;
 				Vertex v(id);
 				Scalar rs2 = radii[v] * mDomainRadiusScale;
 				rs2 = rs2*rs2;
 				Scalar dn = dot(normals[v], Vector3(x - points[v]));
-				out = (pow(mNeighborhood[i].second, 2) + s*dn*dn) > rs2;
+				out = (pow(ws.neighborhood[i].second, 2) + s*dn*dn) > rs2;
 				++i;
 			}
 		}
 		return !out;
 	}
 
+	bool isInDomain(const Vector3& x) const
+	{
+		RmlsWorkspace ws;
+		return isInDomain(x, ws);
+	}
+
 	/** \returns the mean curvature from the gradient vector and Hessian matrix.
 	*/
 	Scalar meanCurvature(const Vector3& gradient, const MatrixType& hessian) const
@@ -215,21 +290,18 @@ public:
 	void setFilterScale(Scalar v)
 	{
 		mFilterScale = v;
-		mCachedQueryPointIsOK = false;
 	}
 
 	/** set the maximum number of iterations during the projection */
 	void setMaxProjectionIters(int n)
 	{
 		mMaxNofProjectionIterations = n;
-		mCachedQueryPointIsOK = false;
 	}
 
 	/** set the threshold factor to detect convergence of the iterations */
 	void setProjectionAccuracy(Scalar v)
 	{
 		mProjectionAccuracy = v;
-		mCachedQueryPointIsOK = false;
 	}
 
 	/** set a hint on how to compute the gradient
@@ -239,7 +311,6 @@ public:
 	void setGradientHint(int h)
 	{
 		mGradientHint = h;
-		mCachedQueryPointIsOK = false;
 	}
 
 	/** set a hint on how to compute the hessian matrix
@@ -249,24 +320,26 @@ public:
 	void setHessianHint(int h)
 	{
 		mHessianHint = h;
-		mCachedQueryPointIsOK = false;
 	}
 
 	const Eigen::AlignedBox3d& boundingBox() const { return mAABB; }
 
 	void computeVertexRaddi(const int nbNeighbors = 16)
 	{
-		mAveragePointSpacing = 0;
+		int nv = mesh->n_vertices();
+		Scalar sumRadii = 0;
 
-		foreach(Vertex v, mesh->vertices())
+		#pragma omp parallel for reduction(+:sumRadii)
+		for (int i = 0; i < nv; i++)
 		{
+			Vertex v(i);
 			KDResults matches;
 			mBallTree->k_closest(points[v], nbNeighbors, matches);
 			radii[v] = 2.0 * sqrt( pow(matches.back().second,2) / Scalar(nbNeighbors) );
-			mAveragePointSpacing += radii[v];
+			sumRadii += radii[v];
 		}
 
-		mAveragePointSpacing /= Scalar( mesh->n_vertices() );
+		mAveragePointSpacing = sumRadii / Scalar( nv );
 	}
 
 public:
@@ -275,49 +348,44 @@ public:
 	void setSigmaR(Scalar v)
 	{
 		mSigmaR = v;
-		mCachedQueryPointIsOK = false;
 	}
 
 	void setSigmaN(Scalar v)
 	{
 		mSigmaN = v;
-		mCachedQueryPointIsOK = false;
 	}
 
 	void setRefittingThreshold(Scalar v)
 	{
 		mRefittingThreshold = v;
-		mCachedQueryPointIsOK = false;
 	}
 
 	void setMinRefittingIters(int n)
 	{
 		mMinRefittingIters = n;
-		mCachedQueryPointIsOK = false;
 	}
 
 	void setMaxRefittingIters(int n)
 	{
 		mMaxRefittingIters = n;
-		mCachedQueryPointIsOK = false;
 	}
 
-	bool computePotentialAndGradient(const Vector3& x)
+	bool computePotentialAndGradient(const Vector3& x, RmlsWorkspace & ws) const
 	{
-		computeNeighborhood(x, true);
-		unsigned int nofSamples = mNeighborhood.size();
+		computeNeighborhood(x, ws, true);
+		unsigned int nofSamples = ws.neighborhood.size();
 
 		if (nofSamples < 1)
 		{
-			mCachedGradient = Vector3(0);
-			mCachedQueryPoint = x;
-			mCachedPotential  = 1e9;
-			mCachedQueryPointIsOK = false;
+			ws.gradient = Vector3(0);
+			ws.queryPoint = x;
+			ws.potential  = 1e9;
+			ws.isValid = false;
 			return false;
 		}
 
-		if (mCachedRefittingWeights.size() < nofSamples)
-			mCachedRefittingWeights.resize( nofSamples + 5 );
+		if (ws.refittingWeights.size() < nofSamples)
+			ws.refittingWeights.resize( nofSamples + 5 );
 
 		Vector3 source = x;
 		Vector3 grad(0);
@@ -344,7 +412,7 @@ public:
 
 			for (unsigned int i=0; i < nofSamples; i++)
 			{
-				int id = mNeighborhood[i].first;
+				int id = ws.neighborhood[i].first;
 				Vertex v(id);
 				Vector3 diff = source - points[v];
 				Vector3 normal = normals[v];
@@ -355,9 +423,9 @@ public:
 				{
 					refittingWeight = exp(-(normal - previousGrad).squaredNorm() * invSigma2);
 				}
-				mCachedRefittingWeights.at(i) = refittingWeight;
-				Scalar w = mCachedWeights.at(i) * refittingWeight;
-				Vector3 gw = mCachedWeightGradients.at(i) * refittingWeight;
+				ws.refittingWeights[i] = refittingWeight;
+				Scalar w = ws.weights[i] * refittingWeight;
+				Vector3 gw = ws.weightGradients[i] * refittingWeight;
 
 				sumGradWeight += gw;
 				sumGradWeightPotential += gw * f;
@@ -368,6 +436,7 @@ public:
 
 			if(sumW == 0.0)
 			{
+				ws.isValid = false;
 				return false;
 			}
 
@@ -379,29 +448,29 @@ public:
 		} while ( (iterationCount < mMinRefittingIters)
 			|| ( (grad - previousGrad).squaredNorm() > mRefittingThreshold && iterationCount < mMaxRefittingIters) );
 
-		mCachedGradient			= grad;
-		mCachedPotential		= potential;
-		mCachedQueryPoint		= x;
-		mCachedQueryPointIsOK	= true;
+		ws.gradient			= grad;
+		ws.potential		= potential;
+		ws.queryPoint		= x;
+		ws.isValid			= true;
 
-		mCachedSumGradWeight	= sumGradWeight;
-		mCachedSumN				= sumN;
-		mCachedSumW				= sumW;
-		mCachedSumGradPotential	= sumGradWeightPotential;
+		ws.sumGradWeight	= sumGradWeight;
+		ws.sumN				= sumN;
+		ws.sumW				= sumW;
+		ws.sumGradPotential	= sumGradWeightPotential;
 
 		return true;
 	}
 
 
-	bool mlsHessian(const Vector3& x, MatrixType& hessian)
+	bool mlsHessian(const Vector3& x, RmlsWorkspace & ws, MatrixType& hessian) const
 	{
-		this->requestSecondDerivatives();
+		this->requestSecondDerivatives(ws);
 		// at this point we assume computePotentialAndGradient has been called first
 
-		uint nofSamples = mNeighborhood.size();
+		uint nofSamples = ws.neighborhood.size();
 
-        const Vector3& sumGradWeight = mCachedSumGradWeight;
-		const Scalar& sumW = mCachedSumW;
+        const Vector3& sumGradWeight = ws.sumGradWeight;
+		const Scalar& sumW = ws.sumW;
 		const Scalar invW = 1.f/sumW;
 
 		for (uint k = 0; k < 3; ++k)
@@ -413,15 +482,15 @@ public:
 
 			for (unsigned int i=0; i<nofSamples; i++)
 			{
-				int id = mNeighborhood[i].first;
+				int id = ws.neighborhood[i].first;
 				Vertex v(id);
 				Vector3 p = points[v];
 				Vector3 diff = x - p;
 				Scalar f = dot(diff, normals[v]);
 
-				Vector3 gradW = mCachedWeightGradients.at(i) * mCachedRefittingWeights.at(i);
-				Vector3 dGradW = (x-p) * ( mCachedWeightSecondDerivatives.at(i) * (x[k]-p[k]) * mCachedRefittingWeights.at(i));
-				dGradW[k] += mCachedWeightDerivatives.at(i);
+				Vector3 gradW = ws.weightGradients[i] * ws.refittingWeights[i];
+				Vector3 dGradW = (x-p) * ( ws.weightSecondDerivatives[i] * (x[k]-p[k]) * ws.refittingWeights[i]);
+				dGradW[k] += ws.weightDerivatives[i];
 
 				sumDGradWeight += dGradW;
 				sumDWeightNormal += normals[v] * gradW[k];
@@ -431,9 +500,9 @@ public:
 
 			Vector3 dGrad = (
 				sumDWeightNormal + sumGradWeightNk + sumDGradWeightPotential
-				- sumDGradWeight * mCachedPotential
-				- sumGradWeight * mCachedGradient[k]
-			- mCachedGradient * sumGradWeight[k] ) * invW;
+				- sumDGradWeight * ws.potential
+				- sumGradWeight * ws.gradient[k]
+			- ws.gradient * sumGradWeight[k] ) * invW;
 
 			hessian.col(k) = V2E(dGrad);
 		}
@@ -443,68 +512,72 @@ public:
 
 protected:
 
-	void computeNeighborhood(const Vector3& x, bool computeDerivatives)
+	void computeNeighborhood(const Vector3& x, RmlsWorkspace & ws, bool computeDerivatives) const
 	{
 		// Find corresponding vertex
 		KDResults match;
 		mBallTree->ball_search(x, mAveragePointSpacing, match);
 
 		// Find neighborhood
+		ws.isValid = false;
+		ws.neighborhood.clear();
+		if (match.empty()) return;
+
 		double r = radii[Vertex(match.front().first)] * mFilterScale;
-		mBallTree->ball_search(x, r, mNeighborhood);
+		mBallTree->ball_search(x, r, ws.neighborhood);
 
-		size_t nofSamples = mNeighborhood.size();
+		size_t nofSamples = ws.neighborhood.size();
 
 		// compute spatial weights and partial derivatives
-		mCachedWeights.resize(nofSamples);
+		ws.weights.resize(nofSamples);
 		if (computeDerivatives)
 		{
-			mCachedWeightDerivatives.resize(nofSamples);
-			mCachedWeightGradients.resize(nofSamples);
+			ws.weightDerivatives.resize(nofSamples);
+			ws.weightGradients.resize(nofSamples);
 		}
 		else
-			mCachedWeightGradients.clear();
+			ws.weightGradients.clear();
 
 		for (size_t i = 0; i < nofSamples; i++)
 		{
-			int id = mNeighborhood[i].first;
+			int id = ws.neighborhood[i].first;
 			Vertex v(id);
 			Scalar s = 1.0 / (radii[v] * mFilterScale);
 			s = s*s;
-			Scalar w = Scalar(1) - pow(mNeighborhood[i].second, 2) * s;
+			Scalar w = Scalar(1) - pow(ws.neighborhood[i].second, 2) * s;
 			if (w<0)
 				w = 0;
 			Scalar aux = w;
 			w = w * w;
 			w = w * w;
-			mCachedWeights[i] = w;
+			ws.weights[i] = w;
 
 			if (computeDerivatives)
 			{
-				mCachedWeightDerivatives[i] = (-2. * s) * (4. * aux * aux * aux);
-				mCachedWeightGradients[i]  = (x - points[v]) * mCachedWeightDerivatives[i];
+				ws.weightDerivatives[i] = (-2. * s) * (4. * aux * aux * aux);
+				ws.weightGradients[i]  = (x - points[v]) * ws.weightDerivatives[i];
 			}
 		}
 	}
 
-	void requestSecondDerivatives()
+	void requestSecondDerivatives(RmlsWorkspace & ws) const
 	{
-		size_t nofSamples = mNeighborhood.size();
+		size_t nofSamples = ws.neighborhood.size();
 
-		if (nofSamples > mCachedWeightSecondDerivatives.size())
-			mCachedWeightSecondDerivatives.resize(nofSamples + 10);
+		if (nofSamples > ws.weightSecondDerivatives.size())
+			ws.weightSecondDerivatives.resize(nofSamples + 10);
 
 		{
 			for (size_t i=0 ; i < nofSamples ; ++i)
 			{
-				int id = mNeighborhood[i].first;
+				int id = ws.neighborhood[i].first;
 				Scalar s = 1.0 / (radii[Vertex(id)]*mFilterScale);
 				s = s*s;
-				Scalar x2 = s * pow(mNeighborhood[i].second, 2);
+				Scalar x2 = s * pow(ws.neighborhood[i].second, 2);
 				x2 = 1.0 - x2;
 				if (x2 < 0)
 					x2 = 0.;
-				mCachedWeightSecondDerivatives[i] = (4.0*s*s) * (12.0 * x2 * x2);
+				ws.weightSecondDerivatives[i] = (4.0*s*s) * (12.0 * x2 * x2);
 			}
 		}
 	}
@@ -516,6 +589,7 @@ protected:
 	int mGradientHint;
 	int mHessianHint;
 
+	// Shared by all queries, never modified after construction
 	NanoKdTree * mBallTree;
 
 	int mMaxNofProjectionIterations;
@@ -527,29 +601,10 @@ protected:
 	float mDomainRadiusScale;
 	float mDomainNormalScale;
 
-	// cached values:
-	bool mCachedQueryPointIsOK;
-	Vector3 mCachedQueryPoint;
-	KDResults mNeighborhood;
-	std::vector<Scalar> mCachedWeights;
-	std::vector<Scalar> mCachedWeightDerivatives;
-	std::vector<Vector3> mCachedWeightGradients;
-	std::vector<Scalar> mCachedWeightSecondDerivatives;
-
 	// RIMLS specific
 	int mMinRefittingIters;
 	int mMaxRefittingIters;
 	Scalar mRefittingThreshold;
 	Scalar mSigmaN;
 	Scalar mSigmaR;
-
-	// cached values:
-	Vector3 mCachedGradient;
-	Scalar mCachedPotential;
-
-	Scalar mCachedSumW;
-	std::vector<Scalar> mCachedRefittingWeights;;
-	Vector3 mCachedSumN;
-	Vector3 mCachedSumGradWeight;
-	Vector3 mCachedSumGradPotential;
 };
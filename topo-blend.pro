@@ -22,6 +22,7 @@ SUBDIRS += nurbs_plugin
 
 SUBDIRS += demo         # Standalone demo
 SUBDIRS += topo-blend   # Main plugin for topo-blending
+SUBDIRS += blend-batch  # Headless batch blending and benchmarks
 
 #SUBDIRS += test        # Performance test
 
@@ -19,10 +19,9 @@ void GraphsManager::loadModel()
     QFileInfo fileInfo(fileNames.front());
     tb->mainWindow()->settings()->set( "lastUsedDirectory", fileInfo.absolutePath() );
 
-    foreach(QString file, fileNames)
-    {
-        tb->graphs.push_back( new Structure::Graph ( file ) );
-    }
+    // Part meshes of all selected files are read together
+    foreach(Structure::Graph * g, Structure::Graph::loadGraphs( fileNames ))
+        tb->graphs.push_back( g );
 
     tb->mainWindow()->setStatusBarMessage( "Loaded: \n" + fileNames.join("\n") );
 
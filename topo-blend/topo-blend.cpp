@@ -842,6 +842,7 @@ void topoblend::doBlend()
 	c_manager->exitCorrespondenceMode(true);
 
 	scheduler = new Scheduler( );
+	scheduler->property["trackRelink"] = true; // for relink visualization
 	if(s_manager) s_manager->scheduler = scheduler;
 
     blender = new TopoBlender( gcoor, scheduler );
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include "SurfaceMeshHelper.h"
+
+// Triangle BVH for occlusion queries. Traversal stops at the first hit found,
+// hits are never sorted or returned
+struct RayBVH{
+	struct BVHNode{
+		Eigen::Vector3d bmin, bmax;
+		int left, right;	// children, -1 for leaves
+		int first, count;	// triangle range of leaves
+		int axis;			// split axis
+	};
+
+	// Per triangle: first corner and the two edges from it
+	std::vector<Eigen::Vector3d> v0, e1, e2;
+	std::vector<BVHNode> nodes;
+
+	struct CentroidLess{
+		const std::vector<Eigen::Vector3d> * centroids; int axis;
+		bool operator()( int a, int b ) const { return (*centroids)[a][axis] < (*centroids)[b][axis]; }
+	};
+
+	RayBVH( SurfaceMeshModel * m )
+	{
+		Vector3VertexProperty pts = m->vertex_property<Vector3>( VPOINT );
+
+		std::vector<Eigen::Vector3d> tris;
+
+		// Fan triangulation, degenerate triangles are left out
+		foreach(Face f, m->faces())
+		{
+			std::vector<Eigen::Vector3d> poly;
+			SurfaceMeshModel::Vertex_around_face_circulator vit = m->vertices(f), vend = vit;
+			do{ poly.push_back( pts[vit] ); } while(++vit != vend);
+
+			for(int i = 1; i + 1 < (int)poly.size(); i++)
+			{
+				if( (poly[i] - poly[0]).cross(poly[i+1] - poly[0]).squaredNorm() < FLT_MIN ) continue;
+				tris.push_back(poly[0]); tris.push_back(poly[i]); tris.push_back(poly[i+1]);
+			}
+		}
+
+		int N = tris.size() / 3;
+		std::vector<Eigen::Vector3d> centroids( N );
+		std::vector<int> order( N );
+		for(int i = 0; i < N; i++){
+			centroids[i] = (tris[i*3] + tris[i*3+1] + tris[i*3+2]) / 3.0;
+			order[i] = i;
+		}
+
+		if( N ) buildNode(0, N, order, centroids, tris);
+
+		// Store triangles in leaf order
+		v0.resize( N ); e1.resize( N ); e2.resize( N );
+		for(int i = 0; i < N; i++){
+			const Eigen::Vector3d * t = &tris[order[i]*3];
+			v0[i] = t[0]; e1[i] = t[1] - t[0]; e2[i] = t[2] - t[0];
+		}
+	}
+
+	int buildNode( int first, int count, std::vector<int> & order, const std::vector<Eigen::Vector3d> & centroids, const std::vector<Eigen::Vector3d> & tris )
+	{
+		int idx = nodes.size();
+		nodes.push_back( BVHNode() );
+
+		Eigen::Vector3d bmin(DBL_MAX, DBL_MAX, DBL_MAX), bmax(-DBL_MAX, -DBL_MAX, -DBL_MAX);
+		Eigen::Vector3d cmin = bmin, cmax = bmax;
+		for(int i = first; i < first + count; i++)
+		{
+			for(int k = 0; k < 3; k++){
+				bmin = bmin.cwiseMin( tris[order[i]*3+k] );
+				bmax = bmax.cwiseMax( tris[order[i]*3+k] );
+			}
+			cmin = cmin.cwiseMin( centroids[order[i]] );
+			cmax = cmax.cwiseMax( centroids[order[i]] );
+		}
+
+		nodes[idx].bmin = bmin; nodes[idx].bmax = bmax;
+		nodes[idx].left = nodes[idx].right = -1;
+		nodes[idx].first = first; nodes[idx].count = count;
+		nodes[idx].axis = 0;
+
+		if( count <= 4 ) return idx;
+
+		// Median split on the longest axis of the centroids
+		int axis = 0;
+		Eigen::Vector3d extent = cmax - cmin;
+		if( extent[1] > extent[axis] ) axis = 1;
+		if( extent[2] > extent[axis] ) axis = 2;
+
+		CentroidLess less; less.centroids = &centroids; less.axis = axis;
+		int half = count / 2;
+		std::nth_element( order.begin() + first, order.begin() + first + half, order.begin() + first + count, less );
+
+		int left = buildNode( first, half, order, centroids, tris );
+		int right = buildNode( first + half, count - half, order, centroids, tris );
+		nodes[idx].left = left;
+		nodes[idx].right = right;
+		nodes[idx].axis = axis;
+
+		return idx;
+	}
+
+	/// Any hit query, true when the ray hits some triangle in front of its origin
+	bool occluded( const Eigen::Vector3d & ro, const Eigen::Vector3d & rd ) const
+	{
+		if( nodes.empty() ) return false;
+
+		double inv[3];
+		for(int k = 0; k < 3; k++) inv[k] = std::abs(rd[k]) > 1e-30 ? 1.0 / rd[k] : (rd[k] < 0 ? -1e30 : 1e30);
+
+		int stack[128], top = 0;
+		stack[top++] = 0;
+
+		while( top )
+		{
+			const BVHNode & n = nodes[ stack[--top] ];
+
+			// Slab test
+			double tnear = 0, tfar = DBL_MAX;
+			for(int k = 0; k < 3; k++){
+				double t0 = (n.bmin[k] - ro[k]) * inv[k];
+				double t1 = (n.bmax[k] - ro[k]) * inv[k];
+				tnear = std::max(tnear, std::min(t0, t1));
+				tfar = std::min(tfar, std::max(t0, t1));
+			}
+			if( tnear > tfar ) continue;
+
+			if( n.left < 0 )
+			{
+				for(int i = n.first; i < n.first + n.count; i++)
+					if( hitTriangle(i, ro, rd) ) return true;
+				continue;
+			}
+
+			// Near child on top of the stack
+			int a = n.left, b = n.right;
+			if( rd[n.axis] < 0 ) std::swap(a, b);
+			stack[top++] = b;
+			stack[top++] = a;
+		}
+
+		return false;
+	}
+
+	/// Whether any ray leaving the offset point escapes. Rays on the side of the normal
+	/// are traced first since they are the likely ones, the rest only if all of those are blocked
+	bool anyEscapes( const Eigen::Vector3d & p, const Eigen::Vector3d & normal, const std::vector<Eigen::Vector3d> & dirs, double surfaceOffset ) const
+	{
+		for(int pass = 0; pass < 2; pass++)
+		{
+			for(int r = 0; r < (int)dirs.size(); r++)
+			{
+				if( (dirs[r].dot(normal) > 0) != (pass == 0) ) continue;
+				if( !occluded(p + dirs[r] * surfaceOffset, dirs[r]) ) return true;
+			}
+		}
+
+		return false;
+	}
+
+	// Moller-Trumbore, any hit in front of the origin
+	inline bool hitTriangle( int i, const Eigen::Vector3d & ro, const Eigen::Vector3d & rd ) const
+	{
+		Eigen::Vector3d pv = rd.cross(e2[i]);
+		double det = e1[i].dot(pv);
+		if( std::abs(det) < 1e-20 ) return false;
+
+		double invDet = 1.0 / det;
+		Eigen::Vector3d tv = ro - v0[i];
+		double u = tv.dot(pv) * invDet;
+		if( u < 0 || u > 1 ) return false;
+
+		Eigen::Vector3d qv = tv.cross(e1[i]);
+		double v = rd.dot(qv) * invDet;
+		if( v < 0 || u + v > 1 ) return false;
+
+		return e2[i].dot(qv) * invDet > 0;
+	}
+};
@@ -1,5 +1,5 @@
 #include "visiblity_resampler.h"
-#include "Octree.h"
+#include "RayBVH.h"
 #include "StarlabDrawArea.h"
 
 #include "../CustomDrawObjects.h"
@@ -7,26 +7,14 @@
 #include "../TopoBlenderLib/Sampler.cpp"
 #include "../TopoBlenderLib/SimilarSampling.h"
 #include "../TopoBlenderLib/SimilarSampling.cpp"
+#include "../TopoBlenderLib/ObjReader.h"
+#include "../TopoBlenderLib/ObjReader.cpp"
 
 // OpenMP
 #include <omp.h>
 
 #include "../NURBS/weld.h"
 
-void traverseOctree( Octree & octree, CubeSoup & cs )
-{
-	if( octree.children.empty() && !octree.triangleData.empty() )
-	{
-		cs.addCube( QVector3( octree.boundingBox.Center() ), octree.boundingBox.yExtent * 2 );
-		return;
-	}
-
-	foreach(Octree t, octree.children)
-	{
-		traverseOctree(t,cs);
-	}
-}
-
 void visiblity_resampler::initParameters(RichParameterSet *pars)
 {
 	pars->addParam(new RichBool("uniformSampling",true,"Uniform sampling"));
@@ -119,33 +107,10 @@ void visiblity_resampler::applyFilter(RichParameterSet *pars)
     else
     {
         // Tri soup only supported for '.obj' files
-        QFile file(mesh()->path);
-        if (mesh()->path.endsWith("obj") && file.open(QIODevice::ReadOnly | QIODevice::Text))
+        if ( ObjReader::isObj(mesh()->path) && QFile::exists(mesh()->path) )
         {
             meshUsed = new SurfaceMeshModel("tri_soup.obj", "tri_soup");
-            QVector<Vector3> realPoints;
-
-            QTextStream inF(&file);
-            while( !inF.atEnd() ){
-                QString line = inF.readLine();
-                if(!line.size()) continue;
-
-                if(line.at(0).toAscii() == 'v' && (line.at(1).toAscii() == ' ' || line.at(1).toAscii() == '\t'))
-                {
-                    QStringList v = line.simplified().split(" ", QString::SkipEmptyParts);
-                    realPoints.push_back( Vector3( v[1].toDouble(), v[2].toDouble(), v[3].toDouble() ) );
-                }
-
-                if(line.at(0).toAscii() == 'f')
-                {
-                    QStringList f = line.simplified().split(" ", QString::SkipEmptyParts);
-                    std::vector<SurfaceMesh::Vertex> verts;
-                    verts.push_back(meshUsed->add_vertex(realPoints[f[1].split("/", QString::SkipEmptyParts).front().toInt() - 1]));
-                    verts.push_back(meshUsed->add_vertex(realPoints[f[2].split("/", QString::SkipEmptyParts).front().toInt() - 1]));
-                    verts.push_back(meshUsed->add_vertex(realPoints[f[3].split("/", QString::SkipEmptyParts).front().toInt() - 1]));
-                    meshUsed->add_face(verts);
-                }
-            }
+            ObjReader::readSoup( meshUsed, mesh()->path );
 
 			meshUsed->updateBoundingBox();
 			meshUsed->update_face_normals();
@@ -156,7 +121,6 @@ void visiblity_resampler::applyFilter(RichParameterSet *pars)
         {
             meshUsed = mesh();
         }
-		file.close();
     }
 
     SurfaceMeshHelper h(meshUsed);
@@ -164,10 +128,9 @@ void visiblity_resampler::applyFilter(RichParameterSet *pars)
 
 	double surfaceOffset = 1e-6;
 
-    Octree octree(meshUsed);
+    RayBVH bvh(meshUsed);
 
 	std::vector<Vector3d> sphere = uniformSampleSphere( pars->getInt("sphereSamples") );
-	int rayCount = sphere.size();
 
 	std::vector<SamplePoint> all_samples;
 
@@ -202,26 +165,13 @@ void visiblity_resampler::applyFilter(RichParameterSet *pars)
 	}
 
 	int N = (int) all_samples.size();
-	std::vector<bool> isUse(N,false);
+	std::vector<char> isUse(N,false);
 
-	#pragma omp parallel for
+	// A sample is visible when any of its rays escapes
+	#pragma omp parallel for schedule(dynamic, 64)
 	for(int i = 0; i < N; i++)
 	{
-		const SamplePoint & sp = all_samples[i];
-
-		for(int r = 0; r < rayCount; r++)
-		{
-			const Eigen::Vector3d & d = sphere[r];
-
-			Eigen::Vector3d rayStart = sp.pos + (d * surfaceOffset);
-			Ray ray( rayStart, d );
-			
-            if(octree.intersectRay(ray,0,true).empty())
-			{
-				isUse[i] = true;
-				break;
-			}
-		}
+		isUse[i] = bvh.anyEscapes( all_samples[i].pos, all_samples[i].n, sphere, surfaceOffset );
 	}
 
 	document()->pushBusy();
@@ -1,7 +1,6 @@
 include($$[STARLAB])
 include($$[SURFACEMESH])
 include($$[NANOFLANN])
-include($$[OCTREE])
 StarlabTemplate(plugin)
 
 # Build flag
@@ -11,5 +10,6 @@ CONFIG(debug, debug|release) {
     CFG = release
 }
 
-HEADERS += visiblity_resampler.h
+HEADERS += visiblity_resampler.h \
+    RayBVH.h
 SOURCES += visiblity_resampler.cpp